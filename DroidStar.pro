@@ -83,7 +83,7 @@ SOURCES += \
         xrf.cpp \
         ysf.cpp
 android:SOURCES += androidserialport.cpp
-!ios:SOURCES += serialambe.cpp serialmodem.cpp
+!ios:SOURCES += serialambe.cpp serialmodem.cpp vocoderpool.cpp
 macx:OBJECTIVE_SOURCES += micpermission.mm
 ios:OBJECTIVE_SOURCES += micpermission.mm
 
@@ -112,6 +112,7 @@ HEADERS += \
 	M17Defines.h \
 	MMDVMDefines.h \
 	SHA256.h \
+	Viterbi.h \
 	YSFConvolution.h \
 	YSFFICH.h \
 	audioengine.h \
@@ -143,7 +144,6 @@ HEADERS += \
 	imbe_vocoder/pitch_est.h \
 	imbe_vocoder/pitch_ref.h \
 	imbe_vocoder/qnt_sub.h \
-	imbe_vocoder/rand_gen.h \
 	imbe_vocoder/sa_decode.h \
 	imbe_vocoder/sa_encode.h \
 	imbe_vocoder/sa_enh.h \
@@ -189,6 +189,8 @@ LIBS += -lcodec2
 HEADERS += \
 	mbe/ambe3600x2400_const.h \
 	mbe/ambe3600x2450_const.h \
+	mbe/ambe_framing.h \
+	mbe/ambe_quant.h \
 	mbe/ecc_const.h \
 	mbe/mbelib.h \
 	mbe/mbelib_const.h \
@@ -199,14 +201,17 @@ HEADERS += \
 SOURCES += \
 	mbe/ambe3600x2400.c \
 	mbe/ambe3600x2450.c \
+	mbe/ambe_framing.cpp \
+	mbe/ambe_quant.cpp \
 	mbe/ecc.c \
 	mbe/mbelib.c \
+	mbe/mbe_synth.c \
 	mbe/vocoder_plugin.cpp
 }
 
 android:HEADERS += androidserialport.h
 macx:HEADERS += micpermission.h
-!ios:HEADERS += serialambe.h serialmodem.h
+!ios:HEADERS += serialambe.h serialmodem.h vocoderpool.h
 android:ANDROID_VERSION_CODE = 79
 #android:QT_ANDROID_MIN_SDK_VERSION = 31
 
@@ -1039,34 +1039,37 @@ static const uint32_t DECODING_TABLE_23127[] = {
 	0x403000U, 0x080840U, 0x100044U, 0x011008U, 0x022800U, 0x004110U, 0x100040U, 0x100041U, 0x100042U, 0x440020U, 
 	0x011001U, 0x011000U, 0x080420U, 0x011002U, 0x100048U, 0x011004U, 0x204200U, 0x028080U};
 
-#define X22             0x00400000   /* vector representation of X^{22} */
-#define X11             0x00000800   /* vector representation of X^{11} */
-#define MASK12          0xfffff800   /* auxiliary vector for testing */
-#define GENPOL          0x00000c75   /* generator polinomial, g(x) */
+static const uint16_t SYNDROME_TABLE_23127_LO[] = {
+	0x000U, 0x475U, 0x49FU, 0x0EAU, 0x54BU, 0x13EU, 0x1D4U, 0x5A1U,
+	0x6E3U, 0x296U, 0x27CU, 0x609U, 0x3A8U, 0x7DDU, 0x737U, 0x342U,
+	0x1B3U, 0x5C6U, 0x52CU, 0x159U, 0x4F8U, 0x08DU, 0x067U, 0x412U,
+	0x750U, 0x325U, 0x3CFU, 0x7BAU, 0x21BU, 0x66EU, 0x684U, 0x2F1U,
+	0x366U, 0x713U, 0x7F9U, 0x38CU, 0x62DU, 0x258U, 0x2B2U, 0x6C7U,
+	0x585U, 0x1F0U, 0x11AU, 0x56FU, 0x0CEU, 0x4BBU, 0x451U, 0x024U,
+	0x2D5U, 0x6A0U, 0x64AU, 0x23FU, 0x79EU, 0x3EBU, 0x301U, 0x774U,
+	0x436U, 0x043U, 0x0A9U, 0x4DCU, 0x17DU, 0x508U, 0x5E2U, 0x197U};
 
-static uint32_t get_syndrome_23127(uint32_t pattern)
+static const uint16_t SYNDROME_TABLE_23127_HI[] = {
+	0x000U, 0x6CCU, 0x1EDU, 0x721U, 0x3DAU, 0x516U, 0x237U, 0x4FBU,
+	0x7B4U, 0x178U, 0x659U, 0x095U, 0x46EU, 0x2A2U, 0x583U, 0x34FU,
+	0x31DU, 0x5D1U, 0x2F0U, 0x43CU, 0x0C7U, 0x60BU, 0x12AU, 0x7E6U,
+	0x4A9U, 0x265U, 0x544U, 0x388U, 0x773U, 0x1BFU, 0x69EU, 0x052U,
+	0x63AU, 0x0F6U, 0x7D7U, 0x11BU, 0x5E0U, 0x32CU, 0x40DU, 0x2C1U,
+	0x18EU, 0x742U, 0x063U, 0x6AFU, 0x254U, 0x498U, 0x3B9U, 0x575U,
+	0x527U, 0x3EBU, 0x4CAU, 0x206U, 0x6FDU, 0x031U, 0x710U, 0x1DCU,
+	0x293U, 0x45FU, 0x37EU, 0x5B2U, 0x149U, 0x785U, 0x0A4U, 0x668U};
+
+static inline uint32_t get_syndrome_23127(uint32_t pattern)
 /*
  * Compute the syndrome corresponding to the given pattern, i.e., the
  * remainder after dividing the pattern (when considering it as the vector
- * representation of a polynomial) by the generator polynomial, GENPOL.
- * In the program this pattern has several meanings: (1) pattern = infomation
- * bits, when constructing the encoding table; (2) pattern = error pattern,
- * when constructing the decoding table; and (3) pattern = received vector, to
- * obtain its syndrome in decoding.
+ * representation of a polynomial) by the generator polynomial, g(x) = 0xc75.
+ * The remainder is linear in the pattern, so the eleven low bits are their
+ * own remainder and the twelve high bits are looked up six at a time, with
+ * no branches or data dependent loops.
  */
 {
-	uint32_t aux = X22;
- 
-	if (pattern >= X11) {
-		while (pattern & MASK12) {
-			while (!(aux & pattern))
-				aux = aux >> 1;
-
-			pattern ^= (aux / X11) * GENPOL;
-		}
-	}
-
-	return pattern;
+	return (pattern & 0x7FFU) ^ SYNDROME_TABLE_23127_LO[(pattern >> 11) & 0x3FU] ^ SYNDROME_TABLE_23127_HI[(pattern >> 17) & 0x3FU];
 }
 
 uint32_t CGolay24128::encode23127(uint32_t data)
@@ -1130,14 +1133,35 @@ bool CGolay24128::decode24128(uint8_t* in, uint32_t& out)
 	return decode24128(code, out);
 }
 
-uint32_t CGolay24128::countBits(uint32_t v)
+size_t CGolay24128::decode24128(const uint32_t* in, uint32_t* out, size_t n, uint8_t* errs)
 {
-	uint32_t count = 0U;
+	assert(in != NULL);
+	assert(out != NULL);
+
+	size_t invalid = 0U;
 
-	while (v != 0U) {
-		v &= v - 1U;
-		count++;
+	for (size_t i = 0U; i < n; i++) {
+		uint32_t syndrome = ::get_syndrome_23127((in[i] >> 1) & 0x7FFFFFU);
+		uint32_t error_pattern = DECODING_TABLE_23127[syndrome] << 1;
+		uint32_t code = in[i] ^ error_pattern;
+		uint32_t parity = countBits(code & 0xFFFFFFU) & 1U;
+
+		invalid += (countBits(syndrome) >= 3U) && parity;
+		out[i] = (code >> 12) & 0xFFFU;
+
+		// A corrected word with odd parity had its parity bit flipped too
+		if (errs != NULL)
+			errs[i] = uint8_t(countBits(error_pattern) + parity);
 	}
 
-	return count;
+	return invalid;
+}
+
+uint32_t CGolay24128::countBits(uint32_t v)
+{
+	v = v - ((v >> 1) & 0x55555555U);
+	v = (v & 0x33333333U) + ((v >> 2) & 0x33333333U);
+	v = (v + (v >> 4)) & 0x0F0F0F0FU;
+
+	return (v * 0x01010101U) >> 24;
 }
@@ -19,6 +19,7 @@
 #ifndef Golay24128_H
 #define Golay24128_H
 #include <cstdint>
+#include <cstddef>
 
 class CGolay24128 {
 public:
@@ -30,6 +31,10 @@ public:
 	static uint32_t decode24128(uint8_t* bytes);
 	static bool decode24128(uint32_t in, uint32_t& out);
 	static bool decode24128(uint8_t* in, uint32_t& out);
+	// Decodes n 24 bit words into their 12 data bits, stores the number of
+	// corrected bits per word in errs (if not NULL) and returns the number
+	// of words that failed the same check as decode24128(in, out).
+	static size_t decode24128(const uint32_t* in, uint32_t* out, size_t n, uint8_t* errs);
 	static uint32_t countBits(uint32_t v);
 };
 
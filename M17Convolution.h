@@ -19,6 +19,8 @@
 #if !defined(M17Convolution_H)
 #define  M17Convolution_H
 
+#include "Viterbi.h"
+
 #include <cstdint>
 
 class CM17Convolution {
@@ -33,19 +35,8 @@ public:
 	void encodeData(const uint8_t* in, uint8_t* out) const;
 
 private:
-	uint16_t* m_metrics1;
-	uint16_t* m_metrics2;
-	uint16_t* m_oldMetrics;
-	uint16_t* m_newMetrics;
-	uint64_t* m_decisions;
-	uint64_t* m_dp;
-
-	void start();
-	void decode(uint8_t s0, uint8_t s1);
-
-	unsigned int chainback(uint8_t* out, uint32_t nBits);
-
-	void encode(const uint8_t* in, uint8_t* out, uint32_t nBits) const;
+	// Soft symbols, 0, 1 for a punctured bit, or 2
+	CViterbi<5U, 0x19U, 0x17U, 2U, 244U> m_viterbi;
 };
 
 #endif
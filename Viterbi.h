@@ -0,0 +1,381 @@
+/*
+ *   Copyright (C) 2015,2016,2020,2021 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(Viterbi_H)
+#define  Viterbi_H
+
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VITERBI_SSE2
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define VITERBI_AVX2
+#endif
+
+// Viterbi decoder for rate 1/2 convolutional codes. K is the constraint
+// length, POLY1 and POLY2 the generator polynomials with the newest input bit
+// in bit 0. A received one is the symbol value L, a zero 0 and an erased
+// (punctured) symbol L / 2. Frames of up to MAX_STEPS symbol pairs.
+//
+// The add-compare-select runs 8 butterflies per SSE2 operation. decodeFrames()
+// decodes two frames side by side, one in each half of the AVX2 registers,
+// when the CPU has AVX2.
+template <uint32_t K, uint32_t POLY1, uint32_t POLY2, uint32_t L, uint32_t MAX_STEPS>
+class CViterbi {
+public:
+	CViterbi();
+
+	void start();
+	void decode(uint8_t s0, uint8_t s1);
+	void decode(const uint8_t* symbols, uint32_t nSteps);
+
+	// Returns the path metric of the best state, in bit errors
+	uint32_t chainback(uint8_t* out, uint32_t nBits);
+
+	// Decodes nFrames frames of nSteps symbol pairs each, the frames follow
+	// each other in symbols and out. errors, if not NULL, gets the chainback()
+	// result of every frame.
+	void decodeFrames(const uint8_t* symbols, uint32_t nSteps, uint32_t nFrames, uint8_t* out, uint32_t nBits, uint32_t* errors);
+
+	static void encode(const uint8_t* in, uint8_t* out, uint32_t nBits);
+
+private:
+	static const uint32_t NUM_OF_STATES = 1U << (K - 1U);
+	static const uint32_t NUM_OF_STATES_D2 = NUM_OF_STATES / 2U;
+	static const uint32_t M = 2U * L;
+
+	static_assert(K >= 3U && K <= 7U, "the decisions of a step must fit in 64 bits");
+	static_assert(MAX_STEPS * M < 32768U, "the path metrics must fit in 16 bits");
+
+	// Two lanes of metrics and decisions, the second is only used by decodeFrames()
+	alignas(32) int16_t m_metrics[2U][2U][NUM_OF_STATES];
+	alignas(16) int16_t m_branch1[NUM_OF_STATES_D2];
+	alignas(16) int16_t m_branch2[NUM_OF_STATES_D2];
+	uint64_t m_decisions[2U][MAX_STEPS];
+	uint32_t m_cur;
+	uint32_t m_steps;
+
+	static uint32_t parity(uint32_t v);
+
+	void step(uint32_t lane, uint8_t s0, uint8_t s1);
+	uint32_t chainback(uint32_t lane, uint8_t* out, uint32_t nBits) const;
+
+#if defined(VITERBI_AVX2)
+	static bool hasAVX2();
+	void step2(uint8_t s0a, uint8_t s1a, uint8_t s0b, uint8_t s1b);
+#endif
+};
+
+template <uint32_t K, uint32_t POLY1, uint32_t POLY2, uint32_t L, uint32_t MAX_STEPS>
+CViterbi<K, POLY1, POLY2, L, MAX_STEPS>::CViterbi() :
+m_cur(0U),
+m_steps(0U)
+{
+	// The expected symbols of butterfly i, as all ones or all zeros lane masks
+	for (uint32_t i = 0U; i < NUM_OF_STATES_D2; i++) {
+		m_branch1[i] = parity((2U * i) & POLY1) ? -1 : 0;
+		m_branch2[i] = parity((2U * i) & POLY2) ? -1 : 0;
+	}
+
+	start();
+}
+
+template <uint32_t K, uint32_t POLY1, uint32_t POLY2, uint32_t L, uint32_t MAX_STEPS>
+void CViterbi<K, POLY1, POLY2, L, MAX_STEPS>::start()
+{
+	::memset(m_metrics, 0x00U, sizeof(m_metrics));
+
+	m_cur = 0U;
+	m_steps = 0U;
+}
+
+template <uint32_t K, uint32_t POLY1, uint32_t POLY2, uint32_t L, uint32_t MAX_STEPS>
+void CViterbi<K, POLY1, POLY2, L, MAX_STEPS>::decode(uint8_t s0, uint8_t s1)
+{
+	assert(m_steps < MAX_STEPS);
+	assert(s0 <= L && s1 <= L);
+
+	step(0U, s0, s1);
+
+	m_cur ^= 1U;
+	m_steps++;
+}
+
+template <uint32_t K, uint32_t POLY1, uint32_t POLY2, uint32_t L, uint32_t MAX_STEPS>
+void CViterbi<K, POLY1, POLY2, L, MAX_STEPS>::decode(const uint8_t* symbols, uint32_t nSteps)
+{
+	assert(symbols != NULL);
+
+	for (uint32_t i = 0U; i < nSteps; i++, symbols += 2U)
+		decode(symbols[0U], symbols[1U]);
+}
+
+template <uint32_t K, uint32_t POLY1, uint32_t POLY2, uint32_t L, uint32_t MAX_STEPS>
+uint32_t CViterbi<K, POLY1, POLY2, L, MAX_STEPS>::chainback(uint8_t* out, uint32_t nBits)
+{
+	return chainback(0U, out, nBits);
+}
+
+template <uint32_t K, uint32_t POLY1, uint32_t POLY2, uint32_t L, uint32_t MAX_STEPS>
+void CViterbi<K, POLY1, POLY2, L, MAX_STEPS>::decodeFrames(const uint8_t* symbols, uint32_t nSteps, uint32_t nFrames, uint8_t* out, uint32_t nBits, uint32_t* errors)
+{
+	assert(symbols != NULL);
+	assert(out != NULL);
+	assert(nSteps <= MAX_STEPS);
+
+	const uint32_t inLen = 2U * nSteps;
+	const uint32_t outLen = (nBits + 7U) / 8U;
+
+	uint32_t f = 0U;
+#if defined(VITERBI_AVX2)
+	if (NUM_OF_STATES_D2 % 8U == 0U && hasAVX2()) {
+		for (; (f + 1U) < nFrames; f += 2U) {
+			const uint8_t* a = symbols + f * inLen;
+			const uint8_t* b = a + inLen;
+
+			start();
+			for (uint32_t i = 0U; i < nSteps; i++, a += 2U, b += 2U) {
+				step2(a[0U], a[1U], b[0U], b[1U]);
+				m_cur ^= 1U;
+				m_steps++;
+			}
+
+			uint32_t e0 = chainback(0U, out + f * outLen, nBits);
+			uint32_t e1 = chainback(1U, out + (f + 1U) * outLen, nBits);
+			if (errors != NULL) {
+				errors[f] = e0;
+				errors[f + 1U] = e1;
+			}
+		}
+	}
+#endif
+
+	for (; f < nFrames; f++) {
+		start();
+		decode(symbols + f * inLen, nSteps);
+
+		uint32_t e = chainback(0U, out + f * outLen, nBits);
+		if (errors != NULL)
+			errors[f] = e;
+	}
+}
+
+template <uint32_t K, uint32_t POLY1, uint32_t POLY2, uint32_t L, uint32_t MAX_STEPS>
+void CViterbi<K, POLY1, POLY2, L, MAX_STEPS>::encode(const uint8_t* in, uint8_t* out, uint32_t nBits)
+{
+	assert(in != NULL);
+	assert(out != NULL);
+	assert(nBits > 0U);
+
+	uint32_t sr = 0U;
+	uint32_t k = 0U;
+	for (uint32_t i = 0U; i < nBits; i++) {
+		sr = (sr << 1) | ((in[i >> 3] >> (7U - (i & 7U))) & 0x01U);
+
+		uint32_t g[2U] = {parity(sr & POLY1), parity(sr & POLY2)};
+		for (uint32_t j = 0U; j < 2U; j++, k++) {
+			uint8_t mask = 0x80U >> (k & 7U);
+			out[k >> 3] = g[j] ? (out[k >> 3] | mask) : (out[k >> 3] & ~mask);
+		}
+	}
+}
+
+template <uint32_t K, uint32_t POLY1, uint32_t POLY2, uint32_t L, uint32_t MAX_STEPS>
+uint32_t CViterbi<K, POLY1, POLY2, L, MAX_STEPS>::parity(uint32_t v)
+{
+	v ^= v >> 16;
+	v ^= v >> 8;
+	v ^= v >> 4;
+
+	return (0x6996U >> (v & 0x0FU)) & 1U;
+}
+
+// One add-compare-select step, new state 2i and 2i + 1 come from old state i
+// or i + NUM_OF_STATES_D2, the decision bit is set when it is the latter
+template <uint32_t K, uint32_t POLY1, uint32_t POLY2, uint32_t L, uint32_t MAX_STEPS>
+void CViterbi<K, POLY1, POLY2, L, MAX_STEPS>::step(uint32_t lane, uint8_t s0, uint8_t s1)
+{
+	const int16_t* oldMetrics = m_metrics[lane][m_cur];
+	int16_t* newMetrics = m_metrics[lane][m_cur ^ 1U];
+	uint64_t decisions = 0U;
+
+#if defined(VITERBI_SSE2)
+	if (NUM_OF_STATES_D2 % 8U == 0U) {
+		const __m128i m    = _mm_set1_epi16(M);
+		const __m128i sym0 = _mm_set1_epi16(s0);
+		const __m128i inv0 = _mm_set1_epi16(L - s0);
+		const __m128i sym1 = _mm_set1_epi16(s1);
+		const __m128i inv1 = _mm_set1_epi16(L - s1);
+
+		for (uint32_t i = 0U; i < NUM_OF_STATES_D2; i += 8U) {
+			const __m128i b1 = _mm_load_si128((const __m128i*)(m_branch1 + i));
+			const __m128i b2 = _mm_load_si128((const __m128i*)(m_branch2 + i));
+			const __m128i lo = _mm_load_si128((const __m128i*)(oldMetrics + i));
+			const __m128i hi = _mm_load_si128((const __m128i*)(oldMetrics + i + NUM_OF_STATES_D2));
+
+			const __m128i metric = _mm_add_epi16(_mm_or_si128(_mm_and_si128(b1, inv0), _mm_andnot_si128(b1, sym0)),
+			                                     _mm_or_si128(_mm_and_si128(b2, inv1), _mm_andnot_si128(b2, sym1)));
+			const __m128i other = _mm_sub_epi16(m, metric);
+
+			const __m128i m0 = _mm_add_epi16(lo, metric);
+			const __m128i m1 = _mm_add_epi16(hi, other);
+			const __m128i m2 = _mm_add_epi16(lo, other);
+			const __m128i m3 = _mm_add_epi16(hi, metric);
+
+			const __m128i n0 = _mm_min_epi16(m0, m1);
+			const __m128i n1 = _mm_min_epi16(m2, m3);
+			_mm_store_si128((__m128i*)(newMetrics + 2U * i), _mm_unpacklo_epi16(n0, n1));
+			_mm_store_si128((__m128i*)(newMetrics + 2U * i + 8U), _mm_unpackhi_epi16(n0, n1));
+
+			// The lower path is kept only when it is strictly better
+			const __m128i d0 = _mm_cmpgt_epi16(m1, m0);
+			const __m128i d1 = _mm_cmpgt_epi16(m3, m2);
+			uint32_t keep = _mm_movemask_epi8(_mm_packs_epi16(_mm_unpacklo_epi16(d0, d1), _mm_unpackhi_epi16(d0, d1)));
+			decisions |= uint64_t(~keep & 0xFFFFU) << (2U * i);
+		}
+
+		m_decisions[lane][m_steps] = decisions;
+		return;
+	}
+#endif
+
+	for (uint32_t i = 0U; i < NUM_OF_STATES_D2; i++) {
+		uint32_t j = i * 2U;
+
+		int16_t metric = (m_branch1[i] ? (L - s0) : s0) + (m_branch2[i] ? (L - s1) : s1);
+
+		int16_t m0 = oldMetrics[i] + metric;
+		int16_t m1 = oldMetrics[i + NUM_OF_STATES_D2] + (M - metric);
+		uint8_t decision0 = (m0 >= m1) ? 1U : 0U;
+		newMetrics[j + 0U] = decision0 != 0U ? m1 : m0;
+
+		m0 = oldMetrics[i] + (M - metric);
+		m1 = oldMetrics[i + NUM_OF_STATES_D2] + metric;
+		uint8_t decision1 = (m0 >= m1) ? 1U : 0U;
+		newMetrics[j + 1U] = decision1 != 0U ? m1 : m0;
+
+		decisions |= (uint64_t(decision1) << (j + 1U)) | (uint64_t(decision0) << (j + 0U));
+	}
+
+	m_decisions[lane][m_steps] = decisions;
+}
+
+template <uint32_t K, uint32_t POLY1, uint32_t POLY2, uint32_t L, uint32_t MAX_STEPS>
+uint32_t CViterbi<K, POLY1, POLY2, L, MAX_STEPS>::chainback(uint32_t lane, uint8_t* out, uint32_t nBits) const
+{
+	assert(out != NULL);
+	assert(nBits <= m_steps);
+
+	const uint64_t* dp = m_decisions[lane] + m_steps;
+	uint32_t state = 0U;
+
+	while (nBits-- > 0) {
+		--dp;
+
+		uint32_t  i = state >> (9 - K);
+		uint8_t bit = uint8_t(*dp >> i) & 1;
+		state = (bit << 7) | (state >> 1);
+
+		uint8_t mask = 0x80U >> (nBits & 7U);
+		out[nBits >> 3] = bit ? (out[nBits >> 3] | mask) : (out[nBits >> 3] & ~mask);
+	}
+
+	const int16_t* metrics = m_metrics[lane][m_cur];
+	int16_t minCost = metrics[0];
+
+	for (uint32_t i = 0U; i < NUM_OF_STATES; i++) {
+		if (metrics[i] < minCost)
+			minCost = metrics[i];
+	}
+
+	return uint32_t(minCost) / L;
+}
+
+#if defined(VITERBI_AVX2)
+template <uint32_t K, uint32_t POLY1, uint32_t POLY2, uint32_t L, uint32_t MAX_STEPS>
+bool CViterbi<K, POLY1, POLY2, L, MAX_STEPS>::hasAVX2()
+{
+	static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2") != 0);
+
+	return avx2;
+}
+
+// step() of both lanes at once, lane 0 in the low and lane 1 in the high
+// 128 bits of every register. The unpacks and the pack work within each half,
+// so every half is the SSE2 step of its own lane.
+template <uint32_t K, uint32_t POLY1, uint32_t POLY2, uint32_t L, uint32_t MAX_STEPS>
+__attribute__((target("avx2")))
+void CViterbi<K, POLY1, POLY2, L, MAX_STEPS>::step2(uint8_t s0a, uint8_t s1a, uint8_t s0b, uint8_t s1b)
+{
+	const int16_t* oldA = m_metrics[0U][m_cur];
+	const int16_t* oldB = m_metrics[1U][m_cur];
+	int16_t* newA = m_metrics[0U][m_cur ^ 1U];
+	int16_t* newB = m_metrics[1U][m_cur ^ 1U];
+	uint64_t decisionsA = 0U;
+	uint64_t decisionsB = 0U;
+
+	const __m256i m    = _mm256_set1_epi16(M);
+	const __m256i sym0 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi16(s0a)), _mm_set1_epi16(s0b), 1);
+	const __m256i inv0 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi16(L - s0a)), _mm_set1_epi16(L - s0b), 1);
+	const __m256i sym1 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi16(s1a)), _mm_set1_epi16(s1b), 1);
+	const __m256i inv1 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi16(L - s1a)), _mm_set1_epi16(L - s1b), 1);
+
+	for (uint32_t i = 0U; i < NUM_OF_STATES_D2; i += 8U) {
+		const __m256i b1 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)(m_branch1 + i)));
+		const __m256i b2 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)(m_branch2 + i)));
+		const __m256i lo = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_load_si128((const __m128i*)(oldA + i))),
+		                                           _mm_load_si128((const __m128i*)(oldB + i)), 1);
+		const __m256i hi = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_load_si128((const __m128i*)(oldA + i + NUM_OF_STATES_D2))),
+		                                           _mm_load_si128((const __m128i*)(oldB + i + NUM_OF_STATES_D2)), 1);
+
+		const __m256i metric = _mm256_add_epi16(_mm256_blendv_epi8(sym0, inv0, b1), _mm256_blendv_epi8(sym1, inv1, b2));
+		const __m256i other = _mm256_sub_epi16(m, metric);
+
+		const __m256i m0 = _mm256_add_epi16(lo, metric);
+		const __m256i m1 = _mm256_add_epi16(hi, other);
+		const __m256i m2 = _mm256_add_epi16(lo, other);
+		const __m256i m3 = _mm256_add_epi16(hi, metric);
+
+		const __m256i n0 = _mm256_min_epi16(m0, m1);
+		const __m256i n1 = _mm256_min_epi16(m2, m3);
+		const __m256i nlo = _mm256_unpacklo_epi16(n0, n1);
+		const __m256i nhi = _mm256_unpackhi_epi16(n0, n1);
+		_mm_store_si128((__m128i*)(newA + 2U * i), _mm256_castsi256_si128(nlo));
+		_mm_store_si128((__m128i*)(newA + 2U * i + 8U), _mm256_castsi256_si128(nhi));
+		_mm_store_si128((__m128i*)(newB + 2U * i), _mm256_extracti128_si256(nlo, 1));
+		_mm_store_si128((__m128i*)(newB + 2U * i + 8U), _mm256_extracti128_si256(nhi, 1));
+
+		const __m256i d0 = _mm256_cmpgt_epi16(m1, m0);
+		const __m256i d1 = _mm256_cmpgt_epi16(m3, m2);
+		uint32_t keep = _mm256_movemask_epi8(_mm256_packs_epi16(_mm256_unpacklo_epi16(d0, d1), _mm256_unpackhi_epi16(d0, d1)));
+		decisionsA |= uint64_t(~keep & 0xFFFFU) << (2U * i);
+		decisionsB |= uint64_t((~keep >> 16) & 0xFFFFU) << (2U * i);
+	}
+
+	m_decisions[0U][m_steps] = decisionsA;
+	m_decisions[1U][m_steps] = decisionsB;
+}
+#endif
+
+#endif
@@ -19,27 +19,15 @@
 #if !defined(YSFConvolution_H)
 #define  YSFConvolution_H
 
+#include "Viterbi.h"
+
 #include <cstdint>
 
-class CYSFConvolution {
+// Hard decision symbols, 0 or 1, the same K = 5 code as M17
+class CYSFConvolution : public CViterbi<5U, 0x19U, 0x17U, 1U, 180U> {
 public:
 	CYSFConvolution();
 	~CYSFConvolution();
-
-	void start();
-	void decode(uint8_t s0, uint8_t s1);
-	void chainback(uint8_t* out, uint32_t nBits);
-
-	void encode(const uint8_t* in, uint8_t* out, uint32_t nBits) const;
-
-private:
-	uint16_t* m_metrics1;
-	uint16_t* m_metrics2;
-	uint16_t* m_oldMetrics;
-	uint16_t* m_newMetrics;
-	uint64_t* m_decisions;
-	uint64_t* m_dp;
 };
 
 #endif
-
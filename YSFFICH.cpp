@@ -95,17 +95,18 @@ bool CYSFFICH::decode(const uint8_t* bytes)
 	uint8_t output[13U];
 	viterbi.chainback(output, 96U);
 
-	uint32_t b0 = CGolay24128::decode24128(output + 0U);
-	uint32_t b1 = CGolay24128::decode24128(output + 3U);
-	uint32_t b2 = CGolay24128::decode24128(output + 6U);
-	uint32_t b3 = CGolay24128::decode24128(output + 9U);
-
-	m_fich[0U] = (b0 >> 4) & 0xFFU;
-	m_fich[1U] = ((b0 << 4) & 0xF0U) | ((b1 >> 8) & 0x0FU);
-	m_fich[2U] = (b1 >> 0) & 0xFFU;
-	m_fich[3U] = (b2 >> 4) & 0xFFU;
-	m_fich[4U] = ((b2 << 4) & 0xF0U) | ((b3 >> 8) & 0x0FU);
-	m_fich[5U] = (b3 >> 0) & 0xFFU;
+	uint32_t code[4U], b[4U];
+	for (uint32_t i = 0U; i < 4U; i++)
+		code[i] = (output[i * 3U] << 16) | (output[(i * 3U) + 1U] << 8) | (output[(i * 3U) + 2U] << 0);
+
+	CGolay24128::decode24128(code, b, 4U, NULL);
+
+	m_fich[0U] = (b[0U] >> 4) & 0xFFU;
+	m_fich[1U] = ((b[0U] << 4) & 0xF0U) | ((b[1U] >> 8) & 0x0FU);
+	m_fich[2U] = (b[1U] >> 0) & 0xFFU;
+	m_fich[3U] = (b[2U] >> 4) & 0xFFU;
+	m_fich[4U] = ((b[2U] << 4) & 0xF0U) | ((b[3U] >> 8) & 0x0FU);
+	m_fich[5U] = (b[3U] >> 0) & 0xFFU;
 
 	return CCRC::checkCCITT162(m_fich, 6U);
 }
@@ -0,0 +1,413 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// AMBE3000 emulator, see ambe3000_emu.h. Built on its own it serves one
+// pseudo terminal until interrupted and prints the port name to stdout:
+//
+//   ambe3000_emu [--channels 1|3] [--latency us] [--baud N]
+//
+// serialambe_bench builds it with AMBE3000_EMU_LIBRARY and runs it on a
+// thread next to SerialAMBE.
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "ambe3000_emu.h"
+#include "mbe/vocoder_plugin.h"
+
+#define AMBE3000_START_BYTE     0x61
+#define AMBE3000_TYPE_CONFIG    0x00
+#define AMBE3000_TYPE_CHANNEL   0x01
+#define AMBE3000_TYPE_SPEECH    0x02
+#define AMBE3000_PKT_RATEP      0x0a
+#define AMBE3000_PKT_INIT       0x0b
+#define AMBE3000_PKT_PARITYBYTE 0x2f
+#define AMBE3000_PKT_PRODID     0x30
+#define AMBE3000_PKT_VERSTRING  0x31
+#define AMBE3000_PKT_RESET      0x33
+#define AMBE3000_PKT_READY      0x39
+#define AMBE3000_PKT_PARITYMODE 0x3f
+#define AMBE3000_PKT_CHANNEL0   0x40
+#define AMBE3000_PKT_SPCHD      0x00
+#define AMBE3000_PKT_CHAND      0x01
+#define AMBE3000_MAX_PACKET     400
+
+// Rate control words of the rates SerialAMBE configures
+static const uint8_t RCW_2400x1200[12] = {0x01, 0x30, 0x07, 0x63, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x48};
+static const uint8_t RCW_2450x1150[12] = {0x04, 0x31, 0x07, 0x54, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6f, 0x48};
+static const uint8_t RCW_2450[12] = {0x04, 0x31, 0x07, 0x54, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x70, 0x31};
+static const uint8_t RCW_P25[12] = {0x05, 0x58, 0x08, 0x6b, 0x10, 0x30, 0x00, 0x00, 0x00, 0x00, 0x01, 0x90};
+
+static uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+AMBE3000Emu::AMBE3000Emu(int channels, int latency_us, int baud) :
+    m_channels((channels > 1) ? 3 : 1),
+    m_latency((uint64_t)std::max(0, latency_us) * 1000),
+    m_byte_ns((baud > 0) ? (10000000000ULL / baud) : 0),
+    m_master(-1),
+    m_slave(-1),
+    m_stop(false),
+    m_stats(),
+    m_rx_free(0),
+    m_tx_free(0)
+{
+    for(int i = 0; i < 3; i++){
+        m_ch[i].rate = RATE_NONE;
+        m_ch[i].busy_until = 0;
+        m_ch[i].vocoder.reset(new VocoderPlugin(i));  // channels decode side by side
+    }
+}
+
+AMBE3000Emu::~AMBE3000Emu()
+{
+    if(m_slave >= 0){
+        close(m_slave);
+    }
+    if(m_master >= 0){
+        close(m_master);
+    }
+}
+
+// Opens the master side, and keeps the slave side open too so the master
+// does not see a hangup while SerialAMBE opens and closes the port.
+bool AMBE3000Emu::open()
+{
+    struct termios t;
+
+    m_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if((m_master < 0) || grantpt(m_master) || unlockpt(m_master)){
+        return false;
+    }
+    m_port = ptsname(m_master);
+    m_slave = ::open(m_port.c_str(), O_RDWR | O_NOCTTY);
+    if(m_slave < 0){
+        return false;
+    }
+    if(tcgetattr(m_slave, &t) == 0){
+        cfmakeraw(&t);
+        tcsetattr(m_slave, TCSANOW, &t);
+    }
+    fcntl(m_master, F_SETFL, fcntl(m_master, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+void AMBE3000Emu::run()
+{
+    uint8_t buf[1024];
+
+    while(!m_stop){
+        uint64_t now = now_ns();
+        flush_tx(now);
+
+        uint64_t wait = 20000000;       // ns, keeps stop() responsive
+        if(!m_answers.empty()){
+            wait = std::min(wait, (m_answers.front().due > now) ? (m_answers.front().due - now) : 0);
+        }
+        struct timespec ts = {(time_t)(wait / 1000000000), (long)(wait % 1000000000)};
+        struct pollfd pfd = {m_master, (short)(POLLIN | (m_tx.empty() ? 0 : POLLOUT)), 0};
+        if(ppoll(&pfd, 1, &ts, nullptr) <= 0){
+            continue;
+        }
+
+        if(pfd.revents & POLLIN){
+            ssize_t n;
+            while((n = read(m_master, buf, sizeof(buf))) > 0){
+                m_rx.insert(m_rx.end(), buf, buf + n);
+            }
+            process_rx(now_ns());
+        }
+    }
+}
+
+// Same framing rules as SerialAMBE::process_serial_3000()
+void AMBE3000Emu::process_rx(uint64_t now)
+{
+    size_t i = 0;
+
+    for(;;){
+        while((i < m_rx.size()) && (m_rx[i] != AMBE3000_START_BYTE)){
+            i++;
+            m_stats.resyncs++;
+        }
+        if((m_rx.size() - i) < 4){
+            break;
+        }
+        size_t len = 4 + ((m_rx[i+1] << 8) | m_rx[i+2]);
+        if((len > AMBE3000_MAX_PACKET) || (m_rx[i+3] > AMBE3000_TYPE_SPEECH)){
+            i++;
+            m_stats.resyncs++;
+            continue;
+        }
+        if((m_rx.size() - i) < len){
+            break;
+        }
+        handle_packet(&m_rx[i], len, now);
+        i += len;
+    }
+    m_rx.erase(m_rx.begin(), m_rx.begin() + i);
+}
+
+void AMBE3000Emu::handle_packet(const uint8_t *p, int len, uint64_t now)
+{
+    int off = 4;
+    int ch = 0;
+    bool chfield = false;
+
+    m_stats.rx_packets++;
+
+    // the pty delivers at once, the last byte would arrive after the packet crossed the line
+    m_rx_free = std::max(now, m_rx_free) + len * m_byte_ns;
+
+    if((len > off) && (p[off] >= AMBE3000_PKT_CHANNEL0) && (p[off] < (AMBE3000_PKT_CHANNEL0 + 3))){
+        ch = p[off++] - AMBE3000_PKT_CHANNEL0;
+        chfield = true;
+        if(ch >= m_channels){
+            return;
+        }
+    }
+
+    if(p[3] == AMBE3000_TYPE_CONFIG){
+        handle_config(p, len, off, chfield, ch, m_rx_free);
+    }
+    else{
+        handle_voice(p, len, off, chfield, ch, m_rx_free);
+    }
+}
+
+void AMBE3000Emu::handle_config(const uint8_t *p, int len, int off, bool chfield, int ch, uint64_t ready)
+{
+    std::vector<uint8_t> a = {AMBE3000_START_BYTE, 0x00, 0x00, AMBE3000_TYPE_CONFIG};
+    const char *s;
+
+    if(chfield){
+        a.push_back(AMBE3000_PKT_CHANNEL0 + ch);
+    }
+    const size_t fields = a.size();
+
+    while(off < len){
+        switch(p[off++]){
+        case AMBE3000_PKT_PARITYMODE:
+            a.push_back(AMBE3000_PKT_PARITYMODE);
+            a.push_back(0x00);
+            off++;
+            break;
+        case AMBE3000_PKT_PARITYBYTE:
+            off++;
+            break;
+        case AMBE3000_PKT_PRODID:
+            s = (m_channels == 3) ? "AMBE3003" : "AMBE3000R";
+            a.push_back(AMBE3000_PKT_PRODID);
+            a.insert(a.end(), s, s + strlen(s) + 1);
+            break;
+        case AMBE3000_PKT_VERSTRING:
+            s = "V120.E100.EMU";
+            a.push_back(AMBE3000_PKT_VERSTRING);
+            a.insert(a.end(), s, s + strlen(s) + 1);
+            break;
+        case AMBE3000_PKT_RATEP:
+            if((len - off) < 12){
+                off = len;
+                break;
+            }
+            if(!memcmp(p + off, RCW_2400x1200, 12)) m_ch[ch].rate = RATE_2400x1200;
+            else if(!memcmp(p + off, RCW_2450x1150, 12)) m_ch[ch].rate = RATE_2450x1150;
+            else if(!memcmp(p + off, RCW_2450, 12)) m_ch[ch].rate = RATE_2450;
+            else if(!memcmp(p + off, RCW_P25, 12)) m_ch[ch].rate = RATE_P25;
+            else m_ch[ch].rate = RATE_NONE;
+            a.push_back(AMBE3000_PKT_RATEP);
+            a.push_back((m_ch[ch].rate == RATE_NONE) ? 0x01 : 0x00);
+            off += 12;
+            break;
+        case AMBE3000_PKT_INIT:
+            a.push_back(AMBE3000_PKT_INIT);
+            a.push_back(0x00);
+            off++;
+            break;
+        case AMBE3000_PKT_RESET:
+            for(int i = 0; i < 3; i++){
+                m_ch[i].rate = RATE_NONE;
+            }
+            a.push_back(AMBE3000_PKT_READY);
+            break;
+        default:
+            off = len;          // unknown field, its length is unknown too
+            break;
+        }
+    }
+
+    if(a.size() > fields){
+        queue_answer(a, ready);
+    }
+}
+
+// A channel packet is decoded and answered with speech, a speech packet is
+// encoded and answered with channel data, each after the channel's latency.
+void AMBE3000Emu::handle_voice(const uint8_t *p, int len, int off, bool chfield, int ch, uint64_t ready)
+{
+    Channel &c = m_ch[ch];
+    std::vector<uint8_t> a = {AMBE3000_START_BYTE, 0x00, 0x00, 0x00};
+    int16_t pcm[160];
+    uint8_t ambe[11];
+
+    if(chfield){
+        a.push_back(AMBE3000_PKT_CHANNEL0 + ch);
+    }
+    memset(pcm, 0, sizeof(pcm));
+    memset(ambe, 0, sizeof(ambe));
+
+    if(p[3] == AMBE3000_TYPE_CHANNEL){
+        if(((len - off) < 2) || (p[off] != AMBE3000_PKT_CHAND)){
+            return;
+        }
+        int bytes = std::min((p[off+1] + 7) / 8, std::min(len - off - 2, 11));
+        memcpy(ambe, p + off + 2, bytes);
+
+        switch(c.rate){
+        case RATE_2400x1200: c.vocoder->decode_2400x1200(pcm, ambe); break;
+        case RATE_2450x1150: c.vocoder->decode_2450x1150(pcm, ambe); break;
+        case RATE_2450: c.vocoder->decode_2450(pcm, ambe); break;
+        default: break;     // no software P25 half rate, answer silence
+        }
+
+        a[3] = AMBE3000_TYPE_SPEECH;
+        a.push_back(AMBE3000_PKT_SPCHD);
+        a.push_back(160);
+        for(int i = 0; i < 160; i++){
+            a.push_back((pcm[i] >> 8) & 0xff);
+            a.push_back(pcm[i] & 0xff);
+        }
+        m_stats.decoded++;
+    }
+    else{
+        if(((len - off) < (2 + 320)) || (p[off] != AMBE3000_PKT_SPCHD)){
+            return;
+        }
+        for(int i = 0; i < 160; i++){
+            pcm[i] = (p[off+2+(i*2)] << 8) | p[off+3+(i*2)];
+        }
+
+        int bits = 72;
+        switch(c.rate){
+        case RATE_2400x1200: c.vocoder->encode_2400x1200(pcm, ambe); break;
+        case RATE_2450x1150: c.vocoder->encode_2450x1150(pcm, ambe); break;
+        case RATE_2450: c.vocoder->encode_2450(pcm, ambe); bits = 49; break;
+        case RATE_P25: bits = 88; break;
+        default: break;
+        }
+
+        a[3] = AMBE3000_TYPE_CHANNEL;
+        a.push_back(AMBE3000_PKT_CHAND);
+        a.push_back(bits);
+        a.insert(a.end(), ambe, ambe + ((bits + 7) / 8));
+        m_stats.encoded++;
+    }
+
+    c.busy_until = std::max(ready, c.busy_until) + m_latency;
+    queue_answer(a, c.busy_until);
+}
+
+void AMBE3000Emu::queue_answer(std::vector<uint8_t> &packet, uint64_t ready)
+{
+    const size_t len = packet.size() - 4;
+
+    packet[1] = (len >> 8) & 0xff;
+    packet[2] = len & 0xff;
+    m_tx_free = std::max(ready, m_tx_free) + packet.size() * m_byte_ns;
+
+    Answer r;
+    r.due = m_tx_free;
+    r.packet.swap(packet);
+    m_answers.push_back(std::move(r));
+}
+
+void AMBE3000Emu::flush_tx(uint64_t now)
+{
+    while(!m_answers.empty() && (m_answers.front().due <= now)){
+        const std::vector<uint8_t> &p = m_answers.front().packet;
+        m_tx.insert(m_tx.end(), p.begin(), p.end());
+        m_answers.pop_front();
+        m_stats.tx_packets++;
+    }
+
+    if(!m_tx.empty()){
+        ssize_t n = write(m_master, m_tx.data(), m_tx.size());
+        if(n > 0){
+            m_tx.erase(m_tx.begin(), m_tx.begin() + n);
+        }
+    }
+}
+
+#ifndef AMBE3000_EMU_LIBRARY
+static AMBE3000Emu *g_emu = nullptr;
+
+static void on_signal(int)
+{
+    if(g_emu){
+        g_emu->stop();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int channels = 1;
+    int latency = 0;
+    int baud = 460800;
+
+    for(int i = 1; i < argc; i++){
+        std::string a = argv[i];
+        if((i + 1) >= argc){
+            fprintf(stderr, "usage: %s [--channels 1|3] [--latency us] [--baud N]\n", argv[0]);
+            return 1;
+        }
+        if(a == "--channels") channels = atoi(argv[++i]);
+        else if(a == "--latency") latency = atoi(argv[++i]);
+        else if(a == "--baud") baud = atoi(argv[++i]);
+        else{
+            fprintf(stderr, "usage: %s [--channels 1|3] [--latency us] [--baud N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    AMBE3000Emu emu(channels, latency, baud);
+    if(!emu.open()){
+        perror("pty");
+        return 1;
+    }
+    printf("%s\n", emu.port().c_str());
+    fflush(stdout);
+
+    g_emu = &emu;
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    emu.run();
+
+    const AMBE3000Emu::Stats s = emu.stats();
+    fprintf(stderr, "rx %llu tx %llu decoded %llu encoded %llu resyncs %llu\n",
+            (unsigned long long)s.rx_packets, (unsigned long long)s.tx_packets, (unsigned long long)s.decoded,
+            (unsigned long long)s.encoded, (unsigned long long)s.resyncs);
+    return 0;
+}
+#endif
@@ -0,0 +1,91 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef AMBE3000_EMU_H
+#define AMBE3000_EMU_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+class VocoderPlugin;
+
+// Software stand-in for a DVSI AMBE3000 (or, with 3 channels, an AMBE3003)
+// on a Linux pseudo terminal. Serves the config, speech and channel packets
+// SerialAMBE sends, with the software VocoderPlugin doing the coding.
+//
+// Timing follows the serial line and the chip: a packet is not seen before
+// its bytes could have crossed the line at the configured baud rate (8N1),
+// each channel then needs latency_us per speech or channel request, and the
+// answer is written once its own bytes could have crossed back. A baud
+// rate of 0 disables the line pacing.
+class AMBE3000Emu
+{
+public:
+    struct Stats {
+        uint64_t rx_packets;
+        uint64_t tx_packets;
+        uint64_t decoded;       // channel packets answered with speech
+        uint64_t encoded;       // speech packets answered with channel data
+        uint64_t resyncs;       // bytes skipped looking for a packet header
+    };
+
+    AMBE3000Emu(int channels = 1, int latency_us = 0, int baud = 460800);
+    ~AMBE3000Emu();
+    bool open();
+    const std::string &port() const { return m_port; }
+    void run();                 // serves requests until stop()
+    void stop() { m_stop = true; }
+    Stats stats() const { return m_stats; }
+
+private:
+    enum Rate { RATE_NONE, RATE_2400x1200, RATE_2450x1150, RATE_2450, RATE_P25 };
+    struct Channel {
+        Rate rate;
+        uint64_t busy_until;    // ns, end of the request being coded
+        std::unique_ptr<VocoderPlugin> vocoder;
+    };
+    struct Answer {
+        uint64_t due;           // ns, last byte on the line
+        std::vector<uint8_t> packet;
+    };
+
+    int m_channels;
+    uint64_t m_latency;         // ns
+    uint64_t m_byte_ns;         // ns per byte on the line, 0 for no pacing
+    int m_master;
+    int m_slave;
+    std::string m_port;
+    std::atomic<bool> m_stop;
+    Stats m_stats;
+    Channel m_ch[3];
+    std::vector<uint8_t> m_rx;
+    std::vector<uint8_t> m_tx;  // written in part, the line was full
+    std::deque<Answer> m_answers;
+    uint64_t m_rx_free;
+    uint64_t m_tx_free;
+
+    void process_rx(uint64_t now);
+    void handle_packet(const uint8_t *p, int len, uint64_t now);
+    void handle_config(const uint8_t *p, int len, int off, bool chfield, int ch, uint64_t ready);
+    void handle_voice(const uint8_t *p, int len, int off, bool chfield, int ch, uint64_t ready);
+    void queue_answer(std::vector<uint8_t> &packet, uint64_t ready);
+    void flush_tx(uint64_t now);
+};
+
+#endif // AMBE3000_EMU_H
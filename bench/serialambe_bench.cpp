@@ -0,0 +1,301 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Hardware vocoder path benchmark. Runs the AMBE3000 emulator on a pseudo
+// terminal, drives SerialAMBE through it and prints one JSON document with
+// the frame rate, request latency and pipeline counters of a decode and an
+// encode run, so pipelining and flow control changes can be measured
+// without a DVSI dongle.
+//
+//   serialambe_bench [--mode DMR|YSF|NXDN|REF] [--frames N] [--inflight N]
+//                    [--latency us] [--baud N] [--channels 1|3] [--realtime]
+//                    [--pool] [--out file.json]
+//
+// By default a new frame is submitted whenever SerialAMBE has no request
+// waiting for a credit, which measures throughput. --realtime submits one
+// frame per channel every 20 ms instead, as a mode does, and measures
+// latency. --latency is the per frame processing time of the emulated chip
+// (a real AMBE3000 takes about 20 ms to encode), --baud the line rate.
+// With --channels 3 the emulator reports itself as an AMBE-3003 and frames
+// are spread over its channels. --pool gets the channels from VocoderPool
+// instead, so the device lives in the thread of the pool and every request
+// and answer crosses threads, as it does for the modes.
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "serialambe.h"
+#include "vocoderpool.h"
+#include "ambe3000_emu.h"
+
+struct BenchResult {
+    int submitted;
+    int completed;
+    double seconds;
+    double latency_avg_us;
+    double latency_max_us;
+    AMBEPipelineStats stats;
+};
+
+static void wait_events(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+// Submits frames round robin over the channels and collects the answers.
+// A run ends when every answer is in, or when nothing was sent or answered
+// for a second. A window of 0 sends whenever SerialAMBE has no request
+// waiting for a credit. Through the pool a request only reaches that queue
+// once the thread of the pool gets to it, so there at most window frames
+// are sent ahead of their answers instead.
+static BenchResult run_case(SerialAMBE &ambe, bool decode, int frames, int channels, bool realtime, int window, int frame_bytes)
+{
+    BenchResult r = {};
+    std::deque<qint64> sent[AMBE3000_MAX_CHANNELS];
+    const AMBEPipelineStats s0 = ambe.get_pipeline_stats();
+    uint8_t codec[AMBE3000_MAX_FRAME];
+    int16_t pcm[160];
+    uint32_t lfsr = 0x1234567;
+    double latency_sum = 0;
+    qint64 last = 0;
+    qint64 last_sent = 0;
+
+    QElapsedTimer clock;
+    QTimer wake;                    // WaitForMoreEvents returns at least every ms
+    wake.start(1);
+    clock.start();
+
+    while(r.completed < r.submitted || r.submitted < frames){
+        const qint64 now = clock.nsecsElapsed();
+
+        while(r.submitted < frames){
+            const int ch = r.submitted % channels;
+            if(realtime){
+                if(now < ((qint64)(r.submitted / channels) * 20000000)){
+                    break;
+                }
+            }
+            else if(window ? ((r.submitted - r.completed) >= window) : (ambe.get_pipeline_stats().queued > 0)){
+                break;
+            }
+            if(decode){
+                for(int i = 0; i < frame_bytes; i++){
+                    lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xd0000001u);
+                    codec[i] = lfsr & 0xff;
+                }
+                ambe.decode(codec, ch);
+            }
+            else{
+                for(int i = 0; i < 160; i++){
+                    pcm[i] = 8000 * sin((r.submitted * 160 + i) * 0.05);
+                }
+                ambe.encode(pcm, ch);
+            }
+            last_sent = clock.nsecsElapsed();
+            sent[ch].push_back(last_sent);
+            r.submitted++;
+        }
+
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+
+        for(int ch = 0; ch < channels; ch++){
+            while(decode ? ambe.get_audio(pcm, ch) : ambe.get_ambe(codec, ch)){
+                const qint64 t = clock.nsecsElapsed();
+                if(!sent[ch].empty()){
+                    const double us = (t - sent[ch].front()) / 1000.0;
+                    sent[ch].pop_front();
+                    latency_sum += us;
+                    r.latency_max_us = std::max(r.latency_max_us, us);
+                }
+                r.completed++;
+                last = t;
+            }
+        }
+
+        if((clock.nsecsElapsed() - std::max(last, last_sent)) > 1000000000LL){
+            break;
+        }
+    }
+
+    r.seconds = (last ? last : clock.nsecsElapsed()) / 1e9;
+    r.latency_avg_us = r.completed ? (latency_sum / r.completed) : 0;
+    r.stats = ambe.get_pipeline_stats();
+    r.stats.completed -= s0.completed;
+    r.stats.lost -= s0.lost;
+    r.stats.dropped -= s0.dropped;
+    r.stats.resyncs -= s0.resyncs;
+    return r;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [--mode DMR|YSF|NXDN|REF] [--frames N] [--inflight N] [--latency us] [--baud N]\n"
+                    "       %*s [--channels 1|3] [--realtime] [--pool] [--out file.json]\n", argv0, (int)strlen(argv0), "");
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    std::string mode = "DMR";
+    std::string out_file;
+    int frames = 500;
+    int inflight = 2;
+    int latency = 0;
+    int baud = 460800;
+    int channels = 1;
+    bool realtime = false;
+    bool pool = false;
+
+    for(int i = 1; i < argc; i++){
+        std::string a = argv[i];
+        if(a == "--realtime"){
+            realtime = true;
+            continue;
+        }
+        if(a == "--pool"){
+            pool = true;
+            continue;
+        }
+        if((i + 1) >= argc){
+            usage(argv[0]);
+            return 1;
+        }
+        if(a == "--mode") mode = argv[++i];
+        else if(a == "--frames") frames = std::max(1, atoi(argv[++i]));
+        else if(a == "--inflight") inflight = std::max(1, atoi(argv[++i]));
+        else if(a == "--latency") latency = atoi(argv[++i]);
+        else if(a == "--baud") baud = atoi(argv[++i]);
+        else if(a == "--channels") channels = (atoi(argv[++i]) > 1) ? 3 : 1;
+        else if(a == "--out") out_file = argv[++i];
+        else{
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    AMBE3000Emu emu(channels, latency, baud);
+    if(!emu.open()){
+        fprintf(stderr, "cannot open a pseudo terminal\n");
+        return 1;
+    }
+    std::thread emu_thread(&AMBE3000Emu::run, &emu);
+
+    std::unique_ptr<SerialAMBE> own;
+    SerialAMBE *ambe;
+    std::atomic<bool> connected(false);     // set from the thread of the pool with --pool
+    int ch0 = 0;
+
+    if(pool){
+        ambe = VocoderPool::GetInstance().acquire(QString::fromStdString(emu.port()), QString::fromStdString(mode), &ch0);
+        if(!ambe){
+            fprintf(stderr, "no pool channel on %s\n", emu.port().c_str());
+            emu.stop();
+            emu_thread.join();
+            return 1;
+        }
+    }
+    else{
+        own.reset(new SerialAMBE(QString::fromStdString(mode)));
+        ambe = own.get();
+    }
+    QObject::connect(ambe, &SerialAMBE::connected, [&connected](bool s, int){ connected = s; });
+    if(pool){
+        VocoderPool::GetInstance().start(ambe, ch0);
+    }
+    else{
+        ambe->connect_to_serial(QString::fromStdString(emu.port()));
+    }
+    for(int i = 0; (i < 40) && !connected; i++){
+        wait_events(50);
+    }
+    if(!connected){
+        fprintf(stderr, "no answer from the emulator on %s\n", emu.port().c_str());
+        emu.stop();
+        emu_thread.join();
+        return 1;
+    }
+
+    channels = std::min(channels, ambe->get_channels());
+    for(int ch = 1; ch < channels; ch++){
+        if(pool){
+            int c;
+            if(VocoderPool::GetInstance().acquire(QString::fromStdString(emu.port()), QString::fromStdString(mode), &c) != ambe){
+                channels = ch;
+                break;
+            }
+            VocoderPool::GetInstance().start(ambe, c);
+        }
+        else{
+            ambe->config_channel(ch, QString::fromStdString(mode));
+        }
+    }
+    wait_events(50);
+    ambe->set_max_inflight(inflight);
+
+    const int frame_bytes = ((mode == "YSF") || (mode == "NXDN")) ? 7 : 9;
+
+    FILE *out = out_file.empty() ? stdout : fopen(out_file.c_str(), "w");
+    if(!out){
+        fprintf(stderr, "cannot open %s\n", out_file.c_str());
+        emu.stop();
+        emu_thread.join();
+        return 1;
+    }
+
+    fprintf(out, "{\n  \"benchmark\": \"serialambe\",\n  \"mode\": \"%s\",\n  \"prodid\": \"%s\",\n  \"channels\": %d,\n  \"baud\": %d,\n"
+                 "  \"chip_latency_us\": %d,\n  \"inflight\": %d,\n  \"pacing\": \"%s\",\n  \"pool\": %s,\n  \"results\": [",
+            mode.c_str(), ambe->get_ambe_prodid().toStdString().c_str(), channels, baud, latency, inflight,
+            realtime ? "realtime" : "throughput", pool ? "true" : "false");
+
+    for(int c = 0; c < 2; c++){
+        const bool decode = (c == 0);
+        const BenchResult r = run_case(*ambe, decode, frames, channels, realtime, pool ? ((inflight + 1) * channels) : 0, frame_bytes);
+        const double fps = r.seconds ? (r.completed / r.seconds) : 0;
+
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"frames\": %d, \"completed\": %d, \"seconds\": %.3f, \"frames_per_sec\": %.1f, "
+                     "\"realtime_channels\": %.2f, \"latency_avg_us\": %.0f, \"latency_max_us\": %.0f, "
+                     "\"lost\": %u, \"dropped\": %u, \"resyncs\": %u}",
+                c ? "," : "", decode ? "decode" : "encode", r.submitted, r.completed, r.seconds, fps,
+                fps / 50.0, r.latency_avg_us, r.latency_max_us, r.stats.lost, r.stats.dropped, r.stats.resyncs);
+        fflush(out);
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if(out != stdout){
+        fclose(out);
+    }
+
+    if(pool){
+        for(int ch = 0; ch < channels; ch++){
+            VocoderPool::GetInstance().release(ambe, ch);
+        }
+    }
+    emu.stop();
+    emu_thread.join();
+    return 0;
+}
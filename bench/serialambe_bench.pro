@@ -0,0 +1,53 @@
+# SerialAMBE benchmark against the AMBE3000 emulator, see serialambe_bench.cpp
+#   qmake bench/serialambe_bench.pro && make && ./serialambe_bench --latency 20000 --out serialambe.json
+
+TEMPLATE = app
+TARGET = serialambe_bench
+CONFIG += console c++17
+CONFIG -= app_bundle
+QT = core serialport
+INCLUDEPATH += ..
+DEFINES += AMBE3000_EMU_LIBRARY
+LIBS += -lm
+
+HEADERS += \
+	ambe3000_emu.h \
+	../serialambe.h \
+	../vocoderpool.h
+
+SOURCES += \
+	serialambe_bench.cpp \
+	ambe3000_emu.cpp \
+	../serialambe.cpp \
+	../vocoderpool.cpp \
+	../imbe_vocoder/aux_sub.cc \
+	../imbe_vocoder/basicop2.cc \
+	../imbe_vocoder/ch_decode.cc \
+	../imbe_vocoder/ch_encode.cc \
+	../imbe_vocoder/dc_rmv.cc \
+	../imbe_vocoder/decode.cc \
+	../imbe_vocoder/dsp_sub.cc \
+	../imbe_vocoder/encode.cc \
+	../imbe_vocoder/imbe_vocoder.cc \
+	../imbe_vocoder/imbe_vocoder_impl.cc \
+	../imbe_vocoder/math_sub.cc \
+	../imbe_vocoder/pe_lpf.cc \
+	../imbe_vocoder/pitch_est.cc \
+	../imbe_vocoder/pitch_ref.cc \
+	../imbe_vocoder/qnt_sub.cc \
+	../imbe_vocoder/rand_gen.cc \
+	../imbe_vocoder/sa_decode.cc \
+	../imbe_vocoder/sa_encode.cc \
+	../imbe_vocoder/sa_enh.cc \
+	../imbe_vocoder/tbls.cc \
+	../imbe_vocoder/uv_synt.cc \
+	../imbe_vocoder/v_synt.cc \
+	../imbe_vocoder/v_uv_det.cc \
+	../mbe/ambe3600x2400.c \
+	../mbe/ambe3600x2450.c \
+	../mbe/ambe_framing.cpp \
+	../mbe/ambe_quant.cpp \
+	../mbe/ecc.c \
+	../mbe/mbelib.c \
+	../mbe/mbe_synth.c \
+	../mbe/vocoder_plugin.cpp
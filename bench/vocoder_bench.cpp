@@ -0,0 +1,660 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Standalone codec benchmark. Runs every software vocoder entry point over
+// a speech corpus and prints one JSON document with ns/frame, real time
+// factor, frames/sec/core, cache misses and heap allocations per case.
+//
+//   vocoder_bench [--pcm file.raw] [--seconds N] [--repeat N] [--filter s] [--out file.json]
+//   vocoder_bench --record dir [--pcm file.raw] [--seconds N] [--filter s] [--out file.json]
+//   vocoder_bench --check dir [--snr dB] [--ber rate] [--filter s] [--out file.json]
+//
+// --pcm takes 8 kHz mono s16le audio. Without it a deterministic synthetic
+// talker (voiced formant segments, fricatives and pauses) is generated, so
+// runs are comparable across machines and releases. The AMBE, IMBE and
+// Codec2 codeword vectors fed to the decoders are made by encoding that
+// corpus before any timing starts.
+//
+// --record stores the corpus and the output of every case in dir as golden
+// vectors. --check replays the stored corpus, and the stored codewords for
+// the decoders, through every case and compares against the golden output:
+// the fixed point IMBE codec must be bit exact, float encoders may flip at
+// most --ber of the codeword bits (default 0.01) and float decoders must stay
+// above --snr dB (default 30). --check also runs every mbelib synthesis
+// engine against the reference over 2000 frames, each must stay within
+// MBE_SYNTH_TOLERANCE. Each result carries the time it took, and the exit
+// status is non-zero if any case fails.
+//
+// bench/golden holds one second of the synthetic talker and the output of
+// every case, recorded with --seconds 1 from the codecs as they were before
+// the SIMD work, mbelib with the MBE_SYNTH_REFERENCE engine, one case per
+// process. Run --check bench/golden before and after a change to a codec,
+// and record it again only when a change to the output is intended.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "mbe/vocoder_plugin.h"
+#include "imbe_vocoder/imbe_vocoder_api.h"
+#include "codec2/codec2_api.h"
+
+static unsigned long long g_allocs = 0;
+
+#if defined(__GLIBC__)
+// count every heap allocation, C and C++, while still using glibc's allocator
+extern "C" void *__libc_malloc(size_t);
+extern "C" void *__libc_calloc(size_t, size_t);
+extern "C" void *__libc_realloc(void *, size_t);
+
+extern "C" void *malloc(size_t n)
+{
+    g_allocs++;
+    return __libc_malloc(n);
+}
+
+extern "C" void *calloc(size_t n, size_t s)
+{
+    g_allocs++;
+    return __libc_calloc(n, s);
+}
+
+extern "C" void *realloc(void *p, size_t n)
+{
+    g_allocs++;
+    return __libc_realloc(p, n);
+}
+#define BENCH_COUNTS_ALLOCS
+#endif
+
+class CacheMissCounter
+{
+public:
+    CacheMissCounter()
+    {
+        m_fd = -1;
+#ifdef __linux__
+        struct perf_event_attr pe;
+        memset(&pe, 0, sizeof(pe));
+        pe.type = PERF_TYPE_HARDWARE;
+        pe.size = sizeof(pe);
+        pe.config = PERF_COUNT_HW_CACHE_MISSES;
+        pe.disabled = 1;
+        pe.exclude_kernel = 1;
+        pe.exclude_hv = 1;
+        m_fd = syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0);
+#endif
+    }
+    ~CacheMissCounter()
+    {
+#ifdef __linux__
+        if(m_fd >= 0){
+            close(m_fd);
+        }
+#endif
+    }
+    bool available() const { return m_fd >= 0; }
+    void start()
+    {
+#ifdef __linux__
+        if(m_fd >= 0){
+            ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+    long long stop()
+    {
+        long long count = -1;
+#ifdef __linux__
+        if(m_fd >= 0){
+            ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+            if(read(m_fd, &count, sizeof(count)) != sizeof(count)){
+                count = -1;
+            }
+        }
+#endif
+        return count;
+    }
+private:
+    int m_fd;
+};
+
+// Deterministic stand-in for a talker: pitch and formants glide, vowels are
+// separated by fricatives and short pauses.
+static std::vector<int16_t> synth_speech(int seconds)
+{
+    const int fs = 8000;
+    const int n = seconds * fs;
+    std::vector<int16_t> pcm(n);
+    uint32_t lcg = 0x2545F491;
+    double phase = 0.0;
+    double y[3][2] = {};
+    double hp = 0.0;
+
+    for(int i = 0; i < n; i++){
+        const double t = (double)i / fs;
+        const double seg = fmod(t, 0.9);
+        const bool pause = seg > 0.78;
+        const bool fric = !pause && (seg > 0.62);
+        const double f0 = 95.0 + 45.0 * sin(2 * M_PI * 0.31 * t) + 25.0 * sin(2 * M_PI * 1.7 * t);
+        const double formant[3] = {
+            500.0 + 250.0 * sin(2 * M_PI * 0.9 * t),
+            1500.0 + 500.0 * sin(2 * M_PI * 0.53 * t + 1.0),
+            2500.0 + 300.0 * sin(2 * M_PI * 0.37 * t + 2.0)
+        };
+        lcg = lcg * 1664525u + 1013904223u;
+        const double noise = ((lcg >> 9) / 8388608.0) - 1.0;
+
+        double src = 0.0;
+        phase += f0 / fs;
+        if(phase >= 1.0){
+            phase -= 1.0;
+            src = 1.0;
+        }
+        if(fric){
+            src = 0.25 * noise;
+        }
+        src += 0.002 * noise;
+
+        double out = 0.0;
+        for(int k = 0; k < 3; k++){
+            const double r = 0.97;
+            const double w = 2 * M_PI * formant[k] / fs;
+            const double v = src + (2 * r * cos(w) * y[k][0]) - (r * r * y[k][1]);
+            y[k][1] = y[k][0];
+            y[k][0] = v;
+            out += v / (k + 1);
+        }
+        const double s = out - hp;
+        hp = out;
+        double env = pause ? 0.02 : (0.5 + 0.5 * sin(M_PI * seg / 0.78));
+        pcm[i] = (int16_t)std::max(-32000.0, std::min(32000.0, s * env * 1200.0));
+    }
+    return pcm;
+}
+
+struct BenchCase
+{
+    std::string name;
+    int samples;        // PCM samples per codec frame
+    int bytes;          // codeword bytes per codec frame
+    int batch;          // codec frames per call
+    bool encoder;
+    bool exact;         // fixed point, golden output must match bit for bit
+    std::function<void()> reset;
+    std::function<void(int16_t *pcm, uint8_t *bits)> run;
+};
+
+struct BenchInput
+{
+    std::vector<int16_t> pcm;
+    std::vector<uint8_t> bits;
+    int frames;
+};
+
+static void add_vocoder_cases(std::vector<BenchCase> &cases)
+{
+    struct Mode { const char *name; int bytes;
+        void (VocoderPlugin::*enc)(int16_t *, uint8_t *);
+        void (VocoderPlugin::*dec)(int16_t *, uint8_t *);
+        void (VocoderPlugin::*enc_batch)(int16_t *, uint8_t *, size_t);
+        void (VocoderPlugin::*dec_batch)(int16_t *, const uint8_t *, size_t); };
+    static const Mode modes[] = {
+        {"2400x1200", 9, &VocoderPlugin::encode_2400x1200, &VocoderPlugin::decode_2400x1200, &VocoderPlugin::encode_2400x1200_batch, &VocoderPlugin::decode_2400x1200_batch},
+        {"2450x1150", 9, &VocoderPlugin::encode_2450x1150, &VocoderPlugin::decode_2450x1150, &VocoderPlugin::encode_2450x1150_batch, &VocoderPlugin::decode_2450x1150_batch},
+        {"2450", 7, &VocoderPlugin::encode_2450, &VocoderPlugin::decode_2450, &VocoderPlugin::encode_2450_batch, &VocoderPlugin::decode_2450_batch},
+    };
+
+    for(const Mode &m : modes){
+        auto v = std::make_shared<std::unique_ptr<VocoderPlugin>>();
+        auto reset = [v]{ v->reset(new VocoderPlugin(0)); };   // fixed noise seed
+        cases.push_back({std::string("VocoderPlugin::encode_") + m.name, 160, m.bytes, 1, true, false, reset,
+            [v, m](int16_t *pcm, uint8_t *bits){ ((**v).*m.enc)(pcm, bits); }});
+        cases.push_back({std::string("VocoderPlugin::decode_") + m.name, 160, m.bytes, 1, false, false, reset,
+            [v, m](int16_t *pcm, uint8_t *bits){ ((**v).*m.dec)(pcm, bits); }});
+        cases.push_back({std::string("VocoderPlugin::encode_") + m.name + "_batch", 160, m.bytes, 3, true, false, reset,
+            [v, m](int16_t *pcm, uint8_t *bits){ ((**v).*m.enc_batch)(pcm, bits, 3); }});
+        cases.push_back({std::string("VocoderPlugin::decode_") + m.name + "_batch", 160, m.bytes, 3, false, false, reset,
+            [v, m](int16_t *pcm, uint8_t *bits){ ((**v).*m.dec_batch)(pcm, bits, 3); }});
+    }
+}
+
+static void add_imbe_cases(std::vector<BenchCase> &cases)
+{
+    auto v = std::make_shared<std::unique_ptr<imbe_vocoder>>();
+    auto reset = [v]{ v->reset(new imbe_vocoder()); };
+    cases.push_back({"imbe_vocoder::encode_4400", 160, 11, 1, true, true, reset,
+        [v](int16_t *pcm, uint8_t *bits){ (*v)->encode_4400(pcm, bits); }});
+    cases.push_back({"imbe_vocoder::decode_4400", 160, 11, 1, false, true, reset,
+        [v](int16_t *pcm, uint8_t *bits){ (*v)->decode_4400(pcm, bits); }});
+}
+
+static void add_codec2_cases(std::vector<BenchCase> &cases)
+{
+    for(int mode : {3200, 1600}){
+        auto c = std::make_shared<std::unique_ptr<CCodec2>>();
+        auto reset = [c, mode]{ c->reset(new CCodec2(mode == 3200)); };
+        const int samples = (mode == 3200) ? 160 : 320;
+        const std::string suffix = std::to_string(mode);
+        cases.push_back({"CCodec2::encode_" + suffix, samples, 8, 1, true, false, reset,
+            [c](int16_t *pcm, uint8_t *bits){ (*c)->codec2_encode(bits, pcm); }});
+        cases.push_back({"CCodec2::decode_" + suffix, samples, 8, 1, false, false, reset,
+            [c](int16_t *pcm, uint8_t *bits){ (*c)->codec2_decode(pcm, bits); }});
+    }
+}
+
+// PCM cut into whole calls, plus the codewords of the matching encoder
+static BenchInput make_input(const BenchCase &enc, const std::vector<int16_t> &speech)
+{
+    BenchInput in;
+    const int per_call = enc.samples * enc.batch;
+    in.frames = (speech.size() / per_call) * enc.batch;
+    in.pcm.assign(speech.begin(), speech.begin() + (in.frames * enc.samples));
+    in.bits.assign(in.frames * enc.bytes, 0);
+    enc.reset();
+    for(int f = 0; f < in.frames; f += enc.batch){
+        enc.run(&in.pcm[f * enc.samples], &in.bits[f * enc.bytes]);
+    }
+    return in;
+}
+
+static bool read_file(const std::string &path, std::vector<uint8_t> &data)
+{
+    FILE *fp = fopen(path.c_str(), "rb");
+    if(!fp){
+        return false;
+    }
+    data.clear();
+    uint8_t buf[4096];
+    size_t n;
+    while((n = fread(buf, 1, sizeof(buf), fp)) > 0){
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(fp);
+    return true;
+}
+
+static bool write_file(const std::string &path, const void *data, size_t len)
+{
+    FILE *fp = fopen(path.c_str(), "wb");
+    if(!fp){
+        return false;
+    }
+    const bool ok = fwrite(data, 1, len, fp) == len;
+    return (fclose(fp) == 0) && ok;
+}
+
+static std::string golden_path(const std::string &dir, const std::string &name)
+{
+    std::string file = name;
+    size_t p;
+    while((p = file.find("::")) != std::string::npos){
+        file.replace(p, 2, "_");
+    }
+    return dir + "/" + file + ".bin";
+}
+
+// One pass of every case from a fresh codec state. Decoders always read the
+// golden codewords of their encoder, so an encoder change does not show up
+// as a decoder failure too. Every codec keeps its noise state per instance
+// and is seeded the same way, so a result does not depend on which cases
+// ran before it and the filter applies here as well.
+static int run_golden(const std::vector<BenchCase> &cases, const std::vector<int16_t> &speech, const std::string &dir,
+                      bool record, const std::string &filter, double snr_min, double ber_max, FILE *out, bool &first)
+{
+    int failures = 0;
+    for(size_t c = 0; c < cases.size(); c++){
+        const BenchCase &bc = cases[c];
+        if(!filter.empty() && (bc.name.find(filter) == std::string::npos)){
+            continue;
+        }
+        const BenchCase &enc = bc.encoder ? bc : cases[c - 1];
+        const int per_call = bc.samples * bc.batch;
+        const int frames = (speech.size() / per_call) * bc.batch;
+        std::vector<int16_t> pcm(speech.begin(), speech.begin() + (frames * bc.samples));
+        std::vector<uint8_t> bits(frames * bc.bytes, 0);
+        const char *error = nullptr;
+
+        if(!bc.encoder){
+            std::vector<uint8_t> golden;
+            if(!read_file(golden_path(dir, enc.name), golden) || (golden.size() != bits.size())){
+                error = "missing or short codeword vector";
+            }
+            else{
+                bits = golden;
+            }
+        }
+
+        double ns = 0.0;
+        if(!error){
+            bc.reset();
+            const auto t0 = std::chrono::steady_clock::now();
+            for(int f = 0; f < frames; f += bc.batch){
+                bc.run(&pcm[f * bc.samples], &bits[f * bc.bytes]);
+            }
+            const auto t1 = std::chrono::steady_clock::now();
+            ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / frames;
+        }
+
+        const uint8_t *result = bc.encoder ? bits.data() : (const uint8_t *)pcm.data();
+        const size_t result_len = bc.encoder ? bits.size() : (pcm.size() * sizeof(int16_t));
+        const char *compare = bc.exact ? "exact" : (bc.encoder ? "ber" : "snr_db");
+        double value = 0.0;
+        bool pass = false;
+
+        if(error){
+            pass = false;
+        }
+        else if(record){
+            pass = write_file(golden_path(dir, bc.name), result, result_len);
+            if(!pass){
+                error = "cannot write golden vector";
+            }
+        }
+        else{
+            std::vector<uint8_t> golden;
+            if(!read_file(golden_path(dir, bc.name), golden) || (golden.size() != result_len)){
+                error = "missing or short golden vector";
+            }
+            else if(bc.exact){
+                for(size_t i = 0; i < result_len; i++){
+                    value += (golden[i] != result[i]);
+                }
+                pass = value == 0.0;
+            }
+            else if(bc.encoder){
+                for(size_t i = 0; i < result_len; i++){
+                    value += __builtin_popcount(golden[i] ^ result[i]);
+                }
+                value /= result_len * 8.0;
+                pass = value <= ber_max;
+            }
+            else{
+                const int16_t *ref = (const int16_t *)golden.data();
+                double sig = 0.0, noise = 0.0;
+                for(size_t i = 0; i < pcm.size(); i++){
+                    const double d = (double)pcm[i] - ref[i];
+                    sig += (double)ref[i] * ref[i];
+                    noise += d * d;
+                }
+                value = (noise > 0.0) ? std::min(150.0, 10.0 * log10(sig / noise)) : 150.0;
+                pass = value >= snr_min;
+            }
+        }
+        if(!pass){
+            failures++;
+        }
+
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"frames\": %d, \"ns_per_frame\": %.1f, \"compare\": \"%s\", ",
+                first ? "" : ",", bc.name.c_str(), frames, ns, compare);
+        if(record || error){
+            fprintf(out, "\"value\": null, ");
+        }
+        else{
+            fprintf(out, "\"value\": %.6g, ", value);
+        }
+        fprintf(out, "\"pass\": %s", pass ? "true" : "false");
+        if(error){
+            fprintf(out, ", \"error\": \"%s\"", error);
+        }
+        fprintf(out, "}");
+        fflush(out);
+        first = false;
+    }
+    return failures;
+}
+
+// The mbelib oscillator engines against MBE_SYNTH_REFERENCE over a long
+// stream, the corpus decoded over and over so the phase tracks run for
+// 2000 frames. Fails when any sample is further from the reference than
+// MBE_SYNTH_TOLERANCE of the reference peak.
+static int run_synth_check(const std::vector<int16_t> &speech, const std::string &filter, FILE *out, bool &first)
+{
+    static const struct { const char *name; int engine; } engines[] = {
+        {"mbe_synth::generic", MBE_SYNTH_GENERIC},
+        {"mbe_synth::sse2", MBE_SYNTH_SSE2},
+        {"mbe_synth::avx2", MBE_SYNTH_AVX2},
+    };
+    const int frames = 2000;
+    const int corpus_frames = speech.size() / 160;
+    std::vector<uint8_t> bits(corpus_frames * 7);
+    std::vector<int16_t> pcm(speech.begin(), speech.begin() + (corpus_frames * 160));
+    std::vector<int16_t> ref(frames * 160), res(frames * 160);
+    int failures = 0;
+
+    if(!corpus_frames){
+        return 0;
+    }
+    VocoderPlugin enc(0);
+    for(int f = 0; f < corpus_frames; f++){
+        enc.encode_2450(&pcm[f * 160], &bits[f * 7]);
+    }
+
+    auto decode = [&](std::vector<int16_t> &dst){
+        VocoderPlugin dec(0);
+        for(int f = 0; f < frames; f++){
+            dec.decode_2450(&dst[f * 160], &bits[(f % corpus_frames) * 7]);
+        }
+    };
+    mbe_setSynthesisEngine(MBE_SYNTH_REFERENCE);
+    decode(ref);
+    int peak = 1;
+    for(int16_t s : ref){
+        peak = std::max(peak, std::abs((int)s));
+    }
+
+    for(const auto &e : engines){
+        if(!filter.empty() && (std::string(e.name).find(filter) == std::string::npos)){
+            continue;
+        }
+        if(mbe_setSynthesisEngine(e.engine) != e.engine){
+            continue;   // not supported by this CPU
+        }
+        const auto t0 = std::chrono::steady_clock::now();
+        decode(res);
+        const auto t1 = std::chrono::steady_clock::now();
+        int worst = 0;
+        for(size_t i = 0; i < res.size(); i++){
+            worst = std::max(worst, std::abs(res[i] - ref[i]));
+        }
+        const double value = (double)worst / peak;
+        const bool pass = value <= MBE_SYNTH_TOLERANCE;
+        if(!pass){
+            failures++;
+        }
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"frames\": %d, \"ns_per_frame\": %.1f, \"compare\": \"rel_err\", \"value\": %.6g, \"pass\": %s}",
+                first ? "" : ",", e.name, frames, std::chrono::duration<double, std::nano>(t1 - t0).count() / frames,
+                value, pass ? "true" : "false");
+        fflush(out);
+        first = false;
+    }
+    mbe_setSynthesisEngine(MBE_SYNTH_AUTO);
+    return failures;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [--pcm file.raw] [--seconds N] [--repeat N] [--filter s] [--out file.json]\n"
+                    "       %s --record dir [--pcm file.raw] [--seconds N] [--filter s] [--out file.json]\n"
+                    "       %s --check dir [--snr dB] [--ber rate] [--filter s] [--out file.json]\n", argv0, argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+    std::string pcm_file;
+    std::string filter;
+    std::string out_file;
+    std::string record_dir;
+    std::string check_dir;
+    int seconds = 30;
+    int repeat = 3;
+    double snr_min = 30.0;
+    double ber_max = 0.01;
+
+    for(int i = 1; i < argc; i++){
+        std::string a = argv[i];
+        if((i + 1) >= argc){
+            usage(argv[0]);
+            return 1;
+        }
+        if(a == "--pcm") pcm_file = argv[++i];
+        else if(a == "--seconds") seconds = std::max(1, atoi(argv[++i]));
+        else if(a == "--repeat") repeat = std::max(1, atoi(argv[++i]));
+        else if(a == "--filter") filter = argv[++i];
+        else if(a == "--out") out_file = argv[++i];
+        else if(a == "--record") record_dir = argv[++i];
+        else if(a == "--check") check_dir = argv[++i];
+        else if(a == "--snr") snr_min = atof(argv[++i]);
+        else if(a == "--ber") ber_max = atof(argv[++i]);
+        else{
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(!record_dir.empty() && !check_dir.empty()){
+        usage(argv[0]);
+        return 1;
+    }
+    if(!check_dir.empty()){
+        pcm_file = check_dir + "/corpus.raw";
+    }
+
+    std::vector<int16_t> speech;
+    if(pcm_file.empty()){
+        speech = synth_speech(seconds);
+    }
+    else{
+        FILE *fp = fopen(pcm_file.c_str(), "rb");
+        if(!fp){
+            fprintf(stderr, "cannot open %s\n", pcm_file.c_str());
+            return 1;
+        }
+        int16_t buf[4096];
+        size_t n;
+        while((n = fread(buf, sizeof(int16_t), 4096, fp)) > 0){
+            speech.insert(speech.end(), buf, buf + n);
+        }
+        fclose(fp);
+    }
+
+    std::vector<BenchCase> cases;
+    add_vocoder_cases(cases);
+    add_imbe_cases(cases);
+    add_codec2_cases(cases);
+
+    FILE *out = out_file.empty() ? stdout : fopen(out_file.c_str(), "w");
+    if(!out){
+        fprintf(stderr, "cannot open %s\n", out_file.c_str());
+        return 1;
+    }
+
+    if(!record_dir.empty() || !check_dir.empty()){
+        const bool record = !record_dir.empty();
+        const std::string &dir = record ? record_dir : check_dir;
+        if(record && !write_file(dir + "/corpus.raw", speech.data(), speech.size() * sizeof(int16_t))){
+            fprintf(stderr, "cannot write %s/corpus.raw\n", dir.c_str());
+            return 1;
+        }
+        fprintf(out, "{\n  \"benchmark\": \"vocoder\",\n  \"mode\": \"%s\",\n  \"golden\": \"%s\",\n  \"corpus_seconds\": %.2f,\n  \"results\": [",
+                record ? "record" : "check", dir.c_str(), speech.size() / 8000.0);
+        bool first = true;
+        int failures = run_golden(cases, speech, dir, record, filter, snr_min, ber_max, out, first);
+        if(!record){
+            failures += run_synth_check(speech, filter, out, first);
+        }
+        fprintf(out, "\n  ],\n  \"failures\": %d\n}\n", failures);
+        if(out != stdout){
+            fclose(out);
+        }
+        return failures ? 2 : 0;
+    }
+
+    CacheMissCounter misses;
+    fprintf(out, "{\n  \"benchmark\": \"vocoder\",\n  \"corpus\": \"%s\",\n  \"corpus_seconds\": %.2f,\n  \"repeat\": %d,\n  \"results\": [",
+            pcm_file.empty() ? "synthetic" : pcm_file.c_str(), speech.size() / 8000.0, repeat);
+
+    bool first = true;
+    for(size_t c = 0; c < cases.size(); c++){
+        const BenchCase &bc = cases[c];
+        if(!filter.empty() && (bc.name.find(filter) == std::string::npos)){
+            continue;
+        }
+        // decoders take the codewords of the encoder registered just before them
+        const BenchCase &enc = bc.encoder ? bc : cases[c - 1];
+        BenchInput in = make_input(enc, speech);
+        std::vector<int16_t> pcm(in.pcm);
+
+        bc.reset();
+        for(int f = 0; f < in.frames; f += bc.batch){         // warm up, lazy tables
+            bc.run(&pcm[f * bc.samples], &in.bits[f * bc.bytes]);
+        }
+        if(bc.encoder){
+            pcm = in.pcm;
+        }
+
+        const unsigned long long allocs = g_allocs;
+        misses.start();
+        const auto t0 = std::chrono::steady_clock::now();
+        for(int r = 0; r < repeat; r++){
+            for(int f = 0; f < in.frames; f += bc.batch){
+                bc.run(&pcm[f * bc.samples], &in.bits[f * bc.bytes]);
+            }
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        const long long cache_misses = misses.stop();
+        const unsigned long long alloc_count = g_allocs - allocs;
+
+        const double frames = (double)in.frames * repeat;
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / frames;
+        const double frame_ns = bc.samples * 1e9 / 8000.0;
+
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"frames\": %d, \"ns_per_frame\": %.1f, \"rtf\": %.6f, \"frames_per_sec_core\": %.1f, ",
+                first ? "" : ",", bc.name.c_str(), in.frames, ns, ns / frame_ns, 1e9 / ns);
+        if(cache_misses >= 0){
+            fprintf(out, "\"cache_misses_per_frame\": %.2f, ", cache_misses / frames);
+        }
+        else{
+            fprintf(out, "\"cache_misses_per_frame\": null, ");
+        }
+#ifdef BENCH_COUNTS_ALLOCS
+        fprintf(out, "\"allocs_per_frame\": %.3f}", alloc_count / frames);
+#else
+        (void)alloc_count;
+        fprintf(out, "\"allocs_per_frame\": null}");
+#endif
+        fflush(out);
+        first = false;
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if(out != stdout){
+        fclose(out);
+    }
+    return 0;
+}
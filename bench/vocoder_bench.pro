@@ -0,0 +1,52 @@
+# Standalone codec benchmark, see vocoder_bench.cpp
+#   qmake bench/vocoder_bench.pro && make && ./vocoder_bench --out bench.json
+#   ./vocoder_bench --check bench/golden
+
+TEMPLATE = app
+TARGET = vocoder_bench
+CONFIG += console c++17
+CONFIG -= qt app_bundle
+INCLUDEPATH += ..
+!win32:LIBS += -lm
+
+SOURCES += \
+	vocoder_bench.cpp \
+	../codec2/codebooks.cpp \
+	../codec2/codec2.cpp \
+	../codec2/kiss_fft.cpp \
+	../codec2/lpc.cpp \
+	../codec2/nlp.cpp \
+	../codec2/pack.cpp \
+	../codec2/qbase.cpp \
+	../codec2/quantise.cpp \
+	../imbe_vocoder/aux_sub.cc \
+	../imbe_vocoder/basicop2.cc \
+	../imbe_vocoder/ch_decode.cc \
+	../imbe_vocoder/ch_encode.cc \
+	../imbe_vocoder/dc_rmv.cc \
+	../imbe_vocoder/decode.cc \
+	../imbe_vocoder/dsp_sub.cc \
+	../imbe_vocoder/encode.cc \
+	../imbe_vocoder/imbe_vocoder.cc \
+	../imbe_vocoder/imbe_vocoder_impl.cc \
+	../imbe_vocoder/math_sub.cc \
+	../imbe_vocoder/pe_lpf.cc \
+	../imbe_vocoder/pitch_est.cc \
+	../imbe_vocoder/pitch_ref.cc \
+	../imbe_vocoder/qnt_sub.cc \
+	../imbe_vocoder/rand_gen.cc \
+	../imbe_vocoder/sa_decode.cc \
+	../imbe_vocoder/sa_encode.cc \
+	../imbe_vocoder/sa_enh.cc \
+	../imbe_vocoder/tbls.cc \
+	../imbe_vocoder/uv_synt.cc \
+	../imbe_vocoder/v_synt.cc \
+	../imbe_vocoder/v_uv_det.cc \
+	../mbe/ambe3600x2400.c \
+	../mbe/ambe3600x2450.c \
+	../mbe/ambe_framing.cpp \
+	../mbe/ambe_quant.cpp \
+	../mbe/ecc.c \
+	../mbe/mbelib.c \
+	../mbe/mbe_synth.c \
+	../mbe/vocoder_plugin.cpp
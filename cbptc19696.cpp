@@ -26,6 +26,24 @@
 #include <cassert>
 #include <cstring>
 
+// Position in the 33 byte burst, MSB first, of each bit of the 13x15
+// matrix, row by row. Bit 0 of the deinterleaved data is R(3), which is
+// not used, so the matrix starts at bit 1.
+static const uint16_t INTERLEAVE_TABLE[] = {
+	249U, 234U, 219U, 204U, 189U, 174U,  91U,  76U,  61U,  46U,  31U,  16U,   1U, 250U, 235U,
+	220U, 205U, 190U, 175U,  92U,  77U,  62U,  47U,  32U,  17U,   2U, 251U, 236U, 221U, 206U,
+	191U, 176U,  93U,  78U,  63U,  48U,  33U,  18U,   3U, 252U, 237U, 222U, 207U, 192U, 177U,
+	 94U,  79U,  64U,  49U,  34U,  19U,   4U, 253U, 238U, 223U, 208U, 193U, 178U,  95U,  80U,
+	 65U,  50U,  35U,  20U,   5U, 254U, 239U, 224U, 209U, 194U, 179U,  96U,  81U,  66U,  51U,
+	 36U,  21U,   6U, 255U, 240U, 225U, 210U, 195U, 180U,  97U,  82U,  67U,  52U,  37U,  22U,
+	  7U, 256U, 241U, 226U, 211U, 196U, 181U, 166U,  83U,  68U,  53U,  38U,  23U,   8U, 257U,
+	242U, 227U, 212U, 197U, 182U, 167U,  84U,  69U,  54U,  39U,  24U,   9U, 258U, 243U, 228U,
+	213U, 198U, 183U, 168U,  85U,  70U,  55U,  40U,  25U,  10U, 259U, 244U, 229U, 214U, 199U,
+	184U, 169U,  86U,  71U,  56U,  41U,  26U,  11U, 260U, 245U, 230U, 215U, 200U, 185U, 170U,
+	 87U,  72U,  57U,  42U,  27U,  12U, 261U, 246U, 231U, 216U, 201U, 186U, 171U,  88U,  73U,
+	 58U,  43U,  28U,  13U, 262U, 247U, 232U, 217U, 202U, 187U, 172U,  89U,  74U,  59U,  44U,
+	 29U,  14U, 263U, 248U, 233U, 218U, 203U, 188U, 173U,  90U,  75U,  60U,  45U,  30U,  15U};
+
 CBPTC19696::CBPTC19696()
 {
 }
@@ -34,337 +52,127 @@ CBPTC19696::~CBPTC19696()
 {
 }
 
-// The main decode function
-void CBPTC19696::decode(const uint8_t* in, uint8_t* out)
+// The main decode function, returns the number of corrected bits
+uint32_t CBPTC19696::decode(const uint8_t* in, uint8_t* out)
 {
-    assert(in != NULL);
-    assert(out != NULL);
-    
-    //  Get the raw binary
-    decodeExtractBinary(in);
-    
-    // Deinterleave
-    decodeDeInterleave();
-    
-    // Error check
-    decodeErrorCheck();
-    
-    // Extract Data
-    decodeExtractData(out);
+	assert(in != NULL);
+	assert(out != NULL);
+
+	// Deinterleave straight from the burst
+	decodeDeInterleave(in);
+
+	// Error check
+	uint32_t errs = decodeErrorCheck();
+
+	// Extract Data
+	decodeExtractData(out);
+
+	return errs;
 }
 
 // The main encode function
 void CBPTC19696::encode(const uint8_t* in, uint8_t* out)
 {
-    assert(in != NULL);
-    assert(out != NULL);
-    
-    // Extract Data
-    encodeExtractData(in);
-    
-    // Error check
-    encodeErrorCheck();
-    
-    // Deinterleave
-    encodeInterleave();
-    
-    //  Get the raw binary
-    encodeExtractBinary(out);
-}
-
-void CBPTC19696::byteToBitsBE(uint8_t byte, bool* bits)
-{
-	assert(bits != NULL);
+	assert(in != NULL);
+	assert(out != NULL);
 
-	bits[0U] = (byte & 0x80U) == 0x80U;
-	bits[1U] = (byte & 0x40U) == 0x40U;
-	bits[2U] = (byte & 0x20U) == 0x20U;
-	bits[3U] = (byte & 0x10U) == 0x10U;
-	bits[4U] = (byte & 0x08U) == 0x08U;
-	bits[5U] = (byte & 0x04U) == 0x04U;
-	bits[6U] = (byte & 0x02U) == 0x02U;
-	bits[7U] = (byte & 0x01U) == 0x01U;
-}
+	// Extract Data
+	encodeExtractData(in);
 
-void CBPTC19696::bitsToByteBE(bool* bits, uint8_t& byte)
-{
-	assert(bits != NULL);
+	// Error check
+	encodeErrorCheck();
 
-	byte  = bits[0U] ? 0x80U : 0x00U;
-	byte |= bits[1U] ? 0x40U : 0x00U;
-	byte |= bits[2U] ? 0x20U : 0x00U;
-	byte |= bits[3U] ? 0x10U : 0x00U;
-	byte |= bits[4U] ? 0x08U : 0x00U;
-	byte |= bits[5U] ? 0x04U : 0x00U;
-	byte |= bits[6U] ? 0x02U : 0x00U;
-	byte |= bits[7U] ? 0x01U : 0x00U;
+	// Interleave into the burst
+	encodeInterleave(out);
 }
 
-void CBPTC19696::decodeExtractBinary(const uint8_t* in)
+void CBPTC19696::decodeDeInterleave(const uint8_t* in)
 {
-    // First block
-	byteToBitsBE(in[0U],  m_rawData + 0U);
-	byteToBitsBE(in[1U],  m_rawData + 8U);
-	byteToBitsBE(in[2U],  m_rawData + 16U);
-	byteToBitsBE(in[3U],  m_rawData + 24U);
-	byteToBitsBE(in[4U],  m_rawData + 32U);
-	byteToBitsBE(in[5U],  m_rawData + 40U);
-	byteToBitsBE(in[6U],  m_rawData + 48U);
-	byteToBitsBE(in[7U],  m_rawData + 56U);
-	byteToBitsBE(in[8U],  m_rawData + 64U);
-	byteToBitsBE(in[9U],  m_rawData + 72U);
-	byteToBitsBE(in[10U], m_rawData + 80U);
-	byteToBitsBE(in[11U], m_rawData + 88U);
-	byteToBitsBE(in[12U], m_rawData + 96U);
-    
-    // Handle the two bits
-    bool bits[8U];
-	byteToBitsBE(in[20U], bits);
-    m_rawData[98U] = bits[6U];
-    m_rawData[99U] = bits[7U];
-    
-    // Second block
-	byteToBitsBE(in[21U], m_rawData + 100U);
-	byteToBitsBE(in[22U], m_rawData + 108U);
-	byteToBitsBE(in[23U], m_rawData + 116U);
-	byteToBitsBE(in[24U], m_rawData + 124U);
-	byteToBitsBE(in[25U], m_rawData + 132U);
-	byteToBitsBE(in[26U], m_rawData + 140U);
-	byteToBitsBE(in[27U], m_rawData + 148U);
-	byteToBitsBE(in[28U], m_rawData + 156U);
-	byteToBitsBE(in[29U], m_rawData + 164U);
-	byteToBitsBE(in[30U], m_rawData + 172U);
-	byteToBitsBE(in[31U], m_rawData + 180U);
-	byteToBitsBE(in[32U], m_rawData + 188U);
-}
+	const uint16_t* t = INTERLEAVE_TABLE;
 
-// Deinterleave the raw data
-void CBPTC19696::decodeDeInterleave()
-{
-	for (uint32_t i = 0U; i < 196U; i++)
-        m_deInterData[i] = false;
-    
-    // The first bit is R(3) which is not used so can be ignored
-	for (uint32_t a = 0U; a < 196U; a++)	{
-        // Calculate the interleave sequence
-		uint32_t interleaveSequence = (a * 181U) % 196U;
-        // Shuffle the data
-        m_deInterData[a] = m_rawData[interleaveSequence];
-    }
+	for (uint32_t r = 0U; r < 13U; r++) {
+		uint32_t w = 0U;
+		for (uint32_t c = 0U; c < 15U; c++, t++)
+			w = (w << 1) | ((in[*t >> 3] >> (7U - (*t & 7U))) & 1U);
+		m_rows[r] = w;
+	}
 }
 
-// Check each row with a Hamming (15,11,3) code and each column with a Hamming (13,9,3) code
-void CBPTC19696::decodeErrorCheck()
+// Check each column with a Hamming (13,9,3) code and each data row with a Hamming (15,11,3) code
+uint32_t CBPTC19696::decodeErrorCheck()
 {
-    bool fixing;
+	uint32_t errs = 0U;
+	uint32_t fixed;
 	uint32_t count = 0U;
-    do {
-        fixing = false;
-        
-        // Run through each of the 15 columns
-        bool col[13U];
-		for (uint32_t c = 0U; c < 15U; c++) {
-			uint32_t pos = c + 1U;
-			for (uint32_t a = 0U; a < 13U; a++) {
-                col[a] = m_deInterData[pos];
-                pos = pos + 15U;
-            }
-            
-            if (CHamming::decode1393(col)) {
-				uint32_t pos = c + 1U;
-				for (uint32_t a = 0U; a < 13U; a++) {
-                    m_deInterData[pos] = col[a];
-                    pos = pos + 15U;
-                }
-                
-                fixing = true;
-            }
-        }
-        
-        // Run through each of the 9 rows containing data
-		for (uint32_t r = 0U; r < 9U; r++) {
-			uint32_t pos = (r * 15U) + 1U;
-            if (CHamming::decode15113_2(m_deInterData + pos))
-                fixing = true;
-        }
-        
-        count++;
-    } while (fixing && count < 5U);
+	do {
+		// All 15 columns at once, the rows hold them bit sliced
+		fixed = CHamming::decode1393Sliced(m_rows);
+
+		// Run through each of the 9 rows containing data
+		fixed += CHamming::decode15113_2(m_rows, 9U);
+
+		errs += fixed;
+		count++;
+	} while (fixed > 0U && count < 5U);
+
+	return errs;
 }
 
-// Extract the 96 bits of payload
-void CBPTC19696::decodeExtractData(uint8_t* data)
+// Extract the 96 bits of payload, bits 3 to 10 of row 0 then bits 0 to 10 of rows 1 to 8
+void CBPTC19696::decodeExtractData(uint8_t* data) const
 {
-    bool bData[96U];
-	uint32_t pos = 0U;
-	for(uint32_t a = 4U; a <= 11U; a++, pos++){
-        bData[pos] = m_deInterData[a];
+	uint32_t acc = (m_rows[0U] >> 4) & 0xFFU;
+	uint32_t bits = 8U;
+	uint32_t n = 0U;
+
+	for (uint32_t r = 1U; r < 9U; r++) {
+		acc = (acc << 11) | ((m_rows[r] >> 4) & 0x7FFU);
+		bits += 11U;
+		while (bits >= 8U) {
+			bits -= 8U;
+			data[n++] = (acc >> bits) & 0xFFU;
+		}
 	}
-	for(uint32_t a = 16U; a <= 26U; a++, pos++){
-        bData[pos] = m_deInterData[a];
-	}
-	for(uint32_t a = 31U; a <= 41U; a++, pos++){
-        bData[pos] = m_deInterData[a];
-	}
-	for(uint32_t a = 46U; a <= 56U; a++, pos++){
-        bData[pos] = m_deInterData[a];
-	}
-	for(uint32_t a = 61U; a <= 71U; a++, pos++){
-        bData[pos] = m_deInterData[a];
-	}
-	for(uint32_t a = 76U; a <= 86U; a++, pos++){
-        bData[pos] = m_deInterData[a];
-	}
-	for(uint32_t a = 91U; a <= 101U; a++, pos++){
-        bData[pos] = m_deInterData[a];
-	}
-	for(uint32_t a = 106U; a <= 116U; a++, pos++){
-        bData[pos] = m_deInterData[a];
-	}
-	for(uint32_t a = 121U; a <= 131U; a++, pos++){
-        bData[pos] = m_deInterData[a];
-	}
-
-	bitsToByteBE(bData + 0U,  data[0U]);
-	bitsToByteBE(bData + 8U,  data[1U]);
-	bitsToByteBE(bData + 16U, data[2U]);
-	bitsToByteBE(bData + 24U, data[3U]);
-	bitsToByteBE(bData + 32U, data[4U]);
-	bitsToByteBE(bData + 40U, data[5U]);
-	bitsToByteBE(bData + 48U, data[6U]);
-	bitsToByteBE(bData + 56U, data[7U]);
-	bitsToByteBE(bData + 64U, data[8U]);
-	bitsToByteBE(bData + 72U, data[9U]);
-	bitsToByteBE(bData + 80U, data[10U]);
-	bitsToByteBE(bData + 88U, data[11U]);
 }
 
-// Extract the 96 bits of payload
+// Place the 96 bits of payload in rows 0 to 8, right aligned until the row parity is added
 void CBPTC19696::encodeExtractData(const uint8_t* in)
 {
-    bool bData[96U];
-	byteToBitsBE(in[0U],  bData + 0U);
-	byteToBitsBE(in[1U],  bData + 8U);
-	byteToBitsBE(in[2U],  bData + 16U);
-	byteToBitsBE(in[3U],  bData + 24U);
-	byteToBitsBE(in[4U],  bData + 32U);
-	byteToBitsBE(in[5U],  bData + 40U);
-	byteToBitsBE(in[6U],  bData + 48U);
-	byteToBitsBE(in[7U],  bData + 56U);
-	byteToBitsBE(in[8U],  bData + 64U);
-	byteToBitsBE(in[9U],  bData + 72U);
-	byteToBitsBE(in[10U], bData + 80U);
-	byteToBitsBE(in[11U], bData + 88U);
-    
-	for (uint32_t i = 0U; i < 196U; i++)
-        m_deInterData[i] = false;
-    
-	uint32_t pos = 0U;
-	for (uint32_t a = 4U; a <= 11U; a++, pos++)
-        m_deInterData[a] = bData[pos];
-    
-	for (uint32_t a = 16U; a <= 26U; a++, pos++)
-        m_deInterData[a] = bData[pos];
-    
-	for (uint32_t a = 31U; a <= 41U; a++, pos++)
-        m_deInterData[a] = bData[pos];
-    
-	for (uint32_t a = 46U; a <= 56U; a++, pos++)
-        m_deInterData[a] = bData[pos];
-    
-	for (uint32_t a = 61U; a <= 71U; a++, pos++)
-        m_deInterData[a] = bData[pos];
-    
-	for (uint32_t a = 76U; a <= 86U; a++, pos++)
-        m_deInterData[a] = bData[pos];
-    
-	for (uint32_t a = 91U; a <= 101U; a++, pos++)
-        m_deInterData[a] = bData[pos];
-    
-	for (uint32_t a = 106U; a <= 116U; a++, pos++)
-        m_deInterData[a] = bData[pos];
-    
-	for (uint32_t a = 121U; a <= 131U; a++, pos++)
-        m_deInterData[a] = bData[pos];
-}
+	uint32_t acc = 0U;
+	uint32_t bits = 0U;
+	uint32_t n = 0U;
 
-// Check each row with a Hamming (15,11,3) code and each column with a Hamming (13,9,3) code
-void CBPTC19696::encodeErrorCheck()
-{
-    
-    // Run through each of the 9 rows containing data
 	for (uint32_t r = 0U; r < 9U; r++) {
-		uint32_t pos = (r * 15U) + 1U;
-        CHamming::encode15113_2(m_deInterData + pos);
-    }
-    
-    // Run through each of the 15 columns
-    bool col[13U];
-	for (uint32_t c = 0U; c < 15U; c++) {
-		uint32_t pos = c + 1U;
-		for (uint32_t a = 0U; a < 13U; a++) {
-            col[a] = m_deInterData[pos];
-            pos = pos + 15U;
-        }
-        
-        CHamming::encode1393(col);
-        
-        pos = c + 1U;
-		for (uint32_t a = 0U; a < 13U; a++) {
-            m_deInterData[pos] = col[a];
-            pos = pos + 15U;
-        }
-    }
+		uint32_t want = (r == 0U) ? 8U : 11U;
+		while (bits < want) {
+			acc = (acc << 8) | in[n++];
+			bits += 8U;
+		}
+		bits -= want;
+		m_rows[r] = (acc >> bits) & ((1U << want) - 1U);
+	}
 }
 
-// Interleave the raw data
-void CBPTC19696::encodeInterleave()
+// Hamming (15,11,3) encode the 9 data rows, then the column parity rows of all 15 columns at once
+void CBPTC19696::encodeErrorCheck()
 {
-	for (uint32_t i = 0U; i < 196U; i++)
-        m_rawData[i] = false;
-    
-    // The first bit is R(3) which is not used so can be ignored
-	for (uint32_t a = 0U; a < 196U; a++)	{
-        // Calculate the interleave sequence
-		uint32_t interleaveSequence = (a * 181U) % 196U;
-        // Unshuffle the data
-        m_rawData[interleaveSequence] = m_deInterData[a];
-    }
+	CHamming::encode15113_2(m_rows, m_rows, 9U);
+	CHamming::encode1393Sliced(m_rows);
 }
 
-void CBPTC19696::encodeExtractBinary(uint8_t* data)
+// Interleave the matrix into the burst, keeping the bits between the two halves
+void CBPTC19696::encodeInterleave(uint8_t* data) const
 {
-    // First block
-	bitsToByteBE(m_rawData + 0U,  data[0U]);
-	bitsToByteBE(m_rawData + 8U,  data[1U]);
-	bitsToByteBE(m_rawData + 16U, data[2U]);
-	bitsToByteBE(m_rawData + 24U, data[3U]);
-	bitsToByteBE(m_rawData + 32U, data[4U]);
-	bitsToByteBE(m_rawData + 40U, data[5U]);
-	bitsToByteBE(m_rawData + 48U, data[6U]);
-	bitsToByteBE(m_rawData + 56U, data[7U]);
-	bitsToByteBE(m_rawData + 64U, data[8U]);
-	bitsToByteBE(m_rawData + 72U, data[9U]);
-	bitsToByteBE(m_rawData + 80U, data[10U]);
-	bitsToByteBE(m_rawData + 88U, data[11U]);
-    
-    // Handle the two bits
-	uint8_t byte;
-	bitsToByteBE(m_rawData + 96U, byte);
-    data[12U] = (data[12U] & 0x3FU) | ((byte >> 0) & 0xC0U);
-    data[20U] = (data[20U] & 0xFCU) | ((byte >> 4) & 0x03U);
-    
-    // Second block
-	bitsToByteBE(m_rawData + 100U,  data[21U]);
-	bitsToByteBE(m_rawData + 108U,  data[22U]);
-	bitsToByteBE(m_rawData + 116U,  data[23U]);
-	bitsToByteBE(m_rawData + 124U,  data[24U]);
-	bitsToByteBE(m_rawData + 132U,  data[25U]);
-	bitsToByteBE(m_rawData + 140U,  data[26U]);
-	bitsToByteBE(m_rawData + 148U,  data[27U]);
-	bitsToByteBE(m_rawData + 156U,  data[28U]);
-	bitsToByteBE(m_rawData + 164U,  data[29U]);
-	bitsToByteBE(m_rawData + 172U,  data[30U]);
-	bitsToByteBE(m_rawData + 180U,  data[31U]);
-	bitsToByteBE(m_rawData + 188U,  data[32U]);
+	::memset(data, 0x00U, 12U);
+	data[12U] &= 0x3FU;
+	data[20U] &= 0xFCU;
+	::memset(data + 21U, 0x00U, 12U);
+
+	const uint16_t* t = INTERLEAVE_TABLE;
+	for (uint32_t r = 0U; r < 13U; r++) {
+		for (uint32_t c = 0U; c < 15U; c++, t++) {
+			if (m_rows[r] & (0x4000U >> c))
+				data[*t >> 3] |= 0x80U >> (*t & 7U);
+		}
+	}
 }
@@ -26,25 +26,20 @@ public:
     CBPTC19696();
     ~CBPTC19696();
     
-	void decode(const uint8_t* in, uint8_t* out);
+	uint32_t decode(const uint8_t* in, uint8_t* out);
     
 	void encode(const uint8_t* in, uint8_t* out);
     
 private:
-    bool m_rawData[196];
-    bool m_deInterData[196];
+	uint16_t m_rows[13U];	// 15 bit rows of the 13x15 matrix, column 0 in bit 14
     
-	void decodeExtractBinary(const uint8_t* in);
-    void decodeErrorCheck();
-    void decodeDeInterleave();
-	void decodeExtractData(uint8_t* data);
+	void decodeDeInterleave(const uint8_t* in);
+	uint32_t decodeErrorCheck();
+	void decodeExtractData(uint8_t* data) const;
     
 	void encodeExtractData(const uint8_t* in);
-    void encodeInterleave();
-    void encodeErrorCheck();
-	void encodeExtractBinary(uint8_t* data);
-	void byteToBitsBE(uint8_t byte, bool* bits);
-	void bitsToByteBE(bool* bits, uint8_t& byte);
+	void encodeErrorCheck();
+	void encodeInterleave(uint8_t* data) const;
 };
 
 #endif
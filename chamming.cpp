@@ -347,3 +347,246 @@ void CHamming::encode17123(bool* d)
     d[15] = d[0] ^ d[1] ^ d[4] ^ d[5] ^ d[7] ^ d[10];
     d[16] = d[0] ^ d[1] ^ d[2] ^ d[5] ^ d[6] ^ d[8] ^ d[11];
 }
+
+// Parity check masks of the packed codewords, one per parity bit, and the
+// bit to flip for each syndrome, 0 where the syndrome can't be corrected
+static const uint32_t CHECK_15113_1[] = {0x7F08U, 0x78E4U, 0x66D2U, 0x55B1U};
+static const uint32_t FIX_15113_1[] = {
+    0x0000U, 0x0008U, 0x0004U, 0x0800U, 0x0002U, 0x0200U, 0x0040U, 0x2000U,
+    0x0001U, 0x0100U, 0x0020U, 0x1000U, 0x0010U, 0x0400U, 0x0080U, 0x4000U};
+
+static const uint32_t CHECK_15113_2[] = {0x7AC8U, 0x3D64U, 0x1EB2U, 0x7591U};
+static const uint32_t FIX_15113_2[] = {
+    0x0000U, 0x0008U, 0x0004U, 0x0040U, 0x0002U, 0x0200U, 0x0020U, 0x0800U,
+    0x0001U, 0x4000U, 0x0100U, 0x2000U, 0x0010U, 0x0080U, 0x0400U, 0x1000U};
+
+static const uint32_t CHECK_1393[] = {0x1AC8U, 0x1D64U, 0x1EB2U, 0x1591U};
+static const uint32_t FIX_1393[] = {
+    0x0000U, 0x0008U, 0x0004U, 0x0040U, 0x0002U, 0x0200U, 0x0020U, 0x0800U,
+    0x0001U, 0x0000U, 0x0100U, 0x0000U, 0x0010U, 0x0080U, 0x0400U, 0x1000U};
+
+static const uint32_t CHECK_1063[] = {0x0398U, 0x0354U, 0x02E2U, 0x01E1U};
+static const uint32_t FIX_1063[] = {
+    0x0000U, 0x0008U, 0x0004U, 0x0010U, 0x0002U, 0x0000U, 0x0000U, 0x0200U,
+    0x0001U, 0x0000U, 0x0000U, 0x0100U, 0x0020U, 0x0080U, 0x0040U, 0x0000U};
+
+static const uint32_t CHECK_16114[] = {0xF590U, 0x7AC8U, 0x3D64U, 0xEB22U, 0xA6E1U};
+static const uint32_t FIX_16114[] = {
+    0x0000U, 0x0010U, 0x0008U, 0x0000U, 0x0004U, 0x0000U, 0x0000U, 0x1000U,
+    0x0002U, 0x0000U, 0x0000U, 0x4000U, 0x0000U, 0x0100U, 0x0800U, 0x0000U,
+    0x0001U, 0x0000U, 0x0000U, 0x0080U, 0x0000U, 0x0400U, 0x0040U, 0x0000U,
+    0x0000U, 0x8000U, 0x0200U, 0x0000U, 0x0020U, 0x0000U, 0x0000U, 0x2000U};
+
+static const uint32_t CHECK_17123[] = {0x1E690U, 0x1F348U, 0x0F9A4U, 0x19A42U, 0x1CD21U};
+static const uint32_t FIX_17123[] = {
+    0x00000U, 0x00010U, 0x00008U, 0x00000U, 0x00004U, 0x00080U, 0x00000U, 0x02000U,
+    0x00002U, 0x00000U, 0x00040U, 0x00200U, 0x00000U, 0x00000U, 0x01000U, 0x00000U,
+    0x00001U, 0x00400U, 0x00000U, 0x00000U, 0x00020U, 0x00000U, 0x00100U, 0x04000U,
+    0x00000U, 0x00000U, 0x00000U, 0x10000U, 0x00800U, 0x00000U, 0x00000U, 0x08000U};
+
+static inline uint32_t parity(uint32_t v)
+{
+    v ^= v >> 16;
+    v ^= v >> 8;
+    v ^= v >> 4;
+    
+    return (0x6996U >> (v & 0x0FU)) & 1U;
+}
+
+// Bit i of the syndrome is the check of parity bit i
+static inline uint32_t syndrome(uint32_t word, const uint32_t* checks, uint32_t p)
+{
+    uint32_t n = 0U;
+    for (uint32_t i = 0U; i < p; i++)
+        n |= parity(word & checks[i]) << i;
+    
+    return n;
+}
+
+// With the parity bits clear the syndrome is the parity bits, last one lowest
+static inline uint32_t encode(uint32_t data, const uint32_t* checks, uint32_t p)
+{
+    uint32_t word = data << p;
+    for (uint32_t i = 0U; i < p; i++)
+        word |= parity(word & checks[i]) << (p - 1U - i);
+    
+    return word;
+}
+
+uint32_t CHamming::encode15113_1(uint32_t data)
+{
+    return encode(data & 0x7FFU, CHECK_15113_1, 4U);
+}
+
+bool CHamming::decode15113_1(uint32_t& word)
+{
+    uint32_t n = syndrome(word, CHECK_15113_1, 4U);
+    word ^= FIX_15113_1[n];
+    
+    return n != 0U;
+}
+
+uint32_t CHamming::encode15113_2(uint32_t data)
+{
+    return encode(data & 0x7FFU, CHECK_15113_2, 4U);
+}
+
+bool CHamming::decode15113_2(uint32_t& word)
+{
+    uint32_t n = syndrome(word, CHECK_15113_2, 4U);
+    word ^= FIX_15113_2[n];
+    
+    return n != 0U;
+}
+
+uint32_t CHamming::encode1393(uint32_t data)
+{
+    return encode(data & 0x1FFU, CHECK_1393, 4U);
+}
+
+bool CHamming::decode1393(uint32_t& word)
+{
+    uint32_t fix = FIX_1393[syndrome(word, CHECK_1393, 4U)];
+    word ^= fix;
+    
+    return fix != 0U;
+}
+
+uint32_t CHamming::encode1063(uint32_t data)
+{
+    return encode(data & 0x3FU, CHECK_1063, 4U);
+}
+
+bool CHamming::decode1063(uint32_t& word)
+{
+    uint32_t fix = FIX_1063[syndrome(word, CHECK_1063, 4U)];
+    word ^= fix;
+    
+    return fix != 0U;
+}
+
+uint32_t CHamming::encode16114(uint32_t data)
+{
+    return encode(data & 0x7FFU, CHECK_16114, 5U);
+}
+
+bool CHamming::decode16114(uint32_t& word)
+{
+    uint32_t n = syndrome(word, CHECK_16114, 5U);
+    word ^= FIX_16114[n];
+    
+    return n == 0U || FIX_16114[n] != 0U;
+}
+
+uint32_t CHamming::encode17123(uint32_t data)
+{
+    return encode(data & 0xFFFU, CHECK_17123, 5U);
+}
+
+bool CHamming::decode17123(uint32_t& word)
+{
+    uint32_t n = syndrome(word, CHECK_17123, 5U);
+    word ^= FIX_17123[n];
+    
+    return n == 0U || FIX_17123[n] != 0U;
+}
+
+void CHamming::encode15113_1(const uint16_t* in, uint16_t* out, uint32_t n)
+{
+    assert(in != NULL);
+    assert(out != NULL);
+    
+    for (uint32_t i = 0U; i < n; i++)
+        out[i] = encode(in[i] & 0x7FFU, CHECK_15113_1, 4U);
+}
+
+uint32_t CHamming::decode15113_1(uint16_t* words, uint32_t n)
+{
+    assert(words != NULL);
+    
+    uint32_t count = 0U;
+    for (uint32_t i = 0U; i < n; i++) {
+        uint32_t s = syndrome(words[i], CHECK_15113_1, 4U);
+        words[i] ^= FIX_15113_1[s];
+        count += (s != 0U) ? 1U : 0U;
+    }
+    
+    return count;
+}
+
+void CHamming::encode15113_2(const uint16_t* in, uint16_t* out, uint32_t n)
+{
+    assert(in != NULL);
+    assert(out != NULL);
+    
+    for (uint32_t i = 0U; i < n; i++)
+        out[i] = encode(in[i] & 0x7FFU, CHECK_15113_2, 4U);
+}
+
+uint32_t CHamming::decode15113_2(uint16_t* words, uint32_t n)
+{
+    assert(words != NULL);
+    
+    uint32_t count = 0U;
+    for (uint32_t i = 0U; i < n; i++) {
+        uint32_t s = syndrome(words[i], CHECK_15113_2, 4U);
+        words[i] ^= FIX_15113_2[s];
+        count += (s != 0U) ? 1U : 0U;
+    }
+    
+    return count;
+}
+
+void CHamming::encode16114(const uint16_t* in, uint16_t* out, uint32_t n)
+{
+    assert(in != NULL);
+    assert(out != NULL);
+    
+    for (uint32_t i = 0U; i < n; i++)
+        out[i] = encode(in[i] & 0x7FFU, CHECK_16114, 5U);
+}
+
+// Each row word holds one codeword bit of 16 columns, so the checks are
+// done for every column at once with word XORs
+void CHamming::encode1393Sliced(uint16_t* rows)
+{
+    assert(rows != NULL);
+    
+    uint16_t* d = rows;
+    d[9]  = d[0] ^ d[1] ^ d[3] ^ d[5] ^ d[6];
+    d[10] = d[0] ^ d[1] ^ d[2] ^ d[4] ^ d[6] ^ d[7];
+    d[11] = d[0] ^ d[1] ^ d[2] ^ d[3] ^ d[5] ^ d[7] ^ d[8];
+    d[12] = d[0] ^ d[2] ^ d[4] ^ d[5] ^ d[8];
+}
+
+uint32_t CHamming::decode1393Sliced(uint16_t* rows)
+{
+    assert(rows != NULL);
+    
+    uint16_t* d = rows;
+    uint32_t s0 = d[0] ^ d[1] ^ d[3] ^ d[5] ^ d[6] ^ d[9];
+    uint32_t s1 = d[0] ^ d[1] ^ d[2] ^ d[4] ^ d[6] ^ d[7] ^ d[10];
+    uint32_t s2 = d[0] ^ d[1] ^ d[2] ^ d[3] ^ d[5] ^ d[7] ^ d[8] ^ d[11];
+    uint32_t s3 = d[0] ^ d[2] ^ d[4] ^ d[5] ^ d[8] ^ d[12];
+    
+    uint32_t count = 0U;
+    for (uint32_t cols = s0 | s1 | s2 | s3; cols != 0U; cols &= cols - 1U) {
+        uint32_t bit = cols & (0U - cols);
+        uint32_t n = ((s0 & bit) ? 0x01U : 0x00U) | ((s1 & bit) ? 0x02U : 0x00U) |
+                     ((s2 & bit) ? 0x04U : 0x00U) | ((s3 & bit) ? 0x08U : 0x00U);
+        
+        // The fix is a single bit of the 13 bit codeword, bit 12 being row 0
+        uint32_t fix = FIX_1393[n];
+        if (fix != 0U) {
+            uint32_t row = 0U;
+            while ((fix & 0x1000U) == 0U) {
+                fix <<= 1;
+                row++;
+            }
+            d[row] ^= bit;
+            count++;
+        }
+    }
+    
+    return count;
+}
@@ -19,6 +19,8 @@
 #ifndef	Hamming_H
 #define	Hamming_H
 
+#include <cstdint>
+
 class CHamming {
 public:
     static void encode15113_1(bool* d);
@@ -38,6 +40,44 @@ public:
     
     static void encode17123(bool* d);
     static bool decode17123(bool* d);
+    
+    // Packed versions, bit 0 of the arrays above is the most significant bit
+    // of the codeword. encode takes the data bits right aligned and returns
+    // the codeword, decode corrects the codeword in place and returns the same
+    // as the boolean version.
+    static uint32_t encode15113_1(uint32_t data);
+    static bool decode15113_1(uint32_t& word);
+    
+    static uint32_t encode15113_2(uint32_t data);
+    static bool decode15113_2(uint32_t& word);
+    
+    static uint32_t encode1393(uint32_t data);
+    static bool decode1393(uint32_t& word);
+    
+    static uint32_t encode1063(uint32_t data);
+    static bool decode1063(uint32_t& word);
+    
+    static uint32_t encode16114(uint32_t data);
+    static bool decode16114(uint32_t& word);
+    
+    static uint32_t encode17123(uint32_t data);
+    static bool decode17123(uint32_t& word);
+    
+    // Batch versions, in and out may be the same array. decode returns the
+    // number of corrected codewords.
+    static void encode15113_1(const uint16_t* in, uint16_t* out, uint32_t n);
+    static uint32_t decode15113_1(uint16_t* words, uint32_t n);
+    
+    static void encode15113_2(const uint16_t* in, uint16_t* out, uint32_t n);
+    static uint32_t decode15113_2(uint16_t* words, uint32_t n);
+    
+    static void encode16114(const uint16_t* in, uint16_t* out, uint32_t n);
+    
+    // Hamming (13,9,3) over up to 16 codewords held bit sliced, bit j of
+    // rows[i] is bit i of codeword j, as the columns of a BPTC matrix are.
+    // decode returns the number of corrected codewords.
+    static void encode1393Sliced(uint16_t* rows);
+    static uint32_t decode1393Sliced(uint16_t* rows);
 };
 
 #endif
@@ -33,6 +33,11 @@
 #include <string.h>
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CODEC2_SSE2
+#endif
+
 #include "nlp.h"
 #include "lpc.h"
 #include "quantise.h"
@@ -53,6 +58,229 @@ CKissFFT kiss;
 
 
 
+/*---------------------------------------------------------------------------*\
+
+                             SYNTHESIS KERNELS
+
+  Per-harmonic and per-sample loops of the decoder.  With SSE2 four
+  harmonics or samples are processed per step, using Cephes style
+  sincos and atan2 approximations accurate to a few float ulp; other
+  targets use the scalar library functions.
+
+\*---------------------------------------------------------------------------*/
+
+#ifdef CODEC2_SSE2
+
+static inline __m128 v_sincos(__m128 x, __m128 *c)
+{
+	const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	__m128  sign_sin = _mm_and_ps(x, sign_mask);
+	__m128  ax = _mm_andnot_ps(sign_mask, x);
+
+	/* octant j, rounded up to even, and x reduced to [-pi/4,pi/4] */
+
+	__m128i j = _mm_cvttps_epi32(_mm_mul_ps(ax, _mm_set1_ps(1.27323954473516f)));
+	j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+	__m128  y = _mm_cvtepi32_ps(j);
+	ax = _mm_sub_ps(ax, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+	ax = _mm_sub_ps(ax, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+	ax = _mm_sub_ps(ax, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+
+	__m128 poly_sel = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+	sign_sin = _mm_xor_ps(sign_sin, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29)));
+	__m128 sign_cos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+
+	__m128 z = _mm_mul_ps(ax, ax);
+	__m128 pc = _mm_set1_ps(2.443315711809948e-5f);
+	pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(-1.388731625493765e-3f));
+	pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(4.166664568298827e-2f));
+	pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+	pc = _mm_sub_ps(pc, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+	pc = _mm_add_ps(pc, _mm_set1_ps(1.0f));
+
+	__m128 ps = _mm_set1_ps(-1.9515295891e-4f);
+	ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(8.3321608736e-3f));
+	ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(-1.6666654611e-1f));
+	ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), ax), ax);
+
+	__m128 s = _mm_or_ps(_mm_and_ps(poly_sel, ps), _mm_andnot_ps(poly_sel, pc));
+	__m128 co = _mm_or_ps(_mm_and_ps(poly_sel, pc), _mm_andnot_ps(poly_sel, ps));
+	*c = _mm_xor_ps(co, sign_cos);
+	return _mm_xor_ps(s, sign_sin);
+}
+
+static inline __m128 v_atan2(__m128 y, __m128 x)
+{
+	const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	__m128 ax = _mm_andnot_ps(sign_mask, x);
+	__m128 ay = _mm_andnot_ps(sign_mask, y);
+
+	/* atan of t = min/max in [0,1], reduced to [0,tan(pi/8)] */
+
+	__m128 swap = _mm_cmpgt_ps(ay, ax);
+	__m128 num = _mm_min_ps(ax, ay);
+	__m128 den = _mm_max_ps(ax, ay);
+	__m128 nz = _mm_cmpgt_ps(den, _mm_setzero_ps());
+	__m128 t = _mm_and_ps(nz, _mm_div_ps(num, _mm_or_ps(den, _mm_andnot_ps(nz, _mm_set1_ps(1.0f)))));
+
+	__m128 big = _mm_cmpgt_ps(t, _mm_set1_ps(0.4142135623730950f));
+	__m128 tr = _mm_div_ps(_mm_sub_ps(t, _mm_set1_ps(1.0f)), _mm_add_ps(t, _mm_set1_ps(1.0f)));
+	t = _mm_or_ps(_mm_and_ps(big, tr), _mm_andnot_ps(big, t));
+	__m128 r = _mm_and_ps(big, _mm_set1_ps(0.78539816339744830962f));
+
+	__m128 z = _mm_mul_ps(t, t);
+	__m128 p = _mm_set1_ps(8.05374449538e-2f);
+	p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(-1.38776856032e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(1.99777106478e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(-3.33329491539e-1f));
+	p = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), t), t);
+	r = _mm_add_ps(r, p);
+
+	/* back to the full circle */
+
+	r = _mm_or_ps(_mm_and_ps(swap, _mm_sub_ps(_mm_set1_ps(1.57079632679489661923f), r)), _mm_andnot_ps(swap, r));
+	__m128 neg = _mm_cmplt_ps(x, _mm_setzero_ps());
+	r = _mm_or_ps(_mm_and_ps(neg, _mm_sub_ps(_mm_set1_ps(3.14159265358979323846f), r)), _mm_andnot_ps(neg, r));
+	return _mm_or_ps(r, _mm_and_ps(y, sign_mask));
+}
+
+#endif
+
+/*---------------------------------------------------------------------------*\
+
+  harmonic_phases()
+
+  Filters the n unit excitation phasors exp(j*ex[m]) with the LPC
+  filter samples H[m] and returns the resulting phases in phi[m].
+
+\*---------------------------------------------------------------------------*/
+
+static void harmonic_phases(float phi[], const std::complex<float> H[], const float ex[], int n)
+{
+	int m = 0;
+
+#ifdef CODEC2_SSE2
+	for(; m<n; m+=4)
+	{
+		float hr[4] = { 0 }, hi[4] = { 0 }, e[4] = { 0 }, out[4];
+		int   k = (n - m < 4) ? n - m : 4;
+		for(int i=0; i<k; i++)
+		{
+			hr[i] = H[m+i].real();
+			hi[i] = H[m+i].imag();
+			e[i] = ex[m+i];
+		}
+
+		__m128 Hr = _mm_loadu_ps(hr);
+		__m128 Hi = _mm_loadu_ps(hi);
+		__m128 Er, Ei = v_sincos(_mm_loadu_ps(e), &Er);
+		__m128 Ar = _mm_sub_ps(_mm_mul_ps(Hr, Er), _mm_mul_ps(Hi, Ei));
+		__m128 Ai = _mm_add_ps(_mm_mul_ps(Hi, Er), _mm_mul_ps(Hr, Ei));
+		_mm_storeu_ps(out, v_atan2(Ai, _mm_add_ps(Ar, _mm_set1_ps(1E-12f))));
+		for(int i=0; i<k; i++)
+			phi[m+i] = out[i];
+	}
+#else
+	for(; m<n; m++)
+	{
+		std::complex<float> Ex = std::polar(1.0f, ex[m]);
+		float Ar = H[m].real() * Ex.real() - H[m].imag() * Ex.imag();
+		float Ai = H[m].imag() * Ex.real() + H[m].real() * Ex.imag();
+		phi[m] = atan2f(Ai, Ar+1E-12);
+	}
+#endif
+}
+
+/*---------------------------------------------------------------------------*\
+
+  harmonic_polar()
+
+  re[m] + j*im[m] = A[m]*exp(j*phi[m]) for the n harmonics.
+
+\*---------------------------------------------------------------------------*/
+
+static void harmonic_polar(float re[], float im[], const float A[], const float phi[], int n)
+{
+	int m = 0;
+
+#ifdef CODEC2_SSE2
+	for(; m+4<=n; m+=4)
+	{
+		__m128 c, s = v_sincos(_mm_loadu_ps(&phi[m]), &c);
+		__m128 a = _mm_loadu_ps(&A[m]);
+		_mm_storeu_ps(&re[m], _mm_mul_ps(a, c));
+		_mm_storeu_ps(&im[m], _mm_mul_ps(a, s));
+	}
+#endif
+	for(; m<n; m++)
+	{
+		std::complex<float> Sw = std::polar(A[m], phi[m]);
+		re[m] = Sw.real();
+		im[m] = Sw.imag();
+	}
+}
+
+/*---------------------------------------------------------------------------*\
+
+  window_add()
+
+  y[i] = w[i]*x[i] or, with accumulate set, y[i] += w[i]*x[i].
+
+\*---------------------------------------------------------------------------*/
+
+static void window_add(float y[], const float x[], const float w[], int n, bool accumulate)
+{
+	int i = 0;
+
+#ifdef CODEC2_SSE2
+	for(; i+4<=n; i+=4)
+	{
+		__m128 p = _mm_mul_ps(_mm_loadu_ps(&x[i]), _mm_loadu_ps(&w[i]));
+		if (accumulate)
+			p = _mm_add_ps(_mm_loadu_ps(&y[i]), p);
+		_mm_storeu_ps(&y[i], p);
+	}
+#endif
+	for(; i<n; i++)
+		y[i] = accumulate ? y[i] + x[i]*w[i] : x[i]*w[i];
+}
+
+/*---------------------------------------------------------------------------*\
+
+  scale_to_short()
+
+  out[i] = in[i]*g1*g2, clipped to +/-32767 and truncated to 16 bits.
+
+\*---------------------------------------------------------------------------*/
+
+static void scale_to_short(short out[], const float in[], float g1, float g2, int n)
+{
+	int i = 0;
+
+#ifdef CODEC2_SSE2
+	const __m128 hi = _mm_set1_ps(32767.0f);
+	const __m128 lo = _mm_set1_ps(-32767.0f);
+	for(; i+8<=n; i+=8)
+	{
+		__m128 a = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(&in[i]), _mm_set1_ps(g1)), _mm_set1_ps(g2));
+		__m128 b = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(&in[i+4]), _mm_set1_ps(g1)), _mm_set1_ps(g2));
+		a = _mm_max_ps(_mm_min_ps(a, hi), lo);
+		b = _mm_max_ps(_mm_min_ps(b, hi), lo);
+		_mm_storeu_si128((__m128i *)&out[i], _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+	}
+#endif
+	for(; i<n; i++)
+	{
+		float x = in[i]*g1*g2;
+		if (x > 32767.0)
+			out[i] = 32767;
+		else if (x < -32767.0)
+			out[i] = -32767;
+		else
+			out[i] = x;
+	}
+}
+
 /*---------------------------------------------------------------------------*\
 
                                 FUNCTIONS
@@ -102,6 +330,7 @@ CCodec2::CCodec2(bool is_3200)
 	c2.prev_f0_enc = 1/P_MAX_S;
 	c2.bg_est = 0.0;
 	c2.ex_phase = 0.0;
+	c2.rand_next = 1;
 
 	for(int l=1; l<=MAX_AMP; l++)
 		c2.prev_model_dec.A[l] = 0.0;
@@ -166,13 +395,8 @@ CCodec2::~CCodec2()
 {
 	c2.bpf_buf.clear();
 	nlp.nlp_destroy();
-	c2.fft_fwd_cfg.twiddles.clear();
-	c2.fftr_fwd_cfg.substate.twiddles.clear();
 	c2.fftr_fwd_cfg.tmpbuf.clear();
-	c2.fftr_fwd_cfg.super_twiddles.clear();
-	c2.fftr_inv_cfg.substate.twiddles.clear();
 	c2.fftr_inv_cfg.tmpbuf.clear();
-	c2.fftr_inv_cfg.super_twiddles.clear();
 	c2.Pn.clear();
 	c2.Sn.clear();
 	c2.w.clear();
@@ -323,11 +547,8 @@ void CCodec2::codec2_decode_3200(short speech[], const unsigned char * bits)
 	float   lsps[2][LPC_ORD];
 	int     Wo_index, e_index;
 	float   e[2];
-	float   snr;
-	float   ak[2][LPC_ORD+1];
 	int     i,j;
 	unsigned int nbit = 0;
-	std::complex<float>    Aw[FFT_ENC];
 
 	/* only need to zero these out due to (unused) snr calculation */
 
@@ -369,13 +590,7 @@ void CCodec2::codec2_decode_3200(short speech[], const unsigned char * bits)
 
 	interpolate_lsp_ver2(&lsps[0][0], c2.prev_lsps_dec, &lsps[1][0], 0.5, LPC_ORD);
 
-	for(i=0; i<2; i++)
-	{
-		lsp_to_lpc(&lsps[i][0], &ak[i][0], LPC_ORD);
-		qt.aks_to_M2(&(c2.fftr_fwd_cfg), &ak[i][0], LPC_ORD, &model[i], e[i], &snr, 0, c2.lpc_pf, c2.bass_boost, c2.beta, c2.gamma, Aw);
-		qt.apply_lpc_correction(&model[i]);
-		synthesise_one_frame(&speech[c2.n_samp*i], &model[i], Aw, 3.0);
-	}
+	synthesise_subframes(speech, model, lsps, e, 2);
 
 	/* update memories for next frame ----------------------------*/
 
@@ -488,12 +703,9 @@ void CCodec2::codec2_decode_1600(short speech[], const unsigned char * bits)
 	float   lsps[4][LPC_ORD];
 	int     Wo_index, e_index;
 	float   e[4];
-	float   snr;
-	float   ak[4][LPC_ORD+1];
 	int     i,j;
 	unsigned int nbit = 0;
 	float   weight;
-	std::complex<float>    Aw[FFT_ENC];
 
 	/* only need to zero these out due to (unused) snr calculation */
 
@@ -551,13 +763,7 @@ void CCodec2::codec2_decode_1600(short speech[], const unsigned char * bits)
 	{
 		interpolate_lsp_ver2(&lsps[i][0], c2.prev_lsps_dec, &lsps[3][0], weight, LPC_ORD);
 	}
-	for(i=0; i<4; i++)
-	{
-		lsp_to_lpc(&lsps[i][0], &ak[i][0], LPC_ORD);
-		qt.aks_to_M2(&(c2.fftr_fwd_cfg), &ak[i][0], LPC_ORD, &model[i], e[i], &snr, 0, c2.lpc_pf, c2.bass_boost, c2.beta, c2.gamma, Aw);
-		qt.apply_lpc_correction(&model[i]);
-		synthesise_one_frame(&speech[c2.n_samp*i], &model[i], Aw, 3.0);
-	}
+	synthesise_subframes(speech, model, lsps, e, 4);
 
 	/* update memories for next frame ----------------------------*/
 
@@ -568,6 +774,34 @@ void CCodec2::codec2_decode_1600(short speech[], const unsigned char * bits)
 
 }
 
+/*---------------------------------------------------------------------------*\
+
+  FUNCTION....: synthesise_subframes()
+
+  Recovers the spectral amplitudes of the n 10ms sub-frames of a decoded
+  frame from their (interpolated) LSPs and energies, and synthesises
+  n*n_samp output samples.  The LSP to LPC conversion is done for all
+  sub-frames in one pass, the amplitude and synthesis steps share one
+  power spectrum buffer.
+
+\*---------------------------------------------------------------------------*/
+
+void CCodec2::synthesise_subframes(short speech[], MODEL model[], float lsps[][LPC_ORD], float e[], int n)
+{
+	float   ak[4][LPC_ORD+1];
+	float   snr;
+	std::complex<float>    Aw[FFT_ENC];
+
+	assert(n <= 4);
+	lsps_to_lpcs(lsps, ak, n);
+	for(int i=0; i<n; i++)
+	{
+		qt.aks_to_M2(&(c2.fftr_fwd_cfg), &ak[i][0], LPC_ORD, &model[i], e[i], &snr, 0, c2.lpc_pf, c2.bass_boost, c2.beta, c2.gamma, Aw);
+		qt.apply_lpc_correction(&model[i]);
+		synthesise_one_frame(&speech[c2.n_samp*i], &model[i], Aw, 3.0);
+	}
+}
+
 /*---------------------------------------------------------------------------* \
 
   FUNCTION....: synthesise_one_frame()
@@ -580,8 +814,6 @@ void CCodec2::codec2_decode_1600(short speech[], const unsigned char * bits)
 
 void CCodec2::synthesise_one_frame(short speech[], MODEL *model, std::complex<float> Aw[], float gain)
 {
-	int     i;
-
 	/* LPC based phase synthesis */
 	std::complex<float> H[MAX_AMP+1];
 	sample_phase(model, H, Aw);
@@ -590,23 +822,11 @@ void CCodec2::synthesise_one_frame(short speech[], MODEL *model, std::complex<fl
 	postfilter(model, &c2.bg_est);
 	synthesise(c2.n_samp, &(c2.fftr_inv_cfg), c2.Sn_.data(), model, c2.Pn.data(), 1);
 
-	for(i=0; i<c2.n_samp; i++)
-	{
-		c2.Sn_[i] *= gain;
-	}
-
-	ear_protection(c2.Sn_.data(), c2.n_samp);
-
-	for(i=0; i<c2.n_samp; i++)
-	{
-		if (c2.Sn_[i] > 32767.0)
-			speech[i] = 32767;
-		else if (c2.Sn_[i] < -32767.0)
-			speech[i] = -32767;
-		else
-			speech[i] = c2.Sn_[i];
-	}
+	/* gain and ear protection are applied as the output is converted
+	   to 16 bits, the first n_samp samples of Sn_ are not used again */
 
+	float ear_gain = ear_protection(c2.Sn_.data(), gain, c2.n_samp);
+	scale_to_short(speech, c2.Sn_.data(), gain, ear_gain, c2.n_samp);
 }
 
 
@@ -660,21 +880,32 @@ void CCodec2::analyse_one_frame(MODEL *model, const short *speech)
 
   Limits output level to protect ears when there are bit errors or the input
   is overdriven.  This doesn't correct or mask bit errors, just reduces the
-  worst of their damage.
+  worst of their damage.  Returns the gain to apply to in[]*gain.
 
 \*---------------------------------------------------------------------------*/
 
-void CCodec2::ear_protection(float in_out[], int n)
+float CCodec2::ear_protection(const float in[], float gain, int n)
 {
-	float max_sample, over, gain;
-	int   i;
+	float max_sample, over;
+	int   i = 0;
 
 	/* find maximum sample in frame */
 
 	max_sample = 0.0;
-	for(i=0; i<n; i++)
-		if (in_out[i] > max_sample)
-			max_sample = in_out[i];
+#ifdef CODEC2_SSE2
+	if (n >= 4)
+	{
+		__m128 max4 = _mm_setzero_ps();
+		for(; i+4<=n; i+=4)
+			max4 = _mm_max_ps(max4, _mm_mul_ps(_mm_loadu_ps(&in[i]), _mm_set1_ps(gain)));
+		max4 = _mm_max_ps(max4, _mm_movehl_ps(max4, max4));
+		max4 = _mm_max_ss(max4, _mm_shuffle_ps(max4, max4, 1));
+		max_sample = _mm_cvtss_f32(max4);
+	}
+#endif
+	for(; i<n; i++)
+		if (in[i]*gain > max_sample)
+			max_sample = in[i]*gain;
 
 	/* determine how far above set point */
 
@@ -685,11 +916,8 @@ void CCodec2::ear_protection(float in_out[], int n)
 	   by bit errors) more than smaller ones */
 
 	if (over > 1.0)
-	{
-		gain = 1.0/(over*over);
-		for(i=0; i<n; i++)
-			in_out[i] *= gain;
-	}
+		return 1.0/(over*over);
+	return 1.0;
 }
 
 /*---------------------------------------------------------------------------*\
@@ -821,9 +1049,7 @@ void CCodec2::phase_synth_zero_order(
 )
 {
 	int   m;
-	float new_phi;
-	std::complex<float>  Ex[MAX_AMP+1];	  /* excitation samples */
-	std::complex<float>  A_[MAX_AMP+1];	  /* synthesised harmonic samples */
+	float ex[MAX_AMP+1];	  /* excitation phases */
 
 	/*
 	   Update excitation fundamental phase track, this sets the position
@@ -837,14 +1063,13 @@ void CCodec2::phase_synth_zero_order(
 	ex_phase[0] += (model->Wo)*n_samp;
 	ex_phase[0] -= TWO_PI*floorf(ex_phase[0]/TWO_PI + 0.5);
 
+	/* generate excitation phases */
+
 	for(m=1; m<=model->L; m++)
 	{
-
-		/* generate excitation */
-
 		if (model->voiced)
 		{
-			Ex[m] = std::polar(1.0f, ex_phase[0] * m);
+			ex[m] = ex_phase[0] * m;
 		}
 		else
 		{
@@ -853,20 +1078,13 @@ void CCodec2::phase_synth_zero_order(
 			   phase is not needed in the unvoiced case, but no harm in
 			   keeping it.
 			*/
-			float phi = TWO_PI*(float)codec2_rand()/CODEC2_RAND_MAX;
-			Ex[m] = std::polar(1.0f, phi);
+			ex[m] = TWO_PI*(float)codec2_rand()/CODEC2_RAND_MAX;
 		}
+	}
 
-		/* filter using LPC filter */
-
-		A_[m].real(H[m].real() * Ex[m].real() - H[m].imag() * Ex[m].imag());
-		A_[m].imag(H[m].imag() * Ex[m].real() + H[m].real() * Ex[m].imag());
-
-		/* modify sinusoidal phase */
+	/* filter using LPC filter and modify sinusoidal phase */
 
-		new_phi = atan2f(A_[m].imag(), A_[m].real()+1E-12);
-		model->phi[m] = new_phi;
-	}
+	harmonic_phases(&model->phi[1], &H[1], &ex[1], model->L);
 
 }
 
@@ -1474,17 +1692,15 @@ void CCodec2::synthesise(
 	int    shift          /* flag used to handle transition frames       */
 )
 {
-	int   i,l,j,b;	        /* loop variables */
+	int   i,l,b;	        /* loop variables */
 	std::complex<float>  Sw_[FFT_DEC/2+1];	/* DFT of synthesised signal */
 	float sw_[FFT_DEC];	        /* synthesised signal */
+	float re[MAX_AMP+1], im[MAX_AMP+1];	/* harmonic phasors */
 
 	if (shift)
 	{
 		/* Update memories */
-		for(i=0; i<n_samp-1; i++)
-		{
-			Sn_[i] = Sn_[i+n_samp];
-		}
+		memcpy(Sn_, &Sn_[n_samp], (n_samp-1)*sizeof(float));
 		Sn_[n_samp-1] = 0.0;
 	}
 
@@ -1496,6 +1712,7 @@ void CCodec2::synthesise(
 
 	/* Now set up frequency domain synthesised speech */
 
+	harmonic_polar(&re[1], &im[1], &model->A[1], &model->phi[1], model->L);
 	for(l=1; l<=model->L; l++)
 	{
 		b = (int)(l*model->Wo*FFT_DEC/TWO_PI + 0.5);
@@ -1503,7 +1720,8 @@ void CCodec2::synthesise(
 		{
 			b = (FFT_DEC/2)-1;
 		}
-		Sw_[b] = std::polar(model->A[l], model->phi[l]);
+		Sw_[b].real(re[l]);
+		Sw_[b].imag(im[l]);
 	}
 
 	/* Perform inverse DFT */
@@ -1512,24 +1730,14 @@ void CCodec2::synthesise(
 
 	/* Overlap add to previous samples */
 
-	for(i=0; i<n_samp-1; i++)
-	{
-		Sn_[i] += sw_[FFT_DEC-n_samp+1+i]*Pn[i];
-	}
-
-	if (shift)
-		for(i=n_samp-1,j=0; i<2*n_samp; i++,j++)
-			Sn_[i] = sw_[j]*Pn[i];
-	else
-		for(i=n_samp-1,j=0; i<2*n_samp; i++,j++)
-			Sn_[i] += sw_[j]*Pn[i];
+	window_add(Sn_, &sw_[FFT_DEC-n_samp+1], Pn, n_samp-1, true);
+	window_add(&Sn_[n_samp-1], sw_, &Pn[n_samp-1], n_samp+1, !shift);
 }
 
 int CCodec2::codec2_rand(void)
 {
-	static unsigned long next = 1;
-	next = next * 1103515245 + 12345;
-	return((unsigned)(next/65536) % 32768);
+	c2.rand_next = c2.rand_next * 1103515245 + 12345;
+	return((unsigned)(c2.rand_next/65536) % 32768);
 }
 
 /*---------------------------------------------------------------------------*\
@@ -1743,3 +1951,78 @@ void CCodec2::lsp_to_lpc(float *lsp, float *ak, int order)
 		xin2 = 0.0;
 	}
 }
+
+/*---------------------------------------------------------------------------*\
+
+  FUNCTION....: lsps_to_lpcs()
+
+  lsp_to_lpc() for n frames of LPC_ORD LSPs.  With SSE2 up to four
+  frames are converted together, one per lane, with the same arithmetic
+  as lsp_to_lpc() so the LPCs are identical.
+
+\*---------------------------------------------------------------------------*/
+
+void CCodec2::lsps_to_lpcs(float lsp[][LPC_ORD], float ak[][LPC_ORD+1], int n)
+{
+	int f = 0;
+
+#ifdef CODEC2_SSE2
+	for(; f<n; f+=4)
+	{
+		int   i, j, k = (n - f < 4) ? n - f : 4;
+		float x[4];
+		__m128 freq[LPC_ORD];
+		__m128 Wp[4*(LPC_ORD/2)+2];
+		__m128 xin1, xin2, xout1, xout2, out[LPC_ORD+1];
+
+		/* convert from radians to the x=cos(w) domain, spare lanes
+		   repeat the last frame */
+
+		for(i=0; i<LPC_ORD; i++)
+		{
+			for(j=0; j<4; j++)
+				x[j] = cosf(lsp[f + (j < k ? j : k-1)][i]);
+			freq[i] = _mm_loadu_ps(x);
+		}
+
+		for(i=0; i<4*(LPC_ORD/2)+2; i++)
+			Wp[i] = _mm_setzero_ps();
+
+		xin1 = _mm_set1_ps(1.0f);
+		xin2 = _mm_set1_ps(1.0f);
+		for(j=0; j<=LPC_ORD; j++)
+		{
+			__m128 *n1 = Wp;
+			for(i=0; i<(LPC_ORD/2); i++, n1+=4)
+			{
+				xout1 = _mm_add_ps(_mm_sub_ps(xin1, _mm_mul_ps(_mm_add_ps(freq[2*i], freq[2*i]), n1[0])), n1[1]);
+				xout2 = _mm_add_ps(_mm_sub_ps(xin2, _mm_mul_ps(_mm_add_ps(freq[2*i+1], freq[2*i+1]), n1[2])), n1[3]);
+				n1[1] = n1[0];
+				n1[3] = n1[2];
+				n1[0] = xin1;
+				n1[2] = xin2;
+				xin1 = xout1;
+				xin2 = xout2;
+			}
+			xout1 = _mm_add_ps(xin1, n1[0]);
+			xout2 = _mm_sub_ps(xin2, n1[1]);
+			out[j] = _mm_mul_ps(_mm_add_ps(xout1, xout2), _mm_set1_ps(0.5f));
+			n1[0] = xin1;
+			n1[1] = xin2;
+
+			xin1 = _mm_setzero_ps();
+			xin2 = _mm_setzero_ps();
+		}
+
+		for(j=0; j<=LPC_ORD; j++)
+		{
+			_mm_storeu_ps(x, out[j]);
+			for(i=0; i<k; i++)
+				ak[f+i][j] = x[i];
+		}
+	}
+#else
+	for(; f<n; f++)
+		lsp_to_lpc(lsp[f], ak[f], LPC_ORD);
+#endif
+}
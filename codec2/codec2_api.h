@@ -83,13 +83,15 @@ private:
 	void interpolate_lsp_ver2(float interp[], float prev[],  float next[], float weight, int order);
 
 	void analyse_one_frame(MODEL *model, const short *speech);
+	void synthesise_subframes(short speech[], MODEL model[], float lsps[][LPC_ORD], float e[], int n);
 	void synthesise_one_frame(short speech[], MODEL *model, std::complex<float> Aw[], float gain);
 	void codec2_encode_3200(unsigned char *bits, const short *speech);
 	void codec2_encode_1600(unsigned char *bits, const short *speech);
 	void codec2_decode_3200(short *speech, const unsigned char *bits);
 	void codec2_decode_1600(short *speech, const unsigned char *bits);
-	void ear_protection(float in_out[], int n);
+	float ear_protection(const float in[], float gain, int n);
 	void lsp_to_lpc(float *freq, float *ak, int lpcrdr);
+	void lsps_to_lpcs(float lsp[][LPC_ORD], float ak[][LPC_ORD+1], int n);
 
 	void (CCodec2::*encode)(unsigned char *bits, const short *speech);
 	void (CCodec2::*decode)(short *speech, const unsigned char *bits);
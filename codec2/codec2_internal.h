@@ -41,6 +41,7 @@ using CODEC2 = struct codec2_tag {
 	int                bass_boost;               /* LPC post filter bass boost                */
 	int                smoothing;                /* enable smoothing for channels with errors */
 	float              ex_phase;                 /* excitation model phase track              */
+	unsigned long      rand_next;                /* codec2_rand() state                       */
 	float              bg_est;                   /* background noise estimate for post filter */
 	float              prev_f0_enc;              /* previous frame's f0    estimate           */
 	float              prev_e_dec;               /* previous frame's LPC energy               */
@@ -105,19 +105,29 @@ struct lsp_codebook
 	float *cb; /* The elements         */
 };
 
+/* FFT plan, built once per size and direction and shared by every user */
+
+using FFT_PLAN = struct fft_plan_tag
+{
+	int  nfft;
+	bool inverse;
+	int  factors[2*MAXFACTORS];
+	std::vector<std::complex<float>> twiddles;        /* kiss mixed radix twiddles           */
+	std::vector<std::complex<float>> stage_twiddles;  /* radix-4 stage twiddles, power of 2  */
+	std::vector<std::complex<float>> super_twiddles;  /* real FFT of size 2*nfft             */
+};
+
 using FFT_STATE = struct fft_state_tag
 {
     int  nfft;
     bool inverse;
-    int  factors[2*MAXFACTORS];
-    std::vector<std::complex<float>> twiddles;
+    const FFT_PLAN *plan;
 };
 
 using FFTR_STATE = struct fftr_state_tag
 {
 	FFT_STATE substate;
 	std::vector<std::complex<float>> tmpbuf;
-	std::vector<std::complex<float>> super_twiddles;
 };
 
 extern const struct lsp_codebook lsp_cb[];
@@ -14,14 +14,22 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 #include <cstring>
 #include <cassert>
+#include <map>
+#include <memory>
+#include <mutex>
 
 #include "defines.h"
 #include "kiss_fft.h"
 
-void CKissFFT::kf_bfly2(std::complex<float> *Fout, const size_t fstride, FFT_STATE &st, int m)
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define KISS_FFT_X86
+#include <immintrin.h>
+#endif
+
+void CKissFFT::kf_bfly2(std::complex<float> *Fout, const size_t fstride, const FFT_PLAN &st, int m)
 {
 	std::complex<float> *Fout2;
-	std::complex<float> *tw1 = st.twiddles.data();
+	const std::complex<float> *tw1 = st.twiddles.data();
 	std::complex<float> t;
 	Fout2 = Fout + m;
 	do
@@ -36,10 +44,10 @@ void CKissFFT::kf_bfly2(std::complex<float> *Fout, const size_t fstride, FFT_STA
 	while (--m);
 }
 
-void CKissFFT::kf_bfly3(std::complex<float> * Fout, const size_t fstride, FFT_STATE &st, int m)
+void CKissFFT::kf_bfly3(std::complex<float> * Fout, const size_t fstride, const FFT_PLAN &st, int m)
 {
 	const size_t m2 = 2 * m;
-	std::complex<float> *tw1,*tw2;
+	const std::complex<float> *tw1,*tw2;
 	std::complex<float> scratch[5];
 	std::complex<float> epi3;
 	epi3 = st.twiddles[fstride*m];
@@ -73,9 +81,9 @@ void CKissFFT::kf_bfly3(std::complex<float> * Fout, const size_t fstride, FFT_ST
 	while(--m);
 }
 
-void CKissFFT::kf_bfly4(std::complex<float> *Fout, const size_t fstride, FFT_STATE &st, int m)
+void CKissFFT::kf_bfly4(std::complex<float> *Fout, const size_t fstride, const FFT_PLAN &st, int m)
 {
-	std::complex<float> *tw1,*tw2,*tw3;
+	const std::complex<float> *tw1,*tw2,*tw3;
 	std::complex<float> scratch[6];
 	int k = m;
 	const int m2 = 2 * m;
@@ -119,10 +127,10 @@ void CKissFFT::kf_bfly4(std::complex<float> *Fout, const size_t fstride, FFT_STA
 	while(--k);
 }
 
-void CKissFFT::kf_bfly5(std::complex<float> * Fout, const size_t fstride, FFT_STATE &st, int m)
+void CKissFFT::kf_bfly5(std::complex<float> * Fout, const size_t fstride, const FFT_PLAN &st, int m)
 {
 	std::complex<float> scratch[13];
-	std::complex<float> *twiddles = st.twiddles.data();
+	const std::complex<float> *twiddles = st.twiddles.data();
 	auto ya = twiddles[fstride*m];
 	auto yb = twiddles[fstride*2*m];
 
@@ -173,7 +181,7 @@ void CKissFFT::kf_bfly5(std::complex<float> * Fout, const size_t fstride, FFT_ST
 }
 
 /* perform the butterfly for one stage of a mixed radix FFT */
-void CKissFFT::kf_bfly_generic(std::complex<float> *Fout, const size_t fstride, FFT_STATE &st, int m, int p)
+void CKissFFT::kf_bfly_generic(std::complex<float> *Fout, const size_t fstride, const FFT_PLAN &st, int m, int p)
 {
 	auto twiddles = st.twiddles.data();
 	std::complex<float> t;
@@ -208,7 +216,7 @@ void CKissFFT::kf_bfly_generic(std::complex<float> *Fout, const size_t fstride,
 	scratch.clear();
 }
 
-void CKissFFT::kf_work(std::complex<float> *Fout, const std::complex<float> *f, const size_t fstride, int in_stride, int *factors, FFT_STATE &st)
+void CKissFFT::kf_work(std::complex<float> *Fout, const std::complex<float> *f, const size_t fstride, int in_stride, const int *factors, const FFT_PLAN &st)
 {
 	auto Fout_beg = Fout;
 	const int p = *factors++; /* the radix  */
@@ -298,40 +306,379 @@ void CKissFFT::kf_factor(int n,int * facbuf)
 	while (n > 1);
 }
 
-void CKissFFT::fft_alloc(FFT_STATE &state, const int nfft, bool inverse_fft)
+namespace {
+
+/* Power of two sizes up to SIMD_FFT_MAX are run by a Stockham radix-4
+ * FFT (a final radix-2 pass when log2(nfft) is odd) whose passes work
+ * on contiguous vectors. Each pass reads x[q + s*(p + k*n/4)] and
+ * writes y[q + s*(4*p + k)], so no bit reversal is needed. */
+#define SIMD_FFT_MAX 512
+
+typedef void (*stage4_fn)(int n, int s, const std::complex<float> *tw, const std::complex<float> *x, std::complex<float> *y, bool inverse);
+typedef void (*stage2_fn)(int s, const std::complex<float> *x, std::complex<float> *y);
+
+#ifdef KISS_FFT_X86
+void stage4_generic(int n, int s, const std::complex<float> *tw, const std::complex<float> *x, std::complex<float> *y, bool inverse)
 {
-	state.twiddles.resize(nfft);
+	const int n1 = n / 4;
+	const std::complex<float> rot = inverse ? std::complex<float>(0.f, -1.f) : std::complex<float>(0.f, 1.f);
 
-	state.nfft = nfft;
-	state.inverse = inverse_fft;
+	for (int p=0; p<n1; p++)
+	{
+		const std::complex<float> w1 = tw[p];
+		const std::complex<float> w2 = tw[n1 + p];
+		const std::complex<float> w3 = tw[2*n1 + p];
+		for (int q=0; q<s; q++)
+		{
+			const std::complex<float> a = x[q + s*p];
+			const std::complex<float> b = x[q + s*(p + n1)];
+			const std::complex<float> c = x[q + s*(p + 2*n1)];
+			const std::complex<float> d = x[q + s*(p + 3*n1)];
+			const std::complex<float> apc = a + c;
+			const std::complex<float> amc = a - c;
+			const std::complex<float> bpd = b + d;
+			const std::complex<float> jbmd = rot * (b - d);
+			y[q + s*(4*p + 0)] = apc + bpd;
+			y[q + s*(4*p + 1)] = w1 * (amc - jbmd);
+			y[q + s*(4*p + 2)] = w2 * (apc - bpd);
+			y[q + s*(4*p + 3)] = w3 * (amc + jbmd);
+		}
+	}
+}
+
+/* two complex values per register */
+
+__attribute__((target("sse2")))
+inline __m128 cmul_sse2(__m128 a, __m128 w)
+{
+	const __m128 wr = _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0));
+	const __m128 wi = _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1));
+	const __m128 as = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+	const __m128 neg_re = _mm_castsi128_ps(_mm_set_epi32(0, (int)0x80000000, 0, (int)0x80000000));
+	return _mm_add_ps(_mm_mul_ps(a, wr), _mm_xor_ps(_mm_mul_ps(as, wi), neg_re));
+}
+
+__attribute__((target("sse2")))
+inline void bfly4_sse2(__m128 a, __m128 b, __m128 c, __m128 d, __m128 w1, __m128 w2, __m128 w3, __m128 rot, __m128 &y0, __m128 &y1, __m128 &y2, __m128 &y3)
+{
+	const __m128 apc = _mm_add_ps(a, c);
+	const __m128 amc = _mm_sub_ps(a, c);
+	const __m128 bpd = _mm_add_ps(b, d);
+	const __m128 bmd = _mm_sub_ps(b, d);
+	const __m128 jbmd = _mm_xor_ps(_mm_shuffle_ps(bmd, bmd, _MM_SHUFFLE(2, 3, 0, 1)), rot);
+	y0 = _mm_add_ps(apc, bpd);
+	y1 = cmul_sse2(_mm_sub_ps(amc, jbmd), w1);
+	y2 = cmul_sse2(_mm_sub_ps(apc, bpd), w2);
+	y3 = cmul_sse2(_mm_add_ps(amc, jbmd), w3);
+}
 
+__attribute__((target("sse2")))
+void stage4_sse2(int n, int s, const std::complex<float> *tw, const std::complex<float> *x, std::complex<float> *y, bool inverse)
+{
+	const int n1 = n / 4;
+	/* multiply by j (forward) or -j (inverse) after swapping re/im */
+	const __m128 rot = inverse ? _mm_castsi128_ps(_mm_set_epi32((int)0x80000000, 0, (int)0x80000000, 0))
+	                           : _mm_castsi128_ps(_mm_set_epi32(0, (int)0x80000000, 0, (int)0x80000000));
+	const float *xf = (const float *)x;
+	float *yf = (float *)y;
+	__m128 y0, y1, y2, y3;
+
+	if (s == 1)
+	{
+		if (n1 < 2)
+		{
+			stage4_generic(n, s, tw, x, y, inverse);
+			return;
+		}
+		/* first pass, two values of p at a time */
+		for (int p=0; p<n1; p+=2)
+		{
+			bfly4_sse2(_mm_loadu_ps(xf + 2*p), _mm_loadu_ps(xf + 2*(p + n1)), _mm_loadu_ps(xf + 2*(p + 2*n1)), _mm_loadu_ps(xf + 2*(p + 3*n1)),
+			           _mm_loadu_ps((const float *)&tw[p]), _mm_loadu_ps((const float *)&tw[n1 + p]), _mm_loadu_ps((const float *)&tw[2*n1 + p]),
+			           rot, y0, y1, y2, y3);
+			_mm_storeu_ps(yf + 8*p + 0, _mm_movelh_ps(y0, y1));
+			_mm_storeu_ps(yf + 8*p + 4, _mm_movelh_ps(y2, y3));
+			_mm_storeu_ps(yf + 8*p + 8, _mm_movehl_ps(y1, y0));
+			_mm_storeu_ps(yf + 8*p + 12, _mm_movehl_ps(y3, y2));
+		}
+		return;
+	}
+
+	for (int p=0; p<n1; p++)
+	{
+		const __m128 w1 = _mm_castpd_ps(_mm_load1_pd((const double *)&tw[p]));
+		const __m128 w2 = _mm_castpd_ps(_mm_load1_pd((const double *)&tw[n1 + p]));
+		const __m128 w3 = _mm_castpd_ps(_mm_load1_pd((const double *)&tw[2*n1 + p]));
+		const float *xa = xf + 2*s*p;
+		float *ya = yf + 8*s*p;
+		for (int q=0; q<2*s; q+=4)
+		{
+			bfly4_sse2(_mm_loadu_ps(xa + q), _mm_loadu_ps(xa + q + 2*s*n1), _mm_loadu_ps(xa + q + 4*s*n1), _mm_loadu_ps(xa + q + 6*s*n1),
+			           w1, w2, w3, rot, y0, y1, y2, y3);
+			_mm_storeu_ps(ya + q, y0);
+			_mm_storeu_ps(ya + q + 2*s, y1);
+			_mm_storeu_ps(ya + q + 4*s, y2);
+			_mm_storeu_ps(ya + q + 6*s, y3);
+		}
+	}
+}
+
+__attribute__((target("sse2")))
+void stage2_sse2(int s, const std::complex<float> *x, std::complex<float> *y)
+{
+	const float *xf = (const float *)x;
+	float *yf = (float *)y;
+
+	for (int q=0; q<2*s; q+=4)
+	{
+		const __m128 a = _mm_loadu_ps(xf + q);
+		const __m128 b = _mm_loadu_ps(xf + q + 2*s);
+		_mm_storeu_ps(yf + q, _mm_add_ps(a, b));
+		_mm_storeu_ps(yf + q + 2*s, _mm_sub_ps(a, b));
+	}
+}
+
+/* four complex values per register */
+
+__attribute__((target("avx")))
+inline __m256 cmul_avx(__m256 a, __m256 w)
+{
+	const __m256 as = _mm256_permute_ps(a, 0xb1);
+	return _mm256_addsub_ps(_mm256_mul_ps(a, _mm256_moveldup_ps(w)), _mm256_mul_ps(as, _mm256_movehdup_ps(w)));
+}
+
+__attribute__((target("avx")))
+inline void bfly4_avx(__m256 a, __m256 b, __m256 c, __m256 d, __m256 w1, __m256 w2, __m256 w3, __m256 rot, __m256 &y0, __m256 &y1, __m256 &y2, __m256 &y3)
+{
+	const __m256 apc = _mm256_add_ps(a, c);
+	const __m256 amc = _mm256_sub_ps(a, c);
+	const __m256 bpd = _mm256_add_ps(b, d);
+	const __m256 bmd = _mm256_sub_ps(b, d);
+	const __m256 jbmd = _mm256_xor_ps(_mm256_permute_ps(bmd, 0xb1), rot);
+	y0 = _mm256_add_ps(apc, bpd);
+	y1 = cmul_avx(_mm256_sub_ps(amc, jbmd), w1);
+	y2 = cmul_avx(_mm256_sub_ps(apc, bpd), w2);
+	y3 = cmul_avx(_mm256_add_ps(amc, jbmd), w3);
+}
+
+__attribute__((target("avx")))
+void stage4_avx(int n, int s, const std::complex<float> *tw, const std::complex<float> *x, std::complex<float> *y, bool inverse)
+{
+	const int n1 = n / 4;
+	const __m256 rot = _mm256_castsi256_ps(inverse ? _mm256_set1_epi64x((long long)0x8000000000000000ULL)
+	                                               : _mm256_set1_epi64x(0x80000000LL));
+	const float *xf = (const float *)x;
+	float *yf = (float *)y;
+	__m256 y0, y1, y2, y3;
+
+	if (s == 1)
+	{
+		if (n1 < 4)
+		{
+			stage4_sse2(n, s, tw, x, y, inverse);
+			return;
+		}
+		/* first pass, four values of p at a time, then a 4x4 transpose
+		   of complex values to interleave the outputs */
+		for (int p=0; p<n1; p+=4)
+		{
+			bfly4_avx(_mm256_loadu_ps(xf + 2*p), _mm256_loadu_ps(xf + 2*(p + n1)), _mm256_loadu_ps(xf + 2*(p + 2*n1)), _mm256_loadu_ps(xf + 2*(p + 3*n1)),
+			          _mm256_loadu_ps((const float *)&tw[p]), _mm256_loadu_ps((const float *)&tw[n1 + p]), _mm256_loadu_ps((const float *)&tw[2*n1 + p]),
+			          rot, y0, y1, y2, y3);
+			const __m256d t0 = _mm256_unpacklo_pd(_mm256_castps_pd(y0), _mm256_castps_pd(y1));
+			const __m256d t1 = _mm256_unpackhi_pd(_mm256_castps_pd(y0), _mm256_castps_pd(y1));
+			const __m256d t2 = _mm256_unpacklo_pd(_mm256_castps_pd(y2), _mm256_castps_pd(y3));
+			const __m256d t3 = _mm256_unpackhi_pd(_mm256_castps_pd(y2), _mm256_castps_pd(y3));
+			_mm256_storeu_pd((double *)(yf + 8*p + 0), _mm256_permute2f128_pd(t0, t2, 0x20));
+			_mm256_storeu_pd((double *)(yf + 8*p + 8), _mm256_permute2f128_pd(t1, t3, 0x20));
+			_mm256_storeu_pd((double *)(yf + 8*p + 16), _mm256_permute2f128_pd(t0, t2, 0x31));
+			_mm256_storeu_pd((double *)(yf + 8*p + 24), _mm256_permute2f128_pd(t1, t3, 0x31));
+		}
+		_mm256_zeroupper();
+		return;
+	}
+
+	for (int p=0; p<n1; p++)
+	{
+		const __m256 w1 = _mm256_castpd_ps(_mm256_broadcast_sd((const double *)&tw[p]));
+		const __m256 w2 = _mm256_castpd_ps(_mm256_broadcast_sd((const double *)&tw[n1 + p]));
+		const __m256 w3 = _mm256_castpd_ps(_mm256_broadcast_sd((const double *)&tw[2*n1 + p]));
+		const float *xa = xf + 2*s*p;
+		float *ya = yf + 8*s*p;
+		for (int q=0; q<2*s; q+=8)
+		{
+			bfly4_avx(_mm256_loadu_ps(xa + q), _mm256_loadu_ps(xa + q + 2*s*n1), _mm256_loadu_ps(xa + q + 4*s*n1), _mm256_loadu_ps(xa + q + 6*s*n1),
+			          w1, w2, w3, rot, y0, y1, y2, y3);
+			_mm256_storeu_ps(ya + q, y0);
+			_mm256_storeu_ps(ya + q + 2*s, y1);
+			_mm256_storeu_ps(ya + q + 4*s, y2);
+			_mm256_storeu_ps(ya + q + 6*s, y3);
+		}
+	}
+	_mm256_zeroupper();
+}
+
+__attribute__((target("avx")))
+void stage2_avx(int s, const std::complex<float> *x, std::complex<float> *y)
+{
+	const float *xf = (const float *)x;
+	float *yf = (float *)y;
+
+	if (s < 4)
+	{
+		stage2_sse2(s, x, y);
+		return;
+	}
+	for (int q=0; q<2*s; q+=8)
+	{
+		const __m256 a = _mm256_loadu_ps(xf + q);
+		const __m256 b = _mm256_loadu_ps(xf + q + 2*s);
+		_mm256_storeu_ps(yf + q, _mm256_add_ps(a, b));
+		_mm256_storeu_ps(yf + q + 2*s, _mm256_sub_ps(a, b));
+	}
+	_mm256_zeroupper();
+}
+#endif
+
+struct simd_backend
+{
+	stage4_fn stage4;
+	stage2_fn stage2;
+};
+
+simd_backend best_simd_backend()
+{
+#ifdef KISS_FFT_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx"))
+		return { stage4_avx, stage2_avx };
+	if (__builtin_cpu_supports("sse2"))
+		return { stage4_sse2, stage2_sse2 };
+#endif
+	return { nullptr, nullptr };
+}
+
+void simd_fft(const simd_backend &be, const FFT_PLAN &plan, const std::complex<float> *fin, std::complex<float> *fout)
+{
+	std::complex<float> work[2][SIMD_FFT_MAX];
+	const std::complex<float> *tw = plan.stage_twiddles.data();
+	int stages = 0;
+
+	for (int n=plan.nfft; n>1; n/=4)
+		stages++;
+
+	/* ping-pong between fout and work[0] so that the last pass lands in
+	   fout, an in-place call starts from a copy of the input */
+	if (fin == fout)
+	{
+		memcpy(work[1], fin, plan.nfft*sizeof(std::complex<float>));
+		fin = work[1];
+	}
+	std::complex<float> *dst = (stages & 1) ? fout : work[0];
+
+	int s = 1;
+	for (int n=plan.nfft; n>1; n/=4)
+	{
+		if (n == 2)
+			be.stage2(s, fin, dst);
+		else
+		{
+			be.stage4(n, s, tw, fin, dst, plan.inverse);
+			tw += 3*(n/4);
+		}
+		s *= 4;
+		fin = dst;
+		dst = (dst == fout) ? work[0] : fout;
+	}
+}
+
+}
+
+/* Plans are cached for the life of the process, there are only ever a
+ * few distinct sizes */
+const FFT_PLAN *CKissFFT::get_plan(int nfft, bool inverse)
+{
+	static std::mutex lock;
+	static std::map<std::pair<int, bool>, std::unique_ptr<FFT_PLAN>> plans;
+	const double pi=3.141592653589793238462643383279502884197169399375105820974944;
+
+	std::lock_guard<std::mutex> guard(lock);
+	auto &plan = plans[std::make_pair(nfft, inverse)];
+	if (plan)
+		return plan.get();
+
+	plan.reset(new FFT_PLAN);
+	plan->nfft = nfft;
+	plan->inverse = inverse;
+	plan->twiddles.resize(nfft);
 	for (int i=0; i<nfft; ++i)
 	{
-		const double pi=3.141592653589793238462643383279502884197169399375105820974944;
 		double phase = -2.0 * pi * i / nfft;
-		if (state.inverse)
+		if (inverse)
 			phase *= -1.0;
-		state.twiddles[i] = std::polar(1.0f, float(phase));
+		plan->twiddles[i] = std::polar(1.0f, float(phase));
 	}
+	kf_factor(nfft, plan->factors);
 
-	kf_factor(nfft, state.factors);
+	/* twiddles of the radix-4 passes, w^p, w^2p and w^3p for each pass */
+	if (nfft >= 4 && nfft <= SIMD_FFT_MAX && (nfft & (nfft - 1)) == 0)
+	{
+		for (int n=nfft; n>=4; n/=4)
+		{
+			for (int k=1; k<=3; k++)
+			{
+				for (int p=0; p<n/4; p++)
+				{
+					double phase = -2.0 * pi * k * p / n;
+					if (inverse)
+						phase *= -1.0;
+					plan->stage_twiddles.push_back(std::polar(1.0f, float(phase)));
+				}
+			}
+		}
+	}
+
+	/* post-processing twiddles of a real FFT with 2*nfft points */
+	plan->super_twiddles.resize(nfft/2);
+	for (int i=0; i<nfft/2; ++i)
+	{
+		double phase = -pi * (double(i+1) / nfft + .5);
+		if (inverse)
+			phase *= -1.0;
+		plan->super_twiddles[i] = std::polar(1.0f, float(phase));
+	}
+
+	return plan.get();
+}
+
+void CKissFFT::fft_alloc(FFT_STATE &state, const int nfft, bool inverse_fft)
+{
+	state.nfft = nfft;
+	state.inverse = inverse_fft;
+	state.plan = get_plan(nfft, inverse_fft);
 }
 
 
 void CKissFFT::fft_stride(FFT_STATE &st, const std::complex<float> *fin, std::complex<float> *fout, int in_stride)
 {
-	if (fin == fout)
+	static const simd_backend backend = best_simd_backend();
+
+	if (in_stride == 1 && backend.stage4 && !st.plan->stage_twiddles.empty())
+	{
+		simd_fft(backend, *st.plan, fin, fout);
+	}
+	else if (fin == fout)
 	{
 		//NOTE: this is not really an in-place FFT algorithm.
 		//It just performs an out-of-place FFT into a temp buffer
 		std::vector<std::complex<float>> tmpbuf(st.nfft);
-		kf_work(tmpbuf.data(), fin, true, in_stride, st.factors, st);
+		kf_work(tmpbuf.data(), fin, 1, in_stride, st.plan->factors, *st.plan);
 		memcpy(fout, tmpbuf.data(), sizeof(std::complex<float>)*st.nfft);
 		tmpbuf.clear();
 	}
 	else
 	{
-		kf_work(fout, fin, 1, in_stride, st.factors, st);
+		kf_work(fout, fin, 1, in_stride, st.plan->factors, *st.plan);
 	}
 }
 
@@ -361,15 +708,6 @@ void CKissFFT::fftr_alloc(FFTR_STATE &st, int nfft, const bool inverse_fft)
 
 	fft_alloc(st.substate, nfft, inverse_fft);
 	st.tmpbuf.resize(nfft);
-	st.super_twiddles.resize(nfft);
-
-	for (int i=0; i<nfft/2; ++i)
-	{
-		double phase = -3.141592653589793238462643383279502884197169399375105820974944 * (double(i+1) / nfft + .5);
-		if (inverse_fft)
-			phase *= -1.0;
-		st.super_twiddles[i] = std::polar(1.0f, float(phase));
-	}
 }
 
 void CKissFFT::fftr(FFTR_STATE &st, const float *timedata, std::complex<float> *freqdata)
@@ -403,7 +741,7 @@ void CKissFFT::fftr(FFTR_STATE &st, const float *timedata, std::complex<float> *
 
 		auto f1k = fpk + fpnk;
 		auto f2k = fpk - fpnk;
-		auto tw = f2k * st.super_twiddles[k-1];
+		auto tw = f2k * st.substate.plan->super_twiddles[k-1];
 
 		freqdata[k] = 0.5f * (f1k + tw);
 		freqdata[ncfft-k].real(0.5f * (f1k.real() - tw.real()));
@@ -427,7 +765,7 @@ void CKissFFT::fftri(FFTR_STATE &st, const std::complex<float> *freqdata, float
 
 		auto fek = fk + fnkc;
 		auto tmp = fk - fnkc;
-		auto fok = tmp * st.super_twiddles[k-1];
+		auto fok = tmp * st.substate.plan->super_twiddles[k-1];
 		st.tmpbuf[k] = fek + fok;
 		st.tmpbuf[ncfft - k] = std::conj(fek - fok);
 	}
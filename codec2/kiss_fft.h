@@ -24,12 +24,13 @@ public:
 	void fftr(FFTR_STATE &cfg,const float *timedata,std::complex<float> *freqdata);
 	void fftri(FFTR_STATE &cfg,const std::complex<float> *freqdata,float *timedata);
 private:
-	void kf_bfly2(std::complex<float> *Fout, const size_t fstride, FFT_STATE &st, int m);
-	void kf_bfly3(std::complex<float> *Fout, const size_t fstride, FFT_STATE &st, int m);
-	void kf_bfly4(std::complex<float> *Fout, const size_t fstride, FFT_STATE &st, int m);
-	void kf_bfly5(std::complex<float> *Fout, const size_t fstride, FFT_STATE &st, int m);
-	void kf_bfly_generic(std::complex<float> *Fout, const size_t fstride, FFT_STATE &st, int m, int p);
-	void kf_work(std::complex<float> *Fout, const std::complex<float> *f, const size_t fstride, int in_stride, int *factors, FFT_STATE &st);
+	void kf_bfly2(std::complex<float> *Fout, const size_t fstride, const FFT_PLAN &st, int m);
+	void kf_bfly3(std::complex<float> *Fout, const size_t fstride, const FFT_PLAN &st, int m);
+	void kf_bfly4(std::complex<float> *Fout, const size_t fstride, const FFT_PLAN &st, int m);
+	void kf_bfly5(std::complex<float> *Fout, const size_t fstride, const FFT_PLAN &st, int m);
+	void kf_bfly_generic(std::complex<float> *Fout, const size_t fstride, const FFT_PLAN &st, int m, int p);
+	void kf_work(std::complex<float> *Fout, const std::complex<float> *f, const size_t fstride, int in_stride, const int *factors, const FFT_PLAN &st);
 	void kf_factor(int n, int *facbuf);
+	const FFT_PLAN *get_plan(int nfft, bool inverse);
 };
 #endif
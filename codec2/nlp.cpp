@@ -28,6 +28,15 @@
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define NLP_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NLP_NEON
+#endif
 
 #include "defines.h"
 #include "nlp.h"
@@ -146,6 +155,89 @@ static const float fdmdv_os_filter[]= {
     -0.0008215855034550383
 };
 
+/*---------------------------------------------------------------------------*\
+
+  fir_dot()
+
+  Dot product of two n sample vectors, used for the decimation FIRs.
+  Both filters are symmetric, so correlating with the taps is the same
+  as convolving with them.
+
+\*---------------------------------------------------------------------------*/
+
+static float fir_dot(const float x[], const float h[], int n)
+{
+	int   i = 0;
+	float acc = 0.0;
+
+#if defined(NLP_SSE)
+	__m128 acc4 = _mm_setzero_ps();
+	for(; i+4<=n; i+=4)
+		acc4 = _mm_add_ps(acc4, _mm_mul_ps(_mm_loadu_ps(&x[i]), _mm_loadu_ps(&h[i])));
+	acc4 = _mm_add_ps(acc4, _mm_movehl_ps(acc4, acc4));
+	acc4 = _mm_add_ss(acc4, _mm_shuffle_ps(acc4, acc4, 1));
+	acc = _mm_cvtss_f32(acc4);
+#elif defined(NLP_NEON)
+	float32x4_t acc4 = vdupq_n_f32(0.0f);
+	for(; i+4<=n; i+=4)
+		acc4 = vmlaq_f32(acc4, vld1q_f32(&x[i]), vld1q_f32(&h[i]));
+	float32x2_t acc2 = vadd_f32(vget_low_f32(acc4), vget_high_f32(acc4));
+	acc = vget_lane_f32(vpadd_f32(acc2, acc2), 0);
+#endif
+	for(; i<n; i++)
+		acc += x[i]*h[i];
+
+	return acc;
+}
+
+/*---------------------------------------------------------------------------*\
+
+  peak_search()
+
+  Returns the index of the first maximum of x[from..to] if it is above
+  thresh, otherwise from. The peak value (or thresh) is written to *peak.
+
+\*---------------------------------------------------------------------------*/
+
+static int peak_search(const float x[], int from, int to, float thresh, float *peak)
+{
+	int   i = from;
+	float max = thresh;
+
+#if defined(NLP_SSE)
+	if (to - from + 1 >= 4)
+	{
+		__m128 max4 = _mm_set1_ps(thresh);
+		for(; i+3<=to; i+=4)
+			max4 = _mm_max_ps(max4, _mm_loadu_ps(&x[i]));
+		max4 = _mm_max_ps(max4, _mm_movehl_ps(max4, max4));
+		max4 = _mm_max_ss(max4, _mm_shuffle_ps(max4, max4, 1));
+		max = _mm_cvtss_f32(max4);
+	}
+#elif defined(NLP_NEON)
+	if (to - from + 1 >= 4)
+	{
+		float32x4_t max4 = vdupq_n_f32(thresh);
+		for(; i+3<=to; i+=4)
+			max4 = vmaxq_f32(max4, vld1q_f32(&x[i]));
+		float32x2_t max2 = vmax_f32(vget_low_f32(max4), vget_high_f32(max4));
+		max = vget_lane_f32(vpmax_f32(max2, max2), 0);
+	}
+#endif
+	for(; i<=to; i++)
+		if (x[i] > max)
+			max = x[i];
+
+	*peak = max;
+	if (max > thresh)
+	{
+		for(i=from; x[i]!=max; i++)
+			;
+		return i;
+	}
+	return from;
+}
+
 /*---------------------------------------------------------------------------*\
 
   nlp_create()
@@ -207,7 +299,7 @@ void Cnlp::nlp_create(C2CONST *c2const)
 
 void Cnlp::nlp_destroy()
 {
-	snlp.fft_cfg.twiddles.clear();
+	/* the FFT plan is shared and owned by CKissFFT */
 }
 
 /*---------------------------------------------------------------------------*\
@@ -299,13 +391,18 @@ float Cnlp::nlp(
 		assert(j <= n);
 	}
 
-	for(i=m-n; i<m; i++)  	/* notch filter at DC */
+	/* notch filter at DC, the output is appended to the last NLP_NTAP-1
+	   inputs of the decimation filter */
+
+	float fir_in[NLP_NTAP-1+PMAX_M];
+	memcpy(fir_in, &snlp.mem_fir[1], (NLP_NTAP-1)*sizeof(float));
+	for(i=m-n, j=NLP_NTAP-1; i<m; i++, j++)
 	{
 		notch = snlp.sq[i] - snlp.mem_x;
 		notch += COEFF*snlp.mem_y;
 		snlp.mem_x = snlp.sq[i];
 		snlp.mem_y = notch;
-		snlp.sq[i] = notch + 1.0;  /* With 0 input vectors to codec,
+		fir_in[j] = notch + 1.0;  /* With 0 input vectors to codec,
 				      kiss_fft() would take a long
 				      time to execute when running in
 				      real time.  Problem was traced
@@ -315,17 +412,14 @@ float Cnlp::nlp(
 				      exactly sure why. */
 	}
 
-	for(i=m-n; i<m; i++)  	/* FIR filter vector */
-	{
+	/* FIR filter vector. Only every DEC-th output is used by the DFT
+	   below, and while n is a multiple of DEC those outputs stay on
+	   multiples of DEC as sq[] shifts, so the others are skipped. */
 
-		for(j=0; j<NLP_NTAP-1; j++)
-			snlp.mem_fir[j] = snlp.mem_fir[j+1];
-		snlp.mem_fir[NLP_NTAP-1] = snlp.sq[i];
-
-		snlp.sq[i] = 0.0;
-		for(j=0; j<NLP_NTAP; j++)
-			snlp.sq[i] += snlp.mem_fir[j]*nlp_fir[j];
-	}
+	int step = (n % DEC) ? 1 : DEC;
+	for(i=(m-n+step-1)/step*step; i<m; i+=step)
+		snlp.sq[i] = fir_dot(&fir_in[i-(m-n)], nlp_fir, NLP_NTAP);
+	memcpy(snlp.mem_fir, &fir_in[n-1], NLP_NTAP*sizeof(float));
 
 	/* Decimate and DFT */
 
@@ -343,28 +437,24 @@ float Cnlp::nlp(
 	// since all imag inputs are 0
 	codec2_fft_inplace(snlp.fft_cfg, Fw);
 
-	for(i=0; i<PE_FFT_SIZE; i++)
-		Fw[i].real(Fw[i].real() * Fw[i].real() + Fw[i].imag() * Fw[i].imag());
-
 	/* todo: express everything in f0, as pitch in samples is dep on Fs */
 
 	int pmin = floor(SAMPLE_RATE*P_MIN_S);
 	int pmax = floor(SAMPLE_RATE*P_MAX_S);
 
+	/* power spectrum, only up to the highest bin the searches look at */
+
+	float Pw[PE_FFT_SIZE];
+	int   nbins = PE_FFT_SIZE*DEC/pmin + 2;
+	assert(nbins <= PE_FFT_SIZE);
+	for(i=0; i<nbins; i++)
+		Pw[i] = Fw[i].real() * Fw[i].real() + Fw[i].imag() * Fw[i].imag();
+
 	/* find global peak */
 
-	gmax = 0.0;
-	gmax_bin = PE_FFT_SIZE*DEC/pmax;
-	for(i=PE_FFT_SIZE*DEC/pmax; i<=PE_FFT_SIZE*DEC/pmin; i++)
-	{
-		if (Fw[i].real() > gmax)
-		{
-			gmax = Fw[i].real();
-			gmax_bin = i;
-		}
-	}
+	gmax_bin = peak_search(Pw, PE_FFT_SIZE*DEC/pmax, PE_FFT_SIZE*DEC/pmin, 0.0, &gmax);
 
-	best_f0 = post_process_sub_multiples(Fw, pmax, gmax, gmax_bin, prev_f0);
+	best_f0 = post_process_sub_multiples(Pw, pmax, gmax, gmax_bin, prev_f0);
 
 	/* Shift samples in buffer to make room for new samples */
 
@@ -401,7 +491,7 @@ float Cnlp::nlp(
 
 \*---------------------------------------------------------------------------*/
 
-float Cnlp::post_process_sub_multiples(std::complex<float> Fw[], int pmax, float gmax, int gmax_bin, float *prev_f0)
+float Cnlp::post_process_sub_multiples(float Pw[], int pmax, float gmax, int gmax_bin, float *prev_f0)
 {
 	int   min_bin, cmax_bin;
 	int   mult;
@@ -434,17 +524,11 @@ float Cnlp::post_process_sub_multiples(std::complex<float> Fw[], int pmax, float
 		else
 			thresh = CNLP*gmax;
 
-		lmax = 0;
-		lmax_bin = bmin;
-		for (b=bmin; b<=bmax; b++) 	     /* look for maximum in interval */
-			if (Fw[b].real() > lmax)
-			{
-				lmax = Fw[b].real();
-				lmax_bin = b;
-			}
+		/* look for maximum in interval */
+		lmax_bin = peak_search(Pw, bmin, bmax, 0.0, &lmax);
 
 		if (lmax > thresh)
-			if ((lmax > Fw[lmax_bin-1].real()) && (lmax > Fw[lmax_bin+1].real()))
+			if ((lmax > Pw[lmax_bin-1]) && (lmax > Pw[lmax_bin+1]))
 			{
 				cmax_bin = lmax_bin;
 			}
@@ -479,16 +563,10 @@ float Cnlp::post_process_sub_multiples(std::complex<float> Fw[], int pmax, float
 
 void Cnlp::fdmdv_16_to_8(float out8k[], float in16k[], int n)
 {
-	float acc;
-	int   i,j,k;
+	int   i,k;
 
 	for(i=0, k=0; k<n; i+=FDMDV_OS, k++)
-	{
-		acc = 0.0;
-		for(j=0; j<FDMDV_OS_TAPS_16K; j++)
-			acc += fdmdv_os_filter[j]*in16k[i-j];
-		out8k[k] = acc;
-	}
+		out8k[k] = fir_dot(&in16k[i-FDMDV_OS_TAPS_16K+1], fdmdv_os_filter, FDMDV_OS_TAPS_16K);
 
 	/* update filter memory */
 
@@ -78,7 +78,7 @@ public:
 	void codec2_fft_inplace(FFT_STATE &cfg, std::complex<float> *inout);
 
 private:
-	float post_process_sub_multiples(std::complex<float> Fw[], int pmax, float gmax, int gmax_bin, float *prev_f0);
+	float post_process_sub_multiples(float Pw[], int pmax, float gmax, int gmax_bin, float *prev_f0);
 	void fdmdv_16_to_8(float out8k[], float in16k[], int n);
 
 	NLP snlp;
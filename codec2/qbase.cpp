@@ -1,8 +1,147 @@
 #include <assert.h>
 #include <math.h>
 
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define QBASE_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define QBASE_NEON
+#endif
+
 #include "qbase.h"
 
+/*---------------------------------------------------------------------------*
+  nearest_entry()
+
+  Returns the index of the first of the m k-dimensional entries of cb
+  with the smallest weighted squared error to x, and writes that error
+  to *beste, or init if no entry is below init.  With wsq each error
+  term is (d*w)^2 as in quantise(), otherwise it is w*d^2.
+
+  Four entries are compared at a time, each SIMD lane keeping its own
+  best error and index, which are merged at the end.  Every error term
+  is >= 0, so an entry is dropped as soon as its partial error reaches
+  the best so far.  The terms are summed in the same order as the
+  scalar search, so the selected index is bit-identical.
+
+\*---------------------------------------------------------------------------*/
+
+static inline float vq_term(float d, float w, bool wsq)
+{
+	return wsq ? d*w*d*w : w*d*d;
+}
+
+static int nearest_entry(const float *cb, int m, int k, const float *x, const float *w, bool wsq, float init, float *beste)
+{
+	int   i = 0, j;
+	int   besti = 0;
+	float best = init;
+
+#if defined(QBASE_SSE)
+	if (m >= 4)
+	{
+		__m128 best4 = _mm_set1_ps(init);
+		__m128 besti4 = _mm_setzero_ps();
+		__m128 idx4 = _mm_setr_ps(0, 1, 2, 3);
+		const __m128 four = _mm_set1_ps(4);
+
+		for(; i+4<=m; i+=4, idx4=_mm_add_ps(idx4, four))
+		{
+			const float *c = &cb[i*k];
+			__m128 acc = _mm_setzero_ps();
+			for(j=0; j<k; j++, c++)
+			{
+				__m128 cj = (k == 1) ? _mm_loadu_ps(c) : _mm_setr_ps(c[0], c[k], c[2*k], c[3*k]);
+				__m128 d = _mm_sub_ps(cj, _mm_set1_ps(x[j]));
+				__m128 wj = _mm_set1_ps(w[j]);
+				__m128 t = wsq ? _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(d, wj), d), wj) : _mm_mul_ps(_mm_mul_ps(wj, d), d);
+				acc = _mm_add_ps(acc, t);
+				if (j+1 < k && !_mm_movemask_ps(_mm_cmplt_ps(acc, best4)))
+					break;
+			}
+			__m128 lt = _mm_cmplt_ps(acc, best4);
+			best4 = _mm_or_ps(_mm_and_ps(lt, acc), _mm_andnot_ps(lt, best4));
+			besti4 = _mm_or_ps(_mm_and_ps(lt, idx4), _mm_andnot_ps(lt, besti4));
+		}
+
+		float lbest[4], lidx[4];
+		_mm_storeu_ps(lbest, best4);
+		_mm_storeu_ps(lidx, besti4);
+		for(j=0; j<4; j++)
+			if (lbest[j] < best || (lbest[j] == best && lbest[j] < init && (int)lidx[j] < besti))
+			{
+				best = lbest[j];
+				besti = (int)lidx[j];
+			}
+	}
+#elif defined(QBASE_NEON)
+	if (m >= 4)
+	{
+		static const float idx0[4] = { 0, 1, 2, 3 };
+		float32x4_t best4 = vdupq_n_f32(init);
+		float32x4_t besti4 = vdupq_n_f32(0);
+		float32x4_t idx4 = vld1q_f32(idx0);
+		const float32x4_t four = vdupq_n_f32(4);
+
+		for(; i+4<=m; i+=4, idx4=vaddq_f32(idx4, four))
+		{
+			const float *c = &cb[i*k];
+			float32x4_t acc = vdupq_n_f32(0);
+			for(j=0; j<k; j++, c++)
+			{
+				float32x4_t cj;
+				if (k == 1)
+					cj = vld1q_f32(c);
+				else
+				{
+					float tmp[4] = { c[0], c[k], c[2*k], c[3*k] };
+					cj = vld1q_f32(tmp);
+				}
+				float32x4_t d = vsubq_f32(cj, vdupq_n_f32(x[j]));
+				float32x4_t wj = vdupq_n_f32(w[j]);
+				float32x4_t t = wsq ? vmulq_f32(vmulq_f32(vmulq_f32(d, wj), d), wj) : vmulq_f32(vmulq_f32(wj, d), d);
+				acc = vaddq_f32(acc, t);
+				if (j+1 < k)
+				{
+					uint32x4_t lt = vcltq_f32(acc, best4);
+					uint32x2_t any = vorr_u32(vget_low_u32(lt), vget_high_u32(lt));
+					if (!vget_lane_u32(vpmax_u32(any, any), 0))
+						break;
+				}
+			}
+			uint32x4_t lt = vcltq_f32(acc, best4);
+			best4 = vbslq_f32(lt, acc, best4);
+			besti4 = vbslq_f32(lt, idx4, besti4);
+		}
+
+		float lbest[4], lidx[4];
+		vst1q_f32(lbest, best4);
+		vst1q_f32(lidx, besti4);
+		for(j=0; j<4; j++)
+			if (lbest[j] < best || (lbest[j] == best && lbest[j] < init && (int)lidx[j] < besti))
+			{
+				best = lbest[j];
+				besti = (int)lidx[j];
+			}
+	}
+#endif
+	for(; i<m; i++)
+	{
+		float e = 0.0;
+		for(j=0; j<k && e<best; j++)
+			e += vq_term(cb[i*k+j]-x[j], w[j], wsq);
+		if (e < best)
+		{
+			best = e;
+			besti = i;
+		}
+	}
+
+	*beste = best;
+	return besti;
+}
+
 /*---------------------------------------------------------------------------*\
 
   quantise
@@ -21,29 +160,10 @@ long CQbase::quantise(const float *cb, float vec[], float w[], int k, int m, flo
 /* int     m;		size of codebook          */
 /* float   *se;		accumulated squared error */
 {
-	float   e;			/* current error		*/
-	long	   besti;	/* best index so far	*/
 	float   beste;		/* best error so far	*/
-	long	   j;
-	int     i;
-	float   diff;
+	long	   besti;	/* best index so far	*/
 
-	besti = 0;
-	beste = 1E32;
-	for(j=0; j<m; j++)
-	{
-		e = 0.0;
-		for(i=0; i<k; i++)
-		{
-			diff = cb[j*k+i]-vec[i];
-			e += (diff*w[i] * diff*w[i]);
-		}
-		if (e < beste)
-		{
-			beste = e;
-			besti = j;
-		}
-	}
+	besti = nearest_entry(cb, m, k, vec, w, true, 1E32, &beste);
 
 	*se += beste;
 
@@ -72,6 +192,7 @@ int CQbase::encode_WoE(MODEL *model, float e, float xq[])
 	int          ndim = ge_cb[0].k;
 
 	assert((1<<WO_E_BITS) == nb_entries);
+	assert(ndim == 2);
 
 	if (e < 0.0) e = 0;  /* occasional small negative energies due LPC round off I guess */
 
@@ -179,22 +300,9 @@ void CQbase::compute_weights2(const float *x, const float *xp, float *w)
 
 int CQbase::find_nearest_weighted(const float *codebook, int nb_entries, float *x, const float *w, int ndim)
 {
-	int i, j;
-	float min_dist = 1e15;
-	int nearest = 0;
+	float min_dist;
 
-	for (i=0; i<nb_entries; i++)
-	{
-		float dist=0;
-		for (j=0; j<ndim; j++)
-			dist += w[j]*(x[j]-codebook[i*ndim+j])*(x[j]-codebook[i*ndim+j]);
-		if (dist<min_dist)
-		{
-			min_dist = dist;
-			nearest = i;
-		}
-	}
-	return nearest;
+	return nearest_entry(codebook, nb_entries, ndim, x, w, false, 1e15, &min_dist);
 }
 
 /*---------------------------------------------------------------------------*\
@@ -31,6 +31,11 @@
 #include <string.h>
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define QUANTISE_SSE2
+#endif
+
 #include "defines.h"
 #include "quantise.h"
 #include "lpc.h"
@@ -40,6 +45,82 @@ extern CKissFFT kiss;
 
 #define LSP_DELTA1 0.01         /* grid spacing for LSP root searches */
 
+#ifdef QUANTISE_SSE2
+
+/*---------------------------------------------------------------------------*\
+
+  v_pow()
+
+  x^beta for four x >= 0, as exp(beta*log(x)) using the Cephes logf and
+  expf approximations, relative error below 2e-6.
+
+\*---------------------------------------------------------------------------*/
+
+static inline __m128 v_floor(__m128 x)
+{
+	__m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+	return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+}
+
+static inline __m128 v_pow(__m128 x, float beta)
+{
+	__m128 pos = _mm_cmpgt_ps(x, _mm_setzero_ps());
+
+	/* log(x) = e*log(2) + log(m), m in [sqrt(0.5),sqrt(2)) */
+
+	__m128  v = _mm_max_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x00800000)));
+	__m128i ei = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(v), 23), _mm_set1_epi32(126));
+	__m128  m = _mm_or_ps(_mm_and_ps(v, _mm_castsi128_ps(_mm_set1_epi32(0x007fffff))), _mm_set1_ps(0.5f));
+	__m128  e = _mm_cvtepi32_ps(ei);
+	__m128  small = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781186547524f));
+	e = _mm_sub_ps(e, _mm_and_ps(small, _mm_set1_ps(1.0f)));
+	m = _mm_add_ps(_mm_sub_ps(m, _mm_set1_ps(1.0f)), _mm_and_ps(small, m));
+
+	__m128 z = _mm_mul_ps(m, m);
+	__m128 y = _mm_set1_ps(7.0376836292e-2f);
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.1514610310e-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.1676998740e-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.2420140846e-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.4249322787e-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.6668057665e-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(2.0000714765e-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-2.4999993993e-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(3.3333331174e-1f));
+	y = _mm_mul_ps(_mm_mul_ps(y, m), z);
+	y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+	y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+	__m128 lx = _mm_add_ps(_mm_add_ps(m, y), _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+
+	/* exp(t) = 2^n*exp(r), r in [-log(2)/2,log(2)/2] */
+
+	__m128 t = _mm_mul_ps(lx, _mm_set1_ps(beta));
+	t = _mm_max_ps(_mm_min_ps(t, _mm_set1_ps(88.3762626647949f)), _mm_set1_ps(-87.3365447504f));
+	__m128 n = v_floor(_mm_add_ps(_mm_mul_ps(t, _mm_set1_ps(1.44269504088896341f)), _mm_set1_ps(0.5f)));
+	__m128 r = _mm_sub_ps(t, _mm_mul_ps(n, _mm_set1_ps(0.693359375f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(n, _mm_set1_ps(-2.12194440e-4f)));
+
+	z = _mm_mul_ps(r, r);
+	y = _mm_set1_ps(1.9875691500e-4f);
+	y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(1.3981999507e-3f));
+	y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(8.3334519073e-3f));
+	y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(4.1665795894e-2f));
+	y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(1.6666665459e-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(5.0000001201e-1f));
+	y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, z), r), _mm_set1_ps(1.0f));
+
+	__m128i pw2 = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127)), 23);
+	return _mm_and_ps(pos, _mm_mul_ps(y, _mm_castsi128_ps(pw2)));
+}
+
+static inline float v_hsum(__m128 x)
+{
+	x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+	x = _mm_add_ss(x, _mm_shuffle_ps(x, x, 1));
+	return _mm_cvtss_f32(x);
+}
+
+#endif
+
 /*---------------------------------------------------------------------------*\
 
                              FUNCTIONS
@@ -156,22 +237,13 @@ void CQuantize::compute_weights(const float *x, float *w, int ndim)
 
 int CQuantize::find_nearest(const float *codebook, int nb_entries, float *x, int ndim)
 {
-	int i, j;
-	float min_dist = 1e15;
-	int nearest = 0;
+	float w[ndim];
 
-	for (i=0; i<nb_entries; i++)
-	{
-		float dist=0;
-		for (j=0; j<ndim; j++)
-			dist += (x[j]-codebook[i*ndim+j])*(x[j]-codebook[i*ndim+j]);
-		if (dist<min_dist)
-		{
-			min_dist = dist;
-			nearest = i;
-		}
-	}
-	return nearest;
+	/* unit weights give exactly the unweighted squared error */
+	for (int j=0; j<ndim; j++)
+		w[j] = 1.0;
+
+	return find_nearest_weighted(codebook, nb_entries, x, w, ndim);
 }
 
 int CQuantize::check_lsp_order(float lsp[], int order)
@@ -229,10 +301,7 @@ void CQuantize::lpc_post_filter(FFTR_STATE *fftr_fwd_cfg, float Pw[], float ak[]
 	int   i;
 	float x[FFT_ENC];   /* input to FFTs                */
 	std::complex<float>  Ww[FFT_ENC/2+1];  /* weighting spectrum           */
-	float Rw[FFT_ENC/2+1];  /* R = WA                       */
 	float e_before, e_after, gain;
-	float Pfw;
-	float max_Rw, min_Rw;
 	float coeff;
 
 	/* Determine weighting filter spectrum W(exp(jw)) ---------------*/
@@ -251,43 +320,39 @@ void CQuantize::lpc_post_filter(FFTR_STATE *fftr_fwd_cfg, float Pw[], float ak[]
 	}
 	kiss.fftr(*fftr_fwd_cfg, x, Ww);
 
-	for(i=0; i<FFT_ENC/2; i++)
-	{
-		Ww[i].real(Ww[i].real() * Ww[i].real() + Ww[i].imag() * Ww[i].imag());
-	}
-
-	/* Determined combined filter R = WA ---------------------------*/
-
-	max_Rw = 0.0;
-	min_Rw = 1E32;
-	for(i=0; i<FFT_ENC/2; i++)
-	{
-		Rw[i] = sqrtf(Ww[i].real() * Pw[i]);
-		if (Rw[i] > max_Rw)
-			max_Rw = Rw[i];
-		if (Rw[i] < min_Rw)
-			min_Rw = Rw[i];
-
-	}
-
-	/* create post filter mag spectrum and apply ------------------*/
-
-	/* measure energy before post filtering */
+	/* Determined combined filter R = WA, create post filter mag
+	   spectrum and apply, measuring energy before and after */
 
 	e_before = 1E-4;
-	for(i=0; i<FFT_ENC/2; i++)
-		e_before += Pw[i];
-
-	/* apply post filter and measure energy  */
-
-
 	e_after = 1E-4;
+#ifdef QUANTISE_SSE2
+	__m128 eb = _mm_setzero_ps(), ea = _mm_setzero_ps();
+	for(i=0; i<FFT_ENC/2; i+=4)
+	{
+		__m128 a = _mm_loadu_ps((float *)&Ww[i]);
+		__m128 b = _mm_loadu_ps((float *)&Ww[i+2]);
+		__m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+		__m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+		__m128 P = _mm_loadu_ps(&Pw[i]);
+		__m128 W2 = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+		__m128 Pf = v_pow(_mm_sqrt_ps(_mm_mul_ps(W2, P)), beta);
+		eb = _mm_add_ps(eb, P);
+		P = _mm_mul_ps(P, _mm_mul_ps(Pf, Pf));
+		ea = _mm_add_ps(ea, P);
+		_mm_storeu_ps(&Pw[i], P);
+	}
+	e_before += v_hsum(eb);
+	e_after += v_hsum(ea);
+#else
 	for(i=0; i<FFT_ENC/2; i++)
 	{
-		Pfw = powf(Rw[i], beta);
+		float W2 = Ww[i].real() * Ww[i].real() + Ww[i].imag() * Ww[i].imag();
+		e_before += Pw[i];
+		float Pfw = powf(sqrtf(W2 * Pw[i]), beta);
 		Pw[i] *= Pfw * Pfw;
 		e_after += Pw[i];
 	}
+#endif
 	gain = e_before/e_after;
 
 	/* apply gain factor to normalise energy, and LPC Energy */
@@ -362,10 +427,22 @@ void CQuantize::aks_to_M2(
 
 	float Pw[FFT_ENC/2];
 
+#ifdef QUANTISE_SSE2
+	for(i=0; i<FFT_ENC/2; i+=4)
+	{
+		__m128 a = _mm_loadu_ps((float *)&Aw[i]);
+		__m128 b = _mm_loadu_ps((float *)&Aw[i+2]);
+		__m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+		__m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+		__m128 A2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)), _mm_set1_ps(1E-6f));
+		_mm_storeu_ps(&Pw[i], _mm_div_ps(_mm_set1_ps(1.0f), A2));
+	}
+#else
 	for(i=0; i<FFT_ENC/2; i++)
 	{
 		Pw[i] = 1.0/(Aw[i].real() * Aw[i].real() + Aw[i].imag() * Aw[i].imag() + 1E-6);
 	}
+#endif
 
 	if (pf)
 		lpc_post_filter(fftr_fwd_cfg, Pw, ak, order, beta, gamma, bass_boost, E);
@@ -33,6 +33,7 @@
 #include "crs129.h"
 #include "SHA256.h"
 #include "CRCenc.h"
+#include "chamming.h"
 #include "MMDVMDefines.h"
 #ifdef USE_MD380_VOCODER
 #include <md380_vocoder.h>
@@ -59,6 +60,8 @@ DMR::DMR() :
 {
     m_mode = "DMR";
     m_dmrcnt = 0;
+    m_rxpcmcnt = 0;
+    m_rxpcmidx = 0;
     m_flco = FLCO_GROUP;
     m_attenuation = 5;
 #ifdef USE_MD380_VOCODER
@@ -572,7 +575,7 @@ void DMR::transmit()
 
     if(m_hwtx){
 #if !defined(Q_OS_IOS)
-        m_ambedev->encode(pcm);
+        m_ambedev->encode(pcm, m_ambech);
 #endif
     }
     else{
@@ -741,15 +744,6 @@ void DMR::encode_data()
     }
 }
 
-void DMR::encode16114(bool* d)
-{
-    d[11] = d[0] ^ d[1] ^ d[2] ^ d[3] ^ d[5] ^ d[7] ^ d[8];
-    d[12] = d[1] ^ d[2] ^ d[3] ^ d[4] ^ d[6] ^ d[8] ^ d[9];
-    d[13] = d[2] ^ d[3] ^ d[4] ^ d[5] ^ d[7] ^ d[9] ^ d[10];
-    d[14] = d[0] ^ d[1] ^ d[2] ^ d[4] ^ d[6] ^ d[7] ^ d[10];
-    d[15] = d[0] ^ d[2] ^ d[5] ^ d[6] ^ d[8] ^ d[9] ^ d[10];
-}
-
 void DMR::encode_qr1676(uint8_t* data)
 {
     uint32_t value = (data[0U] >> 1) & 0x7FU;
@@ -780,22 +774,14 @@ uint8_t DMR::get_embedded_data(uint8_t* data, uint8_t n)
     if (n >= 1U && n < 5U) {
         n--;
 
-        bool bits[40U];
-        ::memset(bits, 0x00U, 40U * sizeof(bool));
-        ::memcpy(bits + 4U, m_raw + n * 32U, 32U * sizeof(bool));
+        // Each fragment is 4 columns of the matrix, a byte each
+        const uint8_t* bytes = m_raw + n * 4U;
 
-        uint8_t bytes[5U];
-        bitsToByteBE(bits + 0U,  bytes[0U]);
-        bitsToByteBE(bits + 8U,  bytes[1U]);
-        bitsToByteBE(bits + 16U, bytes[2U]);
-        bitsToByteBE(bits + 24U, bytes[3U]);
-        bitsToByteBE(bits + 32U, bytes[4U]);
-
-        data[14U] = (data[14U] & 0xF0U) | (bytes[0U] & 0x0FU);
-        data[15U] = bytes[1U];
-        data[16U] = bytes[2U];
-        data[17U] = bytes[3U];
-        data[18U] = (data[18U] & 0x0FU) | (bytes[4U] & 0xF0U);
+        data[14U] = (data[14U] & 0xF0U) | (bytes[0U] >> 4);
+        data[15U] = (bytes[0U] << 4) | (bytes[1U] >> 4);
+        data[16U] = (bytes[1U] << 4) | (bytes[2U] >> 4);
+        data[17U] = (bytes[2U] << 4) | (bytes[3U] >> 4);
+        data[18U] = (data[18U] & 0x0FU) | (bytes[3U] << 4);
 
         switch (n) {
         case 0U:
@@ -818,94 +804,40 @@ uint8_t DMR::get_embedded_data(uint8_t* data, uint8_t n)
 
 void DMR::encode_embedded_data()
 {
-    uint32_t crc;
-    lc_get_data(m_data);
-    CCRC::encodeFiveBit(m_data, crc);
-
-    bool data[128U];
-    ::memset(data, 0x00U, 128U * sizeof(bool));
-
-    data[106U] = (crc & 0x01U) == 0x01U;
-    data[90U]  = (crc & 0x02U) == 0x02U;
-    data[74U]  = (crc & 0x04U) == 0x04U;
-    data[58U]  = (crc & 0x08U) == 0x08U;
-    data[42U]  = (crc & 0x10U) == 0x10U;
-
-    uint32_t b = 0U;
-    for (uint32_t a = 0U; a < 11U; a++, b++)
-        data[a] = m_data[b];
-    for (uint32_t a = 16U; a < 27U; a++, b++)
-        data[a] = m_data[b];
-    for (uint32_t a = 32U; a < 42U; a++, b++)
-        data[a] = m_data[b];
-    for (uint32_t a = 48U; a < 58U; a++, b++)
-        data[a] = m_data[b];
-    for (uint32_t a = 64U; a < 74U; a++, b++)
-        data[a] = m_data[b];
-    for (uint32_t a = 80U; a < 90U; a++, b++)
-        data[a] = m_data[b];
-    for (uint32_t a = 96U; a < 106U; a++, b++)
-        data[a] = m_data[b];
+    uint8_t lc[9U] = {0U};
+    lc_get_data(lc);
+
+    // Five bit checksum, the sum of the LC bytes modulo 31
+    uint32_t crc = 0U;
+    for (uint32_t i = 0U; i < 9U; i++)
+        crc += lc[i];
+    crc %= 31U;
+
+    // 8 rows of 16 bits, the first two rows carry 11 LC bits, the next
+    // five 10 LC bits and a checksum bit, MSB first
+    uint64_t lo = ((uint64_t)lc[1U] << 56) | ((uint64_t)lc[2U] << 48) | ((uint64_t)lc[3U] << 40) | ((uint64_t)lc[4U] << 32) |
+                  ((uint64_t)lc[5U] << 24) | ((uint64_t)lc[6U] << 16) | ((uint64_t)lc[7U] << 8) | lc[8U];
+    uint16_t rows[8U];
+    rows[0U] = (lc[0U] << 3) | (lo >> 61);
+    rows[1U] = (lo >> 50) & 0x7FFU;
+    for (uint32_t r = 2U; r < 7U; r++)
+        rows[r] = (((lo >> (40U - (r - 2U) * 10U)) & 0x3FFU) << 1) | ((crc >> (6U - r)) & 0x01U);
 
     // Hamming (16,11,4) check each row except the last one
-    for (uint32_t a = 0U; a < 112U; a += 16U)
-        encode16114(data + a);
+    CHamming::encode16114(rows, rows, 7U);
 
     // Add the parity bits for each column
-    for (uint32_t a = 0U; a < 16U; a++)
-        data[a + 112U] = data[a + 0U] ^ data[a + 16U] ^ data[a + 32U] ^ data[a + 48U] ^ data[a + 64U] ^ data[a + 80U] ^ data[a + 96U];
-
-    // The data is packed downwards in columns
-    b = 0U;
-    for (uint32_t a = 0U; a < 128U; a++) {
-        m_raw[a] = data[b];
-        b += 16U;
-        if (b > 127U)
-            b -= 127U;
+    rows[7U] = rows[0U] ^ rows[1U] ^ rows[2U] ^ rows[3U] ^ rows[4U] ^ rows[5U] ^ rows[6U];
+
+    // The data is packed downwards in columns, a byte per column
+    for (uint32_t c = 0U; c < 16U; c++) {
+        uint8_t col = 0U;
+        for (uint32_t r = 0U; r < 8U; r++)
+            col = (col << 1) | ((rows[r] >> (15U - c)) & 0x01U);
+        m_raw[c] = col;
     }
 }
 
-void DMR::bitsToByteBE(const bool* bits, uint8_t& byte)
-{
-    byte  = bits[0U] ? 0x80U : 0x00U;
-    byte |= bits[1U] ? 0x40U : 0x00U;
-    byte |= bits[2U] ? 0x20U : 0x00U;
-    byte |= bits[3U] ? 0x10U : 0x00U;
-    byte |= bits[4U] ? 0x08U : 0x00U;
-    byte |= bits[5U] ? 0x04U : 0x00U;
-    byte |= bits[6U] ? 0x02U : 0x00U;
-    byte |= bits[7U] ? 0x01U : 0x00U;
-}
-
-void DMR::byteToBitsBE(uint8_t byte, bool* bits)
-{
-    bits[0U] = (byte & 0x80U) == 0x80U;
-    bits[1U] = (byte & 0x40U) == 0x40U;
-    bits[2U] = (byte & 0x20U) == 0x20U;
-    bits[3U] = (byte & 0x10U) == 0x10U;
-    bits[4U] = (byte & 0x08U) == 0x08U;
-    bits[5U] = (byte & 0x04U) == 0x04U;
-    bits[6U] = (byte & 0x02U) == 0x02U;
-    bits[7U] = (byte & 0x01U) == 0x01U;
-}
-
-void DMR::lc_get_data(bool* bits)
-{
-    uint8_t bytes[9U];
-    memset(bytes, 0, 9);
-    lc_get_data(bytes);
-
-    byteToBitsBE(bytes[0U], bits + 0U);
-    byteToBitsBE(bytes[1U], bits + 8U);
-    byteToBitsBE(bytes[2U], bits + 16U);
-    byteToBitsBE(bytes[3U], bits + 24U);
-    byteToBitsBE(bytes[4U], bits + 32U);
-    byteToBitsBE(bytes[5U], bits + 40U);
-    byteToBitsBE(bytes[6U], bits + 48U);
-    byteToBitsBE(bytes[7U], bits + 56U);
-    byteToBitsBE(bytes[8U], bits + 64U);
-}
-
 void DMR::lc_get_data(uint8_t *bytes)
 {
     bool pf, r;
@@ -1009,7 +941,7 @@ void DMR::get_ambe()
 #if !defined(Q_OS_IOS)
     uint8_t ambe[9];
 
-    if(m_ambedev->get_ambe(ambe)){
+    if(m_ambedev->get_ambe(ambe, m_ambech)){
         for(int i = 0; i < 9; ++i){
             m_txcodecq.append(ambe[i]);
         }
@@ -1046,34 +978,50 @@ void DMR::process_rx_data()
         cnt = 0;
     }
 
-    if((!m_tx) && (m_rxcodecq.size() > 8) ){
+    if((!m_tx) && m_hwrx && (m_rxcodecq.size() > 8) ){
         for(int i = 0; i < 9; ++i){
             ambe[i] = m_rxcodecq.dequeue();
         }
-        if(m_hwrx){
 #if !defined(Q_OS_IOS)
-            m_ambedev->decode(ambe);
+        m_ambedev->decode(ambe, m_ambech);
 
-            if(m_ambedev->get_audio(pcm)){
-                m_audio->write(pcm, 160);
-                emit update_output_level(m_audio->level());
-            }
-#endif
+        if(m_ambedev->get_audio(pcm, m_ambech)){
+            m_audio->write(pcm, 160);
+            emit update_output_level(m_audio->level());
         }
-        else{
+#endif
+    }
+    else if((!m_tx) && !m_hwrx && ((m_rxcodecq.size() > 8) || m_rxpcmcnt) ){
+        // Decode a whole DMRD packet (3 AMBE frames) per vocoder call and play it out one frame per tick
+        if(!m_rxpcmcnt){
+            uint8_t ambe3[27];
+            uint8_t n = qMin(m_rxcodecq.size() / 9, 3);
+
+            for(int i = 0; i < (9 * n); ++i){
+                ambe3[i] = m_rxcodecq.dequeue();
+            }
             if(m_modeinfo.sw_vocoder_loaded){
-#ifdef USE_MD380_VOCODER
-                md380_decode_fec(ambe, pcm);
+#if defined(USE_MD380_VOCODER)
+                for(int i = 0; i < n; ++i){
+                    md380_decode_fec(&ambe3[9 * i], &m_rxpcm[160 * i]);
+                }
+#elif defined(VOCODER_PLUGIN)
+                for(int i = 0; i < n; ++i){
+                    m_mbevocoder->decode_2450x1150(&m_rxpcm[160 * i], &ambe3[9 * i]);
+                }
 #else
-                m_mbevocoder->decode_2450x1150(pcm, ambe);
+                m_mbevocoder->decode_2450x1150_batch(m_rxpcm, ambe3, n);
 #endif
             }
             else{
-                memset(pcm, 0, 160 * sizeof(int16_t));
+                memset(m_rxpcm, 0, n * 160 * sizeof(int16_t));
             }
-            m_audio->write(pcm, 160);
-            emit update_output_level(m_audio->level());
+            m_rxpcmcnt = n;
+            m_rxpcmidx = 0;
         }
+        m_audio->write(&m_rxpcm[160 * m_rxpcmidx++], 160);
+        m_rxpcmcnt--;
+        emit update_output_level(m_audio->level());
     }
     else if ( ((m_modeinfo.stream_state == STREAM_END) || (m_modeinfo.stream_state == STREAM_LOST)) && (m_rxmodemq.size() < 50) ){
         m_rxtimer->stop();
@@ -1081,6 +1029,7 @@ void DMR::process_rx_data()
         m_rxwatchdog = 0;
         m_modeinfo.streamid = 0;
         m_rxcodecq.clear();
+        m_rxpcmcnt = 0;
         qDebug() << "DMR playback stopped";
         m_modeinfo.stream_state = STREAM_IDLE;
         return;
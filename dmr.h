@@ -133,27 +133,25 @@ private:
     uint8_t m_txcc;
     uint8_t packet_size;
     uint8_t m_ambe[27];
+    int16_t m_rxpcm[3 * 160];
+    uint8_t m_rxpcmcnt;
+    uint8_t m_rxpcmidx;
     uint32_t m_defsrcid;
     uint8_t m_dmrFrame[55];
     uint8_t m_dataType;
     uint32_t m_dmrcnt;
     FLCO m_flco;
     CBPTC19696 m_bptc;
-    bool m_raw[128U];
-    bool m_data[72U];
+    uint8_t m_raw[16U];
     QString m_options;
     //QString m_firstName;
 
-    void byteToBitsBE(uint8_t byte, bool* bits);
-    void bitsToByteBE(const bool* bits, uint8_t& byte);
     void build_frame();
     void encode_header(uint8_t);
     void encode_data();
-    void encode16114(bool* d);
     void encode_qr1676(uint8_t* data);
     void get_slot_data(uint8_t* data);
     void lc_get_data(uint8_t*);
-    void lc_get_data(bool* bits);
     void encode_embedded_data();
     uint8_t get_embedded_data(uint8_t* data, uint8_t n);
     void get_emb_data(uint8_t* data, uint8_t lcss);
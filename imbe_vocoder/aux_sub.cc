@@ -24,6 +24,17 @@
 #include "aux_sub.h"
 #include "tbls.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define IMBE_AUX_X86
+#include <immintrin.h>
+#endif
+
 //-----------------------------------------------------------------------------
 //	PURPOSE:
 //		Return pointer to bit allocation array 
@@ -149,14 +160,39 @@ void v_equ(Word16 *vec1, Word16 *vec2, Word16 n)
 //-----------------------------------------------------------------------------
 Word32 L_v_magsq(Word16 *vec, Word16 n)
 {
-	Word32 L_magsq = 0;
+	// Every term is >= 0, so the saturating accumulation only ever clips at
+	// MAX_32 and the result is min(sum, MAX_32) whatever the order. A pair of
+	// squares is at most 2^31, exact as an unsigned 32 bit lane.
+	unsigned long long sum = 0;
+	Word16 i = 0;
 
-	while(n--)
+#if defined(__SSE2__)
+	UWord32 pairs[4];
+	__m128i acc = _mm_setzero_si128();
+	for(; i + 8 <= n; i += 8)
 	{
-		L_magsq = L_mac(L_magsq, *vec, *vec);
-		vec++;
+		const __m128i v = _mm_loadu_si128((const __m128i *)&vec[i]);
+		const __m128i sq = _mm_madd_epi16(v, v);
+		acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sq, _mm_setzero_si128()));
+		acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(sq, _mm_setzero_si128()));
 	}
-	return L_magsq;
+	_mm_storeu_si128((__m128i *)pairs, acc);
+	sum = ((unsigned long long)pairs[1] << 32 | pairs[0]) + ((unsigned long long)pairs[3] << 32 | pairs[2]);
+#elif defined(__ARM_NEON)
+	uint64x2_t acc = vdupq_n_u64(0);
+	for(; i + 8 <= n; i += 8)
+	{
+		const int16x8_t v = vld1q_s16(&vec[i]);
+		acc = vpadalq_u32(acc, vreinterpretq_u32_s32(vmull_s16(vget_low_s16(v), vget_low_s16(v))));
+		acc = vpadalq_u32(acc, vreinterpretq_u32_s32(vmull_s16(vget_high_s16(v), vget_high_s16(v))));
+	}
+	sum = vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+#endif
+	for(; i < n; i++)
+		sum += (UWord32)((Word32)vec[i] * vec[i]);
+
+	sum <<= 1;
+	return (sum > (unsigned long long)MAX_32) ? MAX_32 : (Word32)sum;
 } 
 
 //-----------------------------------------------------------------------------
@@ -178,7 +214,325 @@ Word32 L_v_magsq(Word16 *vec, Word16 n)
 //-----------------------------------------------------------------------------
 void v_equ_shr(Word16 *vec1, Word16 *vec2, Word16 scale, Word16 n)
 {
-	while(n--)
-		*vec1++ = shr(*vec2++,scale);   
+	Word16 i = 0;
+
+	// shr() clamps the right shift at 15 and a left shift (scale < 0) at 16
+	scale = (scale > 15) ? 15 : ((scale < -16) ? -16 : scale);
+#if defined(__SSE2__)
+	if(scale >= 0)
+	{
+		const __m128i cnt = _mm_cvtsi32_si128(scale);
+		for(; i + 8 <= n; i += 8)
+			_mm_storeu_si128((__m128i *)&vec1[i], _mm_sra_epi16(_mm_loadu_si128((const __m128i *)&vec2[i]), cnt));
+	}
+	else
+	{
+		const __m128i cnt = _mm_cvtsi32_si128(-scale);
+		for(; i + 8 <= n; i += 8)
+		{
+			const __m128i v = _mm_loadu_si128((const __m128i *)&vec2[i]);
+			const __m128i lo = _mm_sll_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16), cnt);
+			const __m128i hi = _mm_sll_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16), cnt);
+			_mm_storeu_si128((__m128i *)&vec1[i], _mm_packs_epi32(lo, hi));
+		}
+	}
+#elif defined(__ARM_NEON)
+	const int16x8_t cnt = vdupq_n_s16(-scale);
+	for(; i + 8 <= n; i += 8)
+		vst1q_s16(&vec1[i], vqshlq_s16(vld1q_s16(&vec2[i]), cnt));
+#endif
+	for(; i < n; i++)
+		vec1[i] = shr(vec2[i], scale);
 }
 
+//-----------------------------------------------------------------------------
+//	PURPOSE:
+//		Compute sum(L_shr(L_mult(vec1[i], vec2[i]), scale)) without
+//		saturation. Equal to the L_add() accumulation only when the sum of
+//		the magnitudes of the terms fits in 32 bits and no element is
+//		-32768, the caller checks that.
+//
+//	INPUT:
+//		vec1      - Pointer to the first vector
+//		vec2      - Pointer to the second vector
+//		scale     - right shift factor applied to every product, 0...15
+//		n         - size of input vectors
+//
+//	OUTPUT:
+//		none
+//
+//	RETURN:
+//		32 bit long signed integer result  
+//
+//-----------------------------------------------------------------------------
+Word32 L_v_dot_shr(Word16 *vec1, Word16 *vec2, Word16 scale, Word16 n)
+{
+	Word32 L_sum = 0;
+	Word16 i = 0;
+
+	// (2 * a * b) >> scale == (a * b) >> (scale - 1), which keeps the
+	// products exact for every input except -32768 * -32768
+#if defined(__SSE2__)
+	Word32 lanes[4];
+	__m128i acc = _mm_setzero_si128();
+	if(scale == 0)
+	{
+		for(; i + 8 <= n; i += 8)
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&vec1[i]), _mm_loadu_si128((const __m128i *)&vec2[i])));
+		acc = _mm_slli_epi32(acc, 1);
+	}
+	else
+	{
+		const __m128i cnt = _mm_cvtsi32_si128(scale - 1);
+		for(; i + 8 <= n; i += 8)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i *)&vec1[i]);
+			const __m128i b = _mm_loadu_si128((const __m128i *)&vec2[i]);
+			const __m128i lo = _mm_mullo_epi16(a, b);
+			const __m128i hi = _mm_mulhi_epi16(a, b);
+			acc = _mm_add_epi32(acc, _mm_sra_epi32(_mm_unpacklo_epi16(lo, hi), cnt));
+			acc = _mm_add_epi32(acc, _mm_sra_epi32(_mm_unpackhi_epi16(lo, hi), cnt));
+		}
+	}
+	_mm_storeu_si128((__m128i *)lanes, acc);
+	L_sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__ARM_NEON)
+	int32x4_t acc = vdupq_n_s32(0);
+	const int32x4_t cnt = vdupq_n_s32((scale == 0) ? 1 : (1 - scale));
+	for(; i + 8 <= n; i += 8)
+	{
+		const int16x8_t a = vld1q_s16(&vec1[i]);
+		const int16x8_t b = vld1q_s16(&vec2[i]);
+		acc = vaddq_s32(acc, vshlq_s32(vmull_s16(vget_low_s16(a), vget_low_s16(b)), cnt));
+		acc = vaddq_s32(acc, vshlq_s32(vmull_s16(vget_high_s16(a), vget_high_s16(b)), cnt));
+	}
+	L_sum = vgetq_lane_s32(acc, 0) + vgetq_lane_s32(acc, 1) + vgetq_lane_s32(acc, 2) + vgetq_lane_s32(acc, 3);
+#endif
+	for(; i < n; i++)
+		L_sum += L_shr(L_mult(vec1[i], vec2[i]), scale);
+
+	return L_sum;
+}
+
+//-----------------------------------------------------------------------------
+//	PURPOSE:
+//		Compute the correlation of a 16 bit vector with itself for a range
+//		of lags, corr[k] = L_v_dot_shr(vec, &vec[lag], scale, n - lag)
+//		with lag = lag_beg + k. The same overflow conditions as for
+//		L_v_dot_shr apply to the whole vector.
+//
+//	INPUT:
+//		corr      - Pointer to the output buffer, lag_end - lag_beg + 1 items
+//		vec       - Pointer to the vector
+//		lag_beg   - first lag, 1...n
+//		lag_end   - last lag, lag_beg...n
+//		scale     - right shift factor applied to every product, 0...15
+//		n         - size of input vector
+//
+//	OUTPUT:
+//		Correlation values in corr
+//
+//	RETURN:
+//		None
+//
+//-----------------------------------------------------------------------------
+typedef void (*xcorr_fn)(Word32 *, Word16 *, Word16, Word16, Word16, Word16);
+
+static void L_v_xcorr_shr_generic(Word32 *corr, Word16 *vec, Word16 lag_beg, Word16 lag_end, Word16 scale, Word16 n)
+{
+	Word16 lag;
+
+	for(lag = lag_beg; lag <= lag_end; lag++)
+		corr[lag - lag_beg] = L_v_dot_shr(vec, &vec[lag], scale, n - lag);
+}
+
+#ifdef IMBE_AUX_X86
+__attribute__((target("avx2")))
+static void L_v_xcorr_shr_avx2(Word32 *corr, Word16 *vec, Word16 lag_beg, Word16 lag_end, Word16 scale, Word16 n)
+{
+	const __m128i cnt = _mm_cvtsi32_si128((scale == 0) ? 0 : scale - 1);
+	Word16 lag, i, len;
+	Word16 *vec2;
+	Word32 L_sum;
+
+	for(lag = lag_beg; lag <= lag_end; lag++)
+	{
+		__m256i acc = _mm256_setzero_si256();
+		__m128i s;
+
+		len = n - lag;
+		vec2 = &vec[lag];
+		i = 0;
+		if(scale == 0)
+		{
+			for(; i + 16 <= len; i += 16)
+				acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)&vec[i]), _mm256_loadu_si256((const __m256i *)&vec2[i])));
+			acc = _mm256_slli_epi32(acc, 1);
+		}
+		else
+		{
+			for(; i + 16 <= len; i += 16)
+			{
+				const __m256i a = _mm256_loadu_si256((const __m256i *)&vec[i]);
+				const __m256i b = _mm256_loadu_si256((const __m256i *)&vec2[i]);
+				const __m256i lo = _mm256_mullo_epi16(a, b);
+				const __m256i hi = _mm256_mulhi_epi16(a, b);
+				acc = _mm256_add_epi32(acc, _mm256_sra_epi32(_mm256_unpacklo_epi16(lo, hi), cnt));
+				acc = _mm256_add_epi32(acc, _mm256_sra_epi32(_mm256_unpackhi_epi16(lo, hi), cnt));
+			}
+		}
+		s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+		L_sum = _mm_cvtsi128_si32(s);
+		for(; i < len; i++)
+			L_sum += L_shr(L_mult(vec[i], vec2[i]), scale);
+		corr[lag - lag_beg] = L_sum;
+	}
+	_mm256_zeroupper();
+}
+#endif
+
+static xcorr_fn best_xcorr(void)
+{
+#ifdef IMBE_AUX_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return L_v_xcorr_shr_avx2;
+#endif
+	return L_v_xcorr_shr_generic;
+}
+
+void L_v_xcorr_shr(Word32 *corr, Word16 *vec, Word16 lag_beg, Word16 lag_end, Word16 scale, Word16 n)
+{
+	static const xcorr_fn xcorr = best_xcorr();
+
+	xcorr(corr, vec, lag_beg, lag_end, scale, n);
+}
+
+//-----------------------------------------------------------------------------
+//	PURPOSE:
+//		Sliding correlation of a 16 bit vector with a set of coefficients,
+//		vec_out[i] = round(sum(L_mult(vec[i + k], coef[k]))), k = 0...ord-1,
+//		without saturation. Equal to the L_mac() accumulation only when
+//		2 * sum(|vec[i + k] * coef[k]|) + 0x8000 fits in 32 bits for every
+//		output, the caller checks that.
+//
+//	INPUT:
+//		vec_out   - Pointer to the output vector, n items
+//		vec       - Pointer to the input vector, n + ord - 1 items
+//		coef      - Pointer to the coefficients
+//		ord       - number of coefficients
+//		n         - number of output samples
+//
+//	OUTPUT:
+//		Filtered signal in vec_out
+//
+//	RETURN:
+//		None
+//
+//-----------------------------------------------------------------------------
+void v_corr_r(Word16 *vec_out, Word16 *vec, const Word16 *coef, Word16 ord, Word16 n)
+{
+	Word16 i = 0, k;
+	Word32 L_sum;
+
+	// Eight outputs at a time, round(2 * sum) == (sum + 0x4000) >> 15
+#if defined(__SSE2__)
+	const __m128i rnd = _mm_set1_epi32(0x4000);
+	for(; i + 8 <= n; i += 8)
+	{
+		__m128i acc_lo = _mm_setzero_si128();
+		__m128i acc_hi = _mm_setzero_si128();
+		for(k = 0; k + 2 <= ord; k += 2)
+		{
+			// Interleaved samples of two neighbouring taps, one madd per tap pair
+			const __m128i c = _mm_unpacklo_epi16(_mm_set1_epi16(coef[k]), _mm_set1_epi16(coef[k + 1]));
+			const __m128i x0 = _mm_loadu_si128((const __m128i *)&vec[i + k]);
+			const __m128i x1 = _mm_loadu_si128((const __m128i *)&vec[i + k + 1]);
+			acc_lo = _mm_add_epi32(acc_lo, _mm_madd_epi16(_mm_unpacklo_epi16(x0, x1), c));
+			acc_hi = _mm_add_epi32(acc_hi, _mm_madd_epi16(_mm_unpackhi_epi16(x0, x1), c));
+		}
+		if(k < ord)
+		{
+			const __m128i c = _mm_unpacklo_epi16(_mm_set1_epi16(coef[k]), _mm_setzero_si128());
+			const __m128i x0 = _mm_loadu_si128((const __m128i *)&vec[i + k]);
+			acc_lo = _mm_add_epi32(acc_lo, _mm_madd_epi16(_mm_unpacklo_epi16(x0, _mm_setzero_si128()), c));
+			acc_hi = _mm_add_epi32(acc_hi, _mm_madd_epi16(_mm_unpackhi_epi16(x0, _mm_setzero_si128()), c));
+		}
+		acc_lo = _mm_srai_epi32(_mm_add_epi32(acc_lo, rnd), 15);
+		acc_hi = _mm_srai_epi32(_mm_add_epi32(acc_hi, rnd), 15);
+		_mm_storeu_si128((__m128i *)&vec_out[i], _mm_packs_epi32(acc_lo, acc_hi));
+	}
+#elif defined(__ARM_NEON)
+	for(; i + 8 <= n; i += 8)
+	{
+		int32x4_t acc_lo = vdupq_n_s32(0);
+		int32x4_t acc_hi = vdupq_n_s32(0);
+		for(k = 0; k < ord; k++)
+		{
+			const int16x8_t x = vld1q_s16(&vec[i + k]);
+			acc_lo = vmlal_n_s16(acc_lo, vget_low_s16(x), coef[k]);
+			acc_hi = vmlal_n_s16(acc_hi, vget_high_s16(x), coef[k]);
+		}
+		vst1q_s16(&vec_out[i], vcombine_s16(vrshrn_n_s32(acc_lo, 15), vrshrn_n_s32(acc_hi, 15)));
+	}
+#endif
+	for(; i < n; i++)
+	{
+		L_sum = 0;
+		for(k = 0; k < ord; k++)
+			L_sum += L_mult(vec[i + k], coef[k]);
+		vec_out[i] = round(L_sum);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//	PURPOSE:
+//		Find the minimum of a 16 bit input vector
+//
+//	INPUT:
+//		vec       - Pointer to the vector
+//		n         - size of input vector, at least 1
+//
+//	OUTPUT:
+//		none
+//
+//	RETURN:
+//		The smallest element of vec
+//
+//-----------------------------------------------------------------------------
+Word16 v_min(Word16 *vec, Word16 n)
+{
+	Word16 i = 0, min_val = vec[0];
+
+#if defined(__SSE2__)
+	if(n >= 8)
+	{
+		__m128i m = _mm_loadu_si128((const __m128i *)vec);
+		for(i = 8; i + 8 <= n; i += 8)
+			m = _mm_min_epi16(m, _mm_loadu_si128((const __m128i *)&vec[i]));
+		m = _mm_min_epi16(m, _mm_shuffle_epi32(m, 0x4e));
+		m = _mm_min_epi16(m, _mm_shuffle_epi32(m, 0xb1));
+		m = _mm_min_epi16(m, _mm_shufflelo_epi16(m, 0xb1));
+		min_val = (Word16)_mm_cvtsi128_si32(m);
+	}
+#elif defined(__ARM_NEON)
+	if(n >= 8)
+	{
+		int16x8_t m = vld1q_s16(vec);
+		int16x4_t h;
+		for(i = 8; i + 8 <= n; i += 8)
+			m = vminq_s16(m, vld1q_s16(&vec[i]));
+		h = vmin_s16(vget_low_s16(m), vget_high_s16(m));
+		h = vpmin_s16(h, h);
+		h = vpmin_s16(h, h);
+		min_val = vget_lane_s16(h, 0);
+	}
+#endif
+	for(; i < n; i++)
+		if(vec[i] < min_val)
+			min_val = vec[i];
+
+	return min_val;
+}
@@ -130,4 +130,91 @@ Word32 L_v_magsq(Word16 *vec, Word16 n);
 //-----------------------------------------------------------------------------
 void v_equ_shr(Word16 *vec1, Word16 *vec2, Word16 scale, Word16 n);
 
+//-----------------------------------------------------------------------------
+//	PURPOSE:
+//		Compute sum(L_shr(L_mult(vec1[i], vec2[i]), scale)) without
+//		saturation. Equal to the L_add() accumulation only when the sum of
+//		the magnitudes of the terms fits in 32 bits and no element is
+//		-32768, the caller checks that.
+//
+//	INPUT:
+//		vec1      - Pointer to the first vector
+//		vec2      - Pointer to the second vector
+//		scale     - right shift factor applied to every product, 0...15
+//		n         - size of input vectors
+//
+//	OUTPUT:
+//		none
+//
+//	RETURN:
+//		32 bit long signed integer result  
+//
+//-----------------------------------------------------------------------------
+Word32 L_v_dot_shr(Word16 *vec1, Word16 *vec2, Word16 scale, Word16 n);
+
+//-----------------------------------------------------------------------------
+//	PURPOSE:
+//		Compute the correlation of a 16 bit vector with itself for a range
+//		of lags, corr[k] = L_v_dot_shr(vec, &vec[lag], scale, n - lag)
+//		with lag = lag_beg + k. The same overflow conditions as for
+//		L_v_dot_shr apply to the whole vector.
+//
+//	INPUT:
+//		corr      - Pointer to the output buffer, lag_end - lag_beg + 1 items
+//		vec       - Pointer to the vector
+//		lag_beg   - first lag, 1...n
+//		lag_end   - last lag, lag_beg...n
+//		scale     - right shift factor applied to every product, 0...15
+//		n         - size of input vector
+//
+//	OUTPUT:
+//		Correlation values in corr
+//
+//	RETURN:
+//		None
+//
+//-----------------------------------------------------------------------------
+void L_v_xcorr_shr(Word32 *corr, Word16 *vec, Word16 lag_beg, Word16 lag_end, Word16 scale, Word16 n);
+
+//-----------------------------------------------------------------------------
+//	PURPOSE:
+//		Sliding correlation of a 16 bit vector with a set of coefficients,
+//		vec_out[i] = round(sum(L_mult(vec[i + k], coef[k]))), k = 0...ord-1,
+//		without saturation. Equal to the L_mac() accumulation only when
+//		2 * sum(|vec[i + k] * coef[k]|) + 0x8000 fits in 32 bits for every
+//		output, the caller checks that.
+//
+//	INPUT:
+//		vec_out   - Pointer to the output vector, n items
+//		vec       - Pointer to the input vector, n + ord - 1 items
+//		coef      - Pointer to the coefficients
+//		ord       - number of coefficients
+//		n         - number of output samples
+//
+//	OUTPUT:
+//		Filtered signal in vec_out
+//
+//	RETURN:
+//		None
+//
+//-----------------------------------------------------------------------------
+void v_corr_r(Word16 *vec_out, Word16 *vec, const Word16 *coef, Word16 ord, Word16 n);
+
+//-----------------------------------------------------------------------------
+//	PURPOSE:
+//		Find the minimum of a 16 bit input vector
+//
+//	INPUT:
+//		vec       - Pointer to the vector
+//		n         - size of input vector, at least 1
+//
+//	OUTPUT:
+//		none
+//
+//	RETURN:
+//		The smallest element of vec
+//
+//-----------------------------------------------------------------------------
+Word16 v_min(Word16 *vec, Word16 n);
+
 #endif
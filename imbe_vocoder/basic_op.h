@@ -25,6 +25,11 @@
  | $Id $
  |___________________________________________________________________________|
 */
+#ifndef BASIC_OP_H
+#define BASIC_OP_H
+
+#include "typedef.h"
+
 extern Flag Overflow;
 extern Flag Carry;
 
@@ -36,50 +41,295 @@ extern Flag Carry;
 
 /*___________________________________________________________________________
  |                                                                           |
- |   Prototypes for basic arithmetic operators                               |
+ |   Prototypes for the out-of-line operators (basicop2.cc)                  |
+ |                                                                           |
+ |   These read or update the Overflow / Carry flags.                        |
  |___________________________________________________________________________|
 */
 
-Word16 add (Word16 var1, Word16 var2);    /* Short add,           1   */
-Word16 sub (Word16 var1, Word16 var2);    /* Short sub,           1   */
-Word16 abs_s (Word16 var1);               /* Short abs,           1   */
-Word16 shl (Word16 var1, Word16 var2);    /* Short shift left,    1   */
-Word16 shr (Word16 var1, Word16 var2);    /* Short shift right,   1   */
-Word16 mult (Word16 var1, Word16 var2);   /* Short mult,          1   */
-Word32 L_mult (Word16 var1, Word16 var2); /* Long mult,           1   */
-Word16 negate (Word16 var1);              /* Short negate,        1   */
-Word16 extract_h (Word32 L_var1);         /* Extract high,        1   */
-Word16 extract_l (Word32 L_var1);         /* Extract low,         1   */
-Word16 round (Word32 L_var1);             /* Round,               1   */
-Word32 L_mac (Word32 L_var3, Word16 var1, Word16 var2);   /* Mac,  1  */
-Word32 L_msu (Word32 L_var3, Word16 var1, Word16 var2);   /* Msu,  1  */
 Word32 L_macNs (Word32 L_var3, Word16 var1, Word16 var2); /* Mac without
                                                              sat, 1   */
 Word32 L_msuNs (Word32 L_var3, Word16 var1, Word16 var2); /* Msu without
                                                              sat, 1   */
-Word32 L_add (Word32 L_var1, Word32 L_var2);    /* Long add,        2 */
-Word32 L_sub (Word32 L_var1, Word32 L_var2);    /* Long sub,        2 */
 Word32 L_add_c (Word32 L_var1, Word32 L_var2);  /* Long add with c, 2 */
 Word32 L_sub_c (Word32 L_var1, Word32 L_var2);  /* Long sub with c, 2 */
-Word32 L_negate (Word32 L_var1);                /* Long negate,     2 */
-Word16 mult_r (Word16 var1, Word16 var2);       /* Mult with round, 2 */
-Word32 L_shl (Word32 L_var1, Word16 var2);      /* Long shift left, 2 */
-Word32 L_shr (Word32 L_var1, Word16 var2);      /* Long shift right, 2*/
-Word16 shr_r (Word16 var1, Word16 var2);        /* Shift right with
-                                                   round, 2           */
-Word16 mac_r (Word32 L_var3, Word16 var1, Word16 var2); /* Mac with
-                                                           rounding,2 */
-Word16 msu_r (Word32 L_var3, Word16 var1, Word16 var2); /* Msu with
-                                                           rounding,2 */
-Word32 L_deposit_h (Word16 var1);        /* 16 bit var1 -> MSB,     2 */
-Word32 L_deposit_l (Word16 var1);        /* 16 bit var1 -> LSB,     2 */
-
-Word32 L_shr_r (Word32 L_var1, Word16 var2); /* Long shift right with
-                                                round,  3             */
-Word32 L_abs (Word32 L_var1);            /* Long abs,              3  */
 Word32 L_sat (Word32 L_var1);            /* Long saturation,       4  */
-Word16 norm_s (Word16 var1);             /* Short norm,           15  */
-Word16 div_s (Word16 var1, Word16 var2); /* Short division,       18  */
-Word16 norm_l (Word32 L_var1);           /* Long norm,            30  */   
+void div_s_error (Word16 var1, Word16 var2);
+
+/*___________________________________________________________________________
+ |                                                                           |
+ |   Inline basic arithmetic operators                                       |
+ |                                                                           |
+ |   Same results as the ETSI reference versions, written without overflow   |
+ |   branches so they can be inlined into (and vectorized with) the calling  |
+ |   loops. They do not set the Overflow flag; nothing in the vocoder reads  |
+ |   it outside of L_add_c / L_sub_c / L_sat, which keep their own state.    |
+ |___________________________________________________________________________|
+*/
+
+static inline Word16 saturate (Word32 L_var1)
+{
+    return (Word16) ((L_var1 > 0x00007fffL) ? 0x00007fffL : ((L_var1 < -0x00008000L) ? -0x00008000L : L_var1));
+}
+
+static inline Word32 L_saturate (Word32 L_var1)     /* overflow result with the sign of L_var1 */
+{
+    return (L_var1 < 0) ? MIN_32 : MAX_32;
+}
+
+/* Short add,           1   */
+static inline Word16 add (Word16 var1, Word16 var2)
+{
+    return saturate ((Word32) var1 + var2);
+}
+
+/* Short sub,           1   */
+static inline Word16 sub (Word16 var1, Word16 var2)
+{
+    return saturate ((Word32) var1 - var2);
+}
+
+/* Short abs,           1   */
+static inline Word16 abs_s (Word16 var1)
+{
+    return saturate ((var1 < 0) ? -(Word32) var1 : (Word32) var1);
+}
+
+/* Short negate,        1   */
+static inline Word16 negate (Word16 var1)
+{
+    return saturate (-(Word32) var1);
+}
+
+/* Short shift left,    1   */
+static inline Word16 shl (Word16 var1, Word16 var2)
+{
+    if (var2 < 0)
+    {
+        var2 = (var2 < -15) ? 15 : -var2;
+        return (Word16) (var1 >> var2);
+    }
+    /* |var1| << 16 still fits in 32 bits and saturates any non-zero var1 */
+    return saturate ((Word32) var1 * ((Word32) 1 << ((var2 > 16) ? 16 : var2)));
+}
+
+/* Short shift right,   1   */
+static inline Word16 shr (Word16 var1, Word16 var2)
+{
+    if (var2 < 0)
+    {
+        var2 = (var2 < -16) ? 16 : -var2;
+        return saturate ((Word32) var1 * ((Word32) 1 << var2));
+    }
+    return (Word16) (var1 >> ((var2 > 15) ? 15 : var2));
+}
+
+/* Short mult,          1   */
+static inline Word16 mult (Word16 var1, Word16 var2)
+{
+    return saturate (((Word32) var1 * (Word32) var2) >> 15);
+}
+
+/* Long mult,           1   */
+static inline Word32 L_mult (Word16 var1, Word16 var2)
+{
+    const Word32 L_product = (Word32) var1 * (Word32) var2;
+
+    return (L_product == (Word32) 0x40000000L) ? MAX_32 : (L_product * 2);
+}
+
+/* Extract high,        1   */
+static inline Word16 extract_h (Word32 L_var1)
+{
+    return (Word16) (L_var1 >> 16);
+}
+
+/* Extract low,         1   */
+static inline Word16 extract_l (Word32 L_var1)
+{
+    return (Word16) L_var1;
+}
+
+/* Long add,        2 */
+static inline Word32 L_add (Word32 L_var1, Word32 L_var2)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    Word32 L_var_out;
+
+    if (__builtin_add_overflow (L_var1, L_var2, &L_var_out))
+        L_var_out = L_saturate (L_var1);
+    return L_var_out;
+#else
+    const Word32 L_var_out = (Word32) ((UWord32) L_var1 + (UWord32) L_var2);
+
+    return (((L_var1 ^ L_var2) & MIN_32) == 0 && ((L_var_out ^ L_var1) & MIN_32)) ? L_saturate (L_var1) : L_var_out;
+#endif
+}
+
+/* Long sub,        2 */
+static inline Word32 L_sub (Word32 L_var1, Word32 L_var2)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    Word32 L_var_out;
+
+    if (__builtin_sub_overflow (L_var1, L_var2, &L_var_out))
+        L_var_out = L_saturate (L_var1);
+    return L_var_out;
+#else
+    const Word32 L_var_out = (Word32) ((UWord32) L_var1 - (UWord32) L_var2);
+
+    return (((L_var1 ^ L_var2) & MIN_32) != 0 && ((L_var_out ^ L_var1) & MIN_32)) ? L_saturate (L_var1) : L_var_out;
+#endif
+}
+
+/* Long negate,     2 */
+static inline Word32 L_negate (Word32 L_var1)
+{
+    return (L_var1 == MIN_32) ? MAX_32 : -L_var1;
+}
+
+/* Long abs,              3  */
+static inline Word32 L_abs (Word32 L_var1)
+{
+    return (L_var1 == MIN_32) ? MAX_32 : ((L_var1 < 0) ? -L_var1 : L_var1);
+}
+
+/* Round,               1   */
+static inline Word16 round (Word32 L_var1)
+{
+    return extract_h (L_add (L_var1, (Word32) 0x00008000L));
+}
+
+/* Mac,  1  */
+static inline Word32 L_mac (Word32 L_var3, Word16 var1, Word16 var2)
+{
+    return L_add (L_var3, L_mult (var1, var2));
+}
+
+/* Msu,  1  */
+static inline Word32 L_msu (Word32 L_var3, Word16 var1, Word16 var2)
+{
+    return L_sub (L_var3, L_mult (var1, var2));
+}
+
+/* Mult with round, 2 */
+static inline Word16 mult_r (Word16 var1, Word16 var2)
+{
+    return saturate ((((Word32) var1 * (Word32) var2) + (Word32) 0x00004000L) >> 15);
+}
+
+/* Long shift left, 2 */
+static inline Word32 L_shl (Word32 L_var1, Word16 var2)
+{
+    if (var2 <= 0)
+    {
+        var2 = (var2 < -31) ? 31 : -var2;
+        return L_var1 >> var2;
+    }
+    var2 = (var2 > 31) ? 31 : var2;
+
+    const Word32 L_var_out = (Word32) ((UWord32) L_var1 << var2);
+
+    return ((L_var_out >> var2) == L_var1) ? L_var_out : L_saturate (L_var1);
+}
+
+/* Long shift right, 2*/
+static inline Word32 L_shr (Word32 L_var1, Word16 var2)
+{
+    if (var2 < 0)
+        return L_shl (L_var1, (var2 < -32) ? 32 : -var2);
+    return L_var1 >> ((var2 > 31) ? 31 : var2);
+}
+
+/* Shift right with round, 2           */
+static inline Word16 shr_r (Word16 var1, Word16 var2)
+{
+    if (var2 > 15)
+        return 0;
+    if (var2 <= 0)
+        return shr (var1, var2);
+    return (Word16) ((var1 >> var2) + ((var1 >> (var2 - 1)) & 1));
+}
+
+/* Mac with rounding,2 */
+static inline Word16 mac_r (Word32 L_var3, Word16 var1, Word16 var2)
+{
+    return round (L_mac (L_var3, var1, var2));
+}
+
+/* Msu with rounding,2 */
+static inline Word16 msu_r (Word32 L_var3, Word16 var1, Word16 var2)
+{
+    return round (L_msu (L_var3, var1, var2));
+}
+
+/* 16 bit var1 -> MSB,     2 */
+static inline Word32 L_deposit_h (Word16 var1)
+{
+    return (Word32) var1 << 16;
+}
+
+/* 16 bit var1 -> LSB,     2 */
+static inline Word32 L_deposit_l (Word16 var1)
+{
+    return (Word32) var1;
+}
+
+/* Long shift right with round,  3             */
+static inline Word32 L_shr_r (Word32 L_var1, Word16 var2)
+{
+    if (var2 > 31)
+        return 0;
+    if (var2 <= 0)
+        return L_shr (L_var1, var2);
+    return (L_var1 >> var2) + ((L_var1 >> (var2 - 1)) & 1);
+}
+
+/* Short norm,           15  */
+static inline Word16 norm_s (Word16 var1)
+{
+    const Word32 L_x = (var1 < 0) ? ~(Word32) var1 : (Word32) var1;
+
+    if (var1 == 0)
+        return 0;
+    if (L_x == 0)
+        return 15;
+#if defined(__GNUC__) || defined(__clang__)
+    return (Word16) (__builtin_clz ((UWord32) L_x) - 17);
+#else
+    Word16 var_out = 0;
+    for (Word32 L_y = L_x; L_y < 0x4000; L_y <<= 1)
+        var_out++;
+    return var_out;
+#endif
+}
+
+/* Long norm,            30  */
+static inline Word16 norm_l (Word32 L_var1)
+{
+    const UWord32 L_x = (UWord32) ((L_var1 < 0) ? ~L_var1 : L_var1);
+
+    if (L_var1 == 0)
+        return 0;
+    if (L_x == 0)
+        return 31;
+#if defined(__GNUC__) || defined(__clang__)
+    return (Word16) (__builtin_clz (L_x) - 1);
+#else
+    Word16 var_out = 0;
+    for (UWord32 L_y = L_x; L_y < 0x40000000UL; L_y <<= 1)
+        var_out++;
+    return var_out;
+#endif
+}
+
+/* Short division,       18  */
+static inline Word16 div_s (Word16 var1, Word16 var2)
+{
+    if ((var1 > var2) || (var1 < 0) || (var2 <= 0))
+        div_s_error (var1, var2);
+    /* the reference restoring division yields floor(var1 * 2^15 / var2) */
+    return (var1 == var2) ? MAX_16 : (Word16) (((Word32) var1 << 15) / var2);
+}
 
-
+#endif // BASIC_OP_H
@@ -28,6 +28,292 @@
 #include "encode.h"
 #include "imbe_vocoder_impl.h"
 
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define IMBE_FFT_X86
+#include <immintrin.h>
+#endif
+
+#define DCT_LEN_MAX 15	// block lengths are coded in 4 bits
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Cosine tables for dct()/idct(), one per transform length. The angles are
+// accumulated exactly as the direct-form loops did, so every entry is the
+// cos_fxp() value those loops would have computed.
+//-----------------------------------------------------------------------------
+struct DctTables
+{
+	Word16 idct_cos[DCT_LEN_MAX + 1][DCT_LEN_MAX][DCT_LEN_MAX];	// [m_lim][i][m]
+	Word16 dct_cos[DCT_LEN_MAX + 1][DCT_LEN_MAX][DCT_LEN_MAX];	// [m_lim][i][m]
+	Word16 dct_scale[DCT_LEN_MAX + 1];							// 1/m_lim, Q1.15
+};
+
+DctTables make_dct_tables()
+{
+	DctTables t = {};
+
+	for(Word16 m_lim = 1; m_lim <= DCT_LEN_MAX; m_lim++)
+	{
+		UWord16 angl_intl, angl_intl_2;
+
+		if(m_lim == 1)
+		{
+			angl_intl   = CNST_0_5_Q1_15;
+			angl_intl_2 = CNST_1_0_Q1_15;
+		}
+		else
+		{
+			angl_intl   = div_s ((Word16) CNST_0_5_Q5_11, m_lim << 11); // calculate 0.5/m_lim
+			angl_intl_2 = shl(angl_intl, 1);
+		}
+		t.dct_scale[m_lim] = angl_intl_2;
+
+		UWord16 angl_step = angl_intl;
+		for(Word16 i = 0; i < m_lim; i++)
+		{
+			UWord16 angl_acc = angl_step;
+			for(Word16 m = 1; m < m_lim; m++)
+			{
+				t.idct_cos[m_lim][i][m] = cos_fxp(angl_acc);
+				angl_acc += angl_step;
+			}
+			angl_step += angl_intl_2;
+		}
+
+		UWord16 angl_begin = angl_intl;
+		angl_step = angl_intl_2;
+		for(Word16 i = 1; i < m_lim; i++)
+		{
+			UWord16 angl_acc = angl_begin;
+			for(Word16 m = 0; m < m_lim; m++)
+			{
+				t.dct_cos[m_lim][i][m] = cos_fxp(angl_acc);
+				angl_acc += angl_step;
+			}
+			angl_step  += angl_intl_2;
+			angl_begin += angl_intl;
+		}
+	}
+	return t;
+}
+
+const DctTables &dct_tables()
+{
+	static const DctTables t = make_dct_tables();
+	return t;
+}
+
+//-----------------------------------------------------------------------------
+// FFT tables: the bit reversal swaps and, for every stage, its twiddles laid
+// out for a multiply-add against interleaved (re, im) data. Stage s has
+// h = 2^s butterflies per block, its twiddles start at entry h - 1.
+//-----------------------------------------------------------------------------
+struct FftTables
+{
+	Word16 num_swaps;
+	Word16 swap[FFTLENGTH][2];
+	Word16 tw_r[2][FFTLENGTH][2];	// [isign < 0][h - 1 + k] = {wr, -wi}
+	Word16 tw_i[2][FFTLENGTH][2];	// [isign < 0][h - 1 + k] = {wi, wr}
+};
+
+FftTables make_fft_tables()
+{
+	FftTables t = {};
+	Word16 wr_array[FFTLENGTH / 2 + 1];
+	Word16 wi_array[FFTLENGTH / 2 + 1];
+	Word16 i, j, m, fft_len2, shift, step, theta;
+
+	fft_len2 = shr(FFTLENGTH, 1);
+	shift    = norm_s(fft_len2);
+	step     = shl(2, shift);
+	theta    = 0;
+
+	for(i = 0; i <= fft_len2; i++) 
+	{
+		wr_array[i] = cos_fxp(theta);    
+		wi_array[i] = sin_fxp(theta);    
+		if(i >= (fft_len2 - 1))
+			theta = ONE_Q15;
+		else
+			theta = add(theta, step);
+	}
+
+	for(Word16 dir = 0; dir < 2; dir++)
+	{
+		for(Word16 h = 1, index_step = FFTLENGTH / 2; h < FFTLENGTH; h <<= 1, index_step >>= 1)
+		{
+			for(Word16 k = 0; k < h; k++)
+			{
+				Word16 wr = ONE_Q15, wi = 0;
+
+				if(k > 0)
+				{
+					wr = wr_array[k * index_step];
+					wi = dir ? negate(wi_array[k * index_step]) : wi_array[k * index_step];
+				}
+				t.tw_r[dir][h - 1 + k][0] = wr;
+				t.tw_r[dir][h - 1 + k][1] = negate(wi);
+				t.tw_i[dir][h - 1 + k][0] = wi;
+				t.tw_i[dir][h - 1 + k][1] = wr;
+			}
+		}
+	}
+
+	// same walk as the in-place reordering of the original Fortran port
+	j = 0;
+	for(i = 0; i < FFTLENGTH; i++)
+	{
+		if(j > i)
+		{
+			t.swap[t.num_swaps][0] = i;
+			t.swap[t.num_swaps][1] = j;
+			t.num_swaps++;
+		}
+		m = FFTLENGTH / 2;
+		while(m >= 1 && j >= m)
+		{
+			j -= m;
+			m >>= 1;
+		}
+		j += m;
+	}
+	return t;
+}
+
+const FftTables &fft_tables()
+{
+	static const FftTables t = make_fft_tables();
+	return t;
+}
+
+//-----------------------------------------------------------------------------
+// One radix-2 butterfly, pi/pj point to interleaved (re, im) pairs.
+//
+// The reference computes tempr = wr * dj.re - wi * dj.im exactly (both
+// products are below 2^30 since |w| <= 32767), then
+// round(L_sub(L_deposit_h(di.re) >> 1, tempr)) with saturation at both steps.
+// That equals saturate(((di.re << 14) + 0x4000 + (-tempr >> 1)) >> 15), which
+// stays within 32 bits, so the butterfly needs no 64 bit or saturating
+// 32 bit arithmetic and maps directly onto 16x16->32 multiply-adds.
+//-----------------------------------------------------------------------------
+inline void fft_bfly(Word16 *pi, Word16 *pj, const Word16 *tw_r, const Word16 *tw_i)
+{
+	const Word32 tr = (Word32)tw_r[0] * pj[0] + (Word32)tw_r[1] * pj[1];
+	const Word32 ti = (Word32)tw_i[0] * pj[0] + (Word32)tw_i[1] * pj[1];
+	const Word32 br = (Word32)pi[0] * 0x4000 + 0x4000;
+	const Word32 bi = (Word32)pi[1] * 0x4000 + 0x4000;
+
+	pj[0] = saturate((br + ((-tr) >> 1)) >> 15);
+	pi[0] = saturate((br + (tr >> 1)) >> 15);
+	pj[1] = saturate((bi + ((-ti) >> 1)) >> 15);
+	pi[1] = saturate((bi + (ti >> 1)) >> 15);
+}
+
+typedef void (*fft_stage_fn)(Word16 *data, Word16 h, const Word16 *tw_r, const Word16 *tw_i);
+
+void fft_stage_generic(Word16 *data, Word16 h, const Word16 *tw_r, const Word16 *tw_i)
+{
+	for(Word16 b = 0; b < FFTLENGTH; b += 2 * h)
+	{
+		for(Word16 k = 0; k < h; k++)
+			fft_bfly(&data[2 * (b + k)], &data[2 * (b + k + h)], &tw_r[2 * k], &tw_i[2 * k]);
+	}
+}
+
+#ifdef IMBE_FFT_X86
+__attribute__((target("sse2")))
+void fft_stage_sse2(Word16 *data, Word16 h, const Word16 *tw_r, const Word16 *tw_i)
+{
+	if(h < 4)
+	{
+		fft_stage_generic(data, h, tw_r, tw_i);
+		return;
+	}
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rnd = _mm_set1_epi32(0x4000);
+	for(Word16 b = 0; b < FFTLENGTH; b += 2 * h)
+	{
+		for(Word16 k = 0; k < h; k += 4)
+		{
+			Word16 *pi = &data[2 * (b + k)];
+			Word16 *pj = &data[2 * (b + k + h)];
+			const __m128i dj = _mm_loadu_si128((const __m128i *)pj);
+			const __m128i di = _mm_loadu_si128((const __m128i *)pi);
+			const __m128i tr = _mm_madd_epi16(dj, _mm_loadu_si128((const __m128i *)&tw_r[2 * k]));
+			const __m128i ti = _mm_madd_epi16(dj, _mm_loadu_si128((const __m128i *)&tw_i[2 * k]));
+			const __m128i br = _mm_add_epi32(_mm_slli_epi32(_mm_srai_epi32(_mm_slli_epi32(di, 16), 16), 14), rnd);
+			const __m128i bi = _mm_add_epi32(_mm_slli_epi32(_mm_srai_epi32(di, 16), 14), rnd);
+
+			const __m128i ir = _mm_srai_epi32(_mm_add_epi32(br, _mm_srai_epi32(tr, 1)), 15);
+			const __m128i ii = _mm_srai_epi32(_mm_add_epi32(bi, _mm_srai_epi32(ti, 1)), 15);
+			const __m128i jr = _mm_srai_epi32(_mm_add_epi32(br, _mm_srai_epi32(_mm_sub_epi32(zero, tr), 1)), 15);
+			const __m128i ji = _mm_srai_epi32(_mm_add_epi32(bi, _mm_srai_epi32(_mm_sub_epi32(zero, ti), 1)), 15);
+
+			const __m128i oi = _mm_packs_epi32(ir, ii);		// re0..re3 im0..im3
+			const __m128i oj = _mm_packs_epi32(jr, ji);
+			_mm_storeu_si128((__m128i *)pi, _mm_unpacklo_epi16(oi, _mm_unpackhi_epi64(oi, oi)));
+			_mm_storeu_si128((__m128i *)pj, _mm_unpacklo_epi16(oj, _mm_unpackhi_epi64(oj, oj)));
+		}
+	}
+}
+
+__attribute__((target("avx2")))
+void fft_stage_avx2(Word16 *data, Word16 h, const Word16 *tw_r, const Word16 *tw_i)
+{
+	if(h < 8)
+	{
+		fft_stage_sse2(data, h, tw_r, tw_i);
+		return;
+	}
+
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i rnd = _mm256_set1_epi32(0x4000);
+	for(Word16 b = 0; b < FFTLENGTH; b += 2 * h)
+	{
+		for(Word16 k = 0; k < h; k += 8)
+		{
+			Word16 *pi = &data[2 * (b + k)];
+			Word16 *pj = &data[2 * (b + k + h)];
+			const __m256i dj = _mm256_loadu_si256((const __m256i *)pj);
+			const __m256i di = _mm256_loadu_si256((const __m256i *)pi);
+			const __m256i tr = _mm256_madd_epi16(dj, _mm256_loadu_si256((const __m256i *)&tw_r[2 * k]));
+			const __m256i ti = _mm256_madd_epi16(dj, _mm256_loadu_si256((const __m256i *)&tw_i[2 * k]));
+			const __m256i br = _mm256_add_epi32(_mm256_slli_epi32(_mm256_srai_epi32(_mm256_slli_epi32(di, 16), 16), 14), rnd);
+			const __m256i bi = _mm256_add_epi32(_mm256_slli_epi32(_mm256_srai_epi32(di, 16), 14), rnd);
+
+			const __m256i ir = _mm256_srai_epi32(_mm256_add_epi32(br, _mm256_srai_epi32(tr, 1)), 15);
+			const __m256i ii = _mm256_srai_epi32(_mm256_add_epi32(bi, _mm256_srai_epi32(ti, 1)), 15);
+			const __m256i jr = _mm256_srai_epi32(_mm256_add_epi32(br, _mm256_srai_epi32(_mm256_sub_epi32(zero, tr), 1)), 15);
+			const __m256i ji = _mm256_srai_epi32(_mm256_add_epi32(bi, _mm256_srai_epi32(_mm256_sub_epi32(zero, ti), 1)), 15);
+
+			// per 128 bit lane, like the SSE2 version
+			const __m256i oi = _mm256_packs_epi32(ir, ii);
+			const __m256i oj = _mm256_packs_epi32(jr, ji);
+			_mm256_storeu_si256((__m256i *)pi, _mm256_unpacklo_epi16(oi, _mm256_unpackhi_epi64(oi, oi)));
+			_mm256_storeu_si256((__m256i *)pj, _mm256_unpacklo_epi16(oj, _mm256_unpackhi_epi64(oj, oj)));
+		}
+	}
+	_mm256_zeroupper();
+}
+#endif
+
+fft_stage_fn best_fft_stage()
+{
+#ifdef IMBE_FFT_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return fft_stage_avx2;
+	if (__builtin_cpu_supports("sse2"))
+		return fft_stage_sse2;
+#endif
+	return fft_stage_generic;
+}
+
+}
+
+
 //-----------------------------------------------------------------------------
 //	PURPOSE:
 //				Perform inverse DCT
@@ -35,8 +321,8 @@
 //
 //  INPUT:
 //              in     -  pointer to input data
-//              m_lim  -  input data's size
-//              i_lim  -  result's size
+//              m_lim  -  input data's size, 1...DCT_LEN_MAX
+//              i_lim  -  result's size, at most m_lim
 //              out    -  pointer to save result 
 //
 //	OUTPUT:
@@ -48,35 +334,17 @@
 //-----------------------------------------------------------------------------
 void imbe_vocoder_impl::idct(Word16 *in, Word16 m_lim, Word16 i_lim, Word16 *out)
 {
-	UWord16 angl_step, angl_intl, angl_intl_2;
-	UWord16 angl_acc;
+	const Word16 (*cos_tbl)[DCT_LEN_MAX] = dct_tables().idct_cos[m_lim];
 	Word32  sum;
 	Word16  i, m;
 
-	if(m_lim == 1)
-	{
-		angl_intl   = CNST_0_5_Q1_15;
-		angl_intl_2 = CNST_1_0_Q1_15;
-	}
-	else
-	{
-		angl_intl   = div_s ((Word16) CNST_0_5_Q5_11, m_lim << 11); // calculate 0.5/m_lim
-		angl_intl_2 = shl(angl_intl, 1);
-	}
-
-	angl_step = angl_intl;
 	for(i = 0; i < i_lim; i++)
 	{
 		sum = 0;
-		angl_acc = angl_step;
 		for(m = 1; m < m_lim; m++)
-		{
-			sum = L_add(sum, L_shr( L_mult(in[m], cos_fxp(angl_acc)), 7));
-			angl_acc += angl_step;			
-		}
+			sum = L_add(sum, L_shr( L_mult(in[m], cos_tbl[i][m]), 7));
 		sum = L_add(sum, L_shr( L_deposit_h(in[0]), 8));
 		out[i] = extract_l(L_shr_r (sum, 8)); 
-		angl_step += angl_intl_2; 
 	}
 }
 
@@ -87,8 +355,8 @@ void imbe_vocoder_impl::idct(Word16 *in, Word16 m_lim, Word16 i_lim, Word16 *out
 //
 //  INPUT:
 //              in     -  pointer to input data
-//              m_lim  -  input data's size
-//              i_lim  -  result's size
+//              m_lim  -  input data's size, 1...DCT_LEN_MAX
+//              i_lim  -  result's size, at most m_lim
 //              out    -  pointer to save result 
 //
 //	OUTPUT:
@@ -100,67 +368,25 @@ void imbe_vocoder_impl::idct(Word16 *in, Word16 m_lim, Word16 i_lim, Word16 *out
 //-----------------------------------------------------------------------------
 void imbe_vocoder_impl::dct(Word16 *in, Word16 m_lim, Word16 i_lim, Word16 *out)
 {
-	UWord16 angl_step, angl_intl, angl_intl_2, angl_begin;
-	UWord16 angl_acc;
+	const DctTables &t = dct_tables();
+	const Word16 (*cos_tbl)[DCT_LEN_MAX] = t.dct_cos[m_lim];
+	const Word16 scale = t.dct_scale[m_lim];
 	Word32  sum;
 	Word16  i, m;
 
-	if(m_lim == 1)
-	{
-		angl_intl   = CNST_0_5_Q1_15;
-		angl_intl_2 = CNST_1_0_Q1_15;
-	}
-	else
-	{
-		angl_intl   = div_s ((Word16) CNST_0_5_Q5_11, m_lim << 11); // calculate 0.5/m_lim
-		angl_intl_2 = shl(angl_intl, 1);
-	}
-
 	// Calculate first coefficient
 	sum = 0;
 	for(m = 0; m < m_lim; m++)
 		sum = L_add(sum, L_deposit_l(in[m]));
-	out[0] = extract_l(L_mpy_ls(sum, angl_intl_2));
+	out[0] = extract_l(L_mpy_ls(sum, scale));
 
 	// Calculate the others coefficients
-	angl_begin = angl_intl;
-	angl_step  = angl_intl_2;
 	for(i = 1; i < i_lim; i++)
 	{
 		sum = 0;
-		angl_acc = angl_begin;
 		for(m = 0; m < m_lim; m++)
-		{
-			sum = L_add(sum, L_deposit_l(mult(in[m], cos_fxp(angl_acc))));
-			angl_acc += angl_step;			
-		}
-		out[i] = extract_l(L_mpy_ls(sum, angl_intl_2));
-
-		angl_step  += angl_intl_2;  
-		angl_begin += angl_intl;
-	}
-}
-
-
-
-
-void imbe_vocoder_impl::fft_init(void)
-{
-	Word16 i, fft_len2, shift, step, theta;
-
-	fft_len2 = shr(FFTLENGTH, 1);
-	shift    = norm_s(fft_len2);
-	step     = shl(2, shift);
-	theta    = 0;
-
-	for(i = 0; i <= fft_len2; i++) 
-	{
-		wr_array[i] = cos_fxp(theta);    
-		wi_array[i] = sin_fxp(theta);    
-		if(i >= (fft_len2 - 1))
-			theta = ONE_Q15;
-		else
-			theta = add(theta, step);
+			sum = L_add(sum, L_deposit_l(mult(in[m], cos_tbl[i][m])));
+		out[i] = extract_l(L_mpy_ls(sum, scale));
 	}
 }
 
@@ -170,15 +396,11 @@ void imbe_vocoder_impl::fft_init(void)
 // * Replaces data by its DFT, if isign is 1, or replaces data   *
 // * by inverse DFT times nn if isign is -1.  data is a complex  *
 // * array of length nn, input as a real array of length 2*nn.   *
-// * nn MUST be an integer power of two.  This is not checked    *
+// * nn must be FFTLENGTH, the only size the vocoder uses.       *
 // * The real part of the number should be in the zeroeth        *
 // * of data , and the imaginary part should be in the next      *
 // * element.  Hence all the real parts should have even indeces *
 // * and the imaginary parts, odd indeces.			             *
-// *                                                             * 
-// * Data is passed in an array starting in position 0, but the  *
-// * code is copied from Fortran so uses an internal pointer     *
-// * which accesses position 0 as position 1, etc.		         *
 // *                                                             *
 // * This code uses e+jwt sign convention, so isign should be    *
 // * reversed for e-jwt.                                         *
@@ -187,92 +409,31 @@ void imbe_vocoder_impl::fft_init(void)
 // Q values:
 // datam1 - Q14
 // isign  - Q15 
-
-#define	SWAP(a,b) temp1 = (a);(a) = (b); (b) = temp1
+//
+// Radix-2 decimation in time with the twiddles of every stage precomputed.
+// Each stage rounds and scales exactly like the original scalar loops, the
+// butterflies of a stage are independent so they are run block by block,
+// several at a time with SSE2/AVX2 where the CPU has them.
 
 void imbe_vocoder_impl::fft(Word16 *datam1, Word16 nn, Word16 isign)
 {
-	Word16 n, mmax, m, j, istep, i;
-	Word16 wr, wi, temp1;
-	Word32 L_tempr, L_tempi;
-	Word16 *data;
-	Word32 L_temp1, L_temp2;
-	Word16 index, index_step;
-
-	//  Use pointer indexed from 1 instead of 0	
-	data = &datam1[-1];
-
-	n = shl(nn,1);
-	j = 1;
-	for( i = 1; i < n; i+=2 ) 
-	{
-		if ( j > i) 
-		{
-			SWAP(data[j],data[i]);    
-			SWAP(data[j+1],data[i+1]);   
-		}
-		m = nn;
-		while ( m >= 2 && j > m ) 
-		{
-			j = sub(j,m);
-			m = shr(m,1);
-		}
-		j = add(j,m);
-	}
-	mmax = 2;
-
-	// initialize index step 
-	index_step = nn;
+	static const fft_stage_fn stage = best_fft_stage();
+	const FftTables &t = fft_tables();
+	const Word16 dir = (isign < 0) ? 1 : 0;
+	Word16 i, h;
 
-	while ( n > mmax) 
+	(void)nn;
+	for(i = 0; i < t.num_swaps; i++)
 	{
-		istep = shl(mmax,1);  // istep = 2 * mmax 
-
-		index = 0;
-		index_step = shr(index_step,1);
-
-		wr = ONE_Q15;
-		wi = 0;
-		for ( m = 1; m < mmax; m+=2) 
-		{
-			for ( i = m; i <= n; i += istep) 
-			{
-				j = i + mmax;
-
-				// tempr = wr * data[j] - wi * data[j+1] 
-				L_temp1 = L_shr(L_mult(wr,data[j]),1);
-				L_temp2 = L_shr(L_mult(wi,data[j+1]),1);
-				L_tempr = L_sub(L_temp1,L_temp2);
-
-				// tempi = wr * data[j+1] + wi * data[j] 
-				L_temp1 = L_shr(L_mult(wr,data[j+1]),1);
-				L_temp2 = L_shr(L_mult(wi,data[j]),1);
-				L_tempi = L_add(L_temp1,L_temp2);
-
-
-				// data[j] = data[i] - tempr 
-				L_temp1 = L_shr(L_deposit_h(data[i]),1);
-				data[j] = round(L_sub(L_temp1,L_tempr));
-
-				// data[i] += tempr 
-				data[i] = round(L_add(L_temp1,L_tempr));
-
-				// data[j+1] = data[i+1] - tempi 
-				L_temp1 = L_shr(L_deposit_h(data[i+1]),1);
-				data[j+1] = round(L_sub(L_temp1,L_tempi));
-
-				// data[i+1] += tempi 
-				data[i+1] = round(L_add(L_temp1,L_tempi));
-			}
-			index = add(index,index_step);
-			wr = wr_array[index];
-			if (isign < 0)
-				wi = negate(wi_array[index]);
-			else
-				wi = wi_array[index];
-		}
-		mmax = istep;
+		Word16 *a = &datam1[2 * t.swap[i][0]];
+		Word16 *b = &datam1[2 * t.swap[i][1]];
+		const Word16 re = a[0], im = a[1];
+		a[0] = b[0];
+		a[1] = b[1];
+		b[0] = re;
+		b[1] = im;
 	}
-} 
-
 
+	for(h = 1; h < FFTLENGTH; h <<= 1)
+		stage(datam1, h, t.tw_r[dir][h - 1], t.tw_i[dir][h - 1]);
+}
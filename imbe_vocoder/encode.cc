@@ -47,7 +47,6 @@ void imbe_vocoder_impl::encode_init(void)
 	v_zap(pitch_ref_buf, PITCH_EST_BUF_SIZE);
 	v_zap(pe_lpf_mem, PE_LPF_ORD);
 	pitch_est_init();
-	fft_init();
 	dc_rmv_mem = 0;
 	sa_encode_init();
 	pitch_ref_init();
@@ -58,6 +57,7 @@ void imbe_vocoder_impl::encode(IMBE_PARAM *imbe_param, Word16 *frame_vector, Wor
 {
 	Word16 i;
 	Word16 *wr_ptr, *sig_ptr;
+	Cmplx16 fft_buf[FFTLENGTH];
 	
 	for(i = 0; i < PITCH_EST_BUF_SIZE - FRAME; i++)
 	{
@@ -35,3 +35,8 @@ const IMBE_PARAM* imbe_vocoder::param(void)
 {
 	return Impl->param();
 }
+
+void imbe_vocoder::reset(void)
+{
+	Impl->reset();
+}
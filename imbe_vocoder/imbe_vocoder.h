@@ -25,6 +25,9 @@ public:
     void encode_4400(int16_t *snd, uint8_t *imbe);
 	void decode_4400(int16_t *snd, uint8_t *imbe);
     const IMBE_PARAM* param(void);
+    // reset returns the encoder and decoder state to that of a newly
+    // constructed vocoder; the shared tables are not rebuilt
+    void reset(void);
 
 private:
     imbe_vocoder_impl *Impl;
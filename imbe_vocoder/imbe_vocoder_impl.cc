@@ -8,25 +8,25 @@
 
 #include "imbe_vocoder_impl.h"
 
-imbe_vocoder_impl::imbe_vocoder_impl (void) :
-	prev_pitch(0),
-	prev_prev_pitch(0),
-	prev_e_p(0),
-	prev_prev_e_p(0),
-	seed(1),
-	num_harms_prev1(0),
-	num_harms_prev2(0),
-	num_harms_prev3(0),
-	fund_freq_prev(0),
-	th_max(0),
-	dc_rmv_mem(0)
+imbe_vocoder_impl::imbe_vocoder_impl (void)
 {
-	memset(wr_array, 0, sizeof(wr_array));
-	memset(wi_array, 0, sizeof(wi_array));
+	reset();
+}
+
+void imbe_vocoder_impl::reset(void)
+{
+	prev_pitch = prev_prev_pitch = 0;
+	prev_e_p = prev_prev_e_p = 0;
+	e_p_ahead_cnt = 0;
+	seed = 1;
+	num_harms_prev1 = num_harms_prev2 = num_harms_prev3 = 0;
+	fund_freq_prev = 0;
+	th_max = 0;
+	dc_rmv_mem = 0;
+
 	memset(pitch_est_buf, 0, sizeof(pitch_est_buf));
 	memset(pitch_ref_buf, 0, sizeof(pitch_ref_buf));
 	memset(pe_lpf_mem, 0, sizeof(pe_lpf_mem));
-	memset(fft_buf, 0, sizeof(fft_buf));
 	memset(sa_prev1, 0, sizeof(sa_prev1));
 	memset(sa_prev2, 0, sizeof(sa_prev2));
 	memset(uv_mem, 0, sizeof(uv_mem));
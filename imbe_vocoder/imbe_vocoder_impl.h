@@ -35,11 +35,18 @@ public:
 	void encode_4400(int16_t *snd, uint8_t *imbe);
 	void decode_4400(int16_t *snd, uint8_t *imbe);
 	const IMBE_PARAM* param(void) {return &my_imbe_param;}
+	// reset puts the encoder and decoder back to their initial state,
+	// as after construction
+	void reset(void);
 private:
 	IMBE_PARAM my_imbe_param;
 
-	/* data items originally static (moved from individual c++ sources) */
+	/* data items originally static (moved from individual c++ sources).
+	 * Only per-stream state lives here, the constant tables (tbls.cc and
+	 * the FFT/DCT tables in dsp_sub.cc) are shared by all instances and
+	 * scratch buffers are kept on the stack. */
 	Word16 prev_pitch, prev_prev_pitch, prev_e_p, prev_prev_e_p;
+	Word16 e_p_ahead[2][203], e_p_ahead_cnt;	// E(p) of the look-ahead frames, reused by the next frames
 	UWord32 seed ;
 	Word16 num_harms_prev1;
 	Word32 sa_prev1[NUM_HARMS_MAX + 2];
@@ -53,18 +60,14 @@ private:
 	Word16 sa_prev3[NUM_HARMS_MAX];
 	Word32 th_max;
 	Word16 v_uv_dsn[NUM_BANDS_MAX];
-	Word16 wr_array[FFTLENGTH / 2 + 1];
-	Word16 wi_array[FFTLENGTH / 2 + 1];
 	Word16 pitch_est_buf[PITCH_EST_BUF_SIZE];
 	Word16 pitch_ref_buf[PITCH_EST_BUF_SIZE];
 	Word32 dc_rmv_mem;
-	Cmplx16 fft_buf[FFTLENGTH];
 	Word16 pe_lpf_mem[PE_LPF_ORD];
 
 	/* member functions */
 	void idct(Word16 *in, Word16 m_lim, Word16 i_lim, Word16 *out);
 	void dct(Word16 *in, Word16 m_lim, Word16 i_lim, Word16 *out);
-	void fft_init(void);
 	void fft(Word16 *datam1, Word16 nn, Word16 isign);
 	void encode(IMBE_PARAM *imbe_param, Word16 *frame_vector, Word16 *snd);
 	void parse(int argc, char **argv);
@@ -87,6 +90,7 @@ private:
 	void decode_init(IMBE_PARAM *imbe_param);
 	void decode(IMBE_PARAM *imbe_param, Word16 *frame_vector, Word16 *snd);
 	void encode_init(void);
+	Word16 rand_gen(void);
 };
 
 #endif /* INCLUDED_IMBE_VOCODER_IMPL_H */
@@ -84,38 +84,6 @@ Word16 Pow2(Word32 x)
 	return extract_h(L_x);
 }
 
-//-----------------------------------------------------------------------------
-//	PURPOSE:
-//				Multiply a 32 bit number (L_var2) and a 16 bit
-//              number (var1) returning a 32 bit result. L_var2
-//              is truncated to 31 bits prior to executing the
-//              multiply.     
-//
-//  INPUT:
-//              L_var2 -   A Word32 input variable
-//              var1   -   A Word16 input variable
-//
-//	OUTPUT:
-//		None
-//
-//	RETURN:
-//		        A Word32 value
-//
-//-----------------------------------------------------------------------------
-Word32 L_mpy_ls(Word32 L_var2, Word16 var1)
-{
-	Word32 L_varOut;
-	Word16 swtemp;
-
-	swtemp = shr(extract_l(L_var2), 1);
-	swtemp = (Word16)32767 & (Word16) swtemp;
-
-	L_varOut = L_mult(var1, swtemp);
-	L_varOut = L_shr(L_varOut, 15);
-	L_varOut = L_mac(L_varOut, var1, extract_h(L_var2));
-	return (L_varOut);
-}
-
 //-----------------------------------------------------------------------------
 // Table for routine cos_fxp()
 //-----------------------------------------------------------------------------
@@ -76,7 +76,19 @@ Word16 sin_fxp(Word16 x);
 //		        A Word32 value
 //
 //-----------------------------------------------------------------------------
-Word32 L_mpy_ls(Word32 L_var2, Word16 var1);
+static inline Word32 L_mpy_ls(Word32 L_var2, Word16 var1)
+{
+	Word32 L_varOut;
+	Word16 swtemp;
+
+	swtemp = shr(extract_l(L_var2), 1);
+	swtemp = (Word16)32767 & (Word16) swtemp;
+
+	L_varOut = L_mult(var1, swtemp);
+	L_varOut = L_shr(L_varOut, 15);
+	L_varOut = L_mac(L_varOut, var1, extract_h(L_var2));
+	return (L_varOut);
+}
 
 //-----------------------------------------------------------------------------
 //	PURPOSE:
@@ -35,6 +35,9 @@ static const Word16 lpf_coef[PE_LPF_ORD] =
 	9141, 3891, -495, -1834, -883,  288,   543,  185,  -92,  -94
 };
 
+#define LPF_COEF_ABS_SUM  46404   // sum(|lpf_coef[i]|)
+#define LPF_BLK           FRAME   // Samples filtered per block
+
 
 //-----------------------------------------------------------------------------
 //	PURPOSE:
@@ -56,19 +59,42 @@ static const Word16 lpf_coef[PE_LPF_ORD] =
 //-----------------------------------------------------------------------------
 void pe_lpf(Word16 *sigin, Word16 *sigout, Word16 *mem, Word16 len)
 {
-	Word16 i;
+	Word16 buf[PE_LPF_ORD - 1 + LPF_BLK];
+	Word16 i, k, n, max_abs;
 	Word32 L_sum;
 
-	while(len--)
+	// The filter memory holds the last PE_LPF_ORD inputs, so with the older
+	// PE_LPF_ORD - 1 of them in front of the block every output is a
+	// correlation of a window of buf with lpf_coef
+	while(len > 0)
 	{
-		for(i = 0; i < PE_LPF_ORD - 1; i++)
-			mem[i] = mem[i + 1];
-		mem[PE_LPF_ORD - 1] = *sigin++;
+		n = (len < LPF_BLK) ? len : LPF_BLK;
+		v_equ(buf, &mem[1], PE_LPF_ORD - 1);
+		v_equ(&buf[PE_LPF_ORD - 1], sigin, n);
+
+		max_abs = 0;
+		for(i = 0; i < PE_LPF_ORD - 1 + n; i++)
+			if(abs_s(buf[i]) > max_abs)
+				max_abs = abs_s(buf[i]);
 
-		L_sum = 0;
-		for(i = 0; i < PE_LPF_ORD; i++)
-			L_sum = L_mac(L_sum, mem[i], lpf_coef[i]);
+		// No L_mac() or round() can saturate unless the block is close to
+		// full scale, otherwise take the plain sums
+		if(2 * (long long)max_abs * LPF_COEF_ABS_SUM + 0x8000 <= MAX_32)
+			v_corr_r(sigout, buf, lpf_coef, PE_LPF_ORD, n);
+		else
+		{
+			for(i = 0; i < n; i++)
+			{
+				L_sum = 0;
+				for(k = 0; k < PE_LPF_ORD; k++)
+					L_sum = L_mac(L_sum, buf[i + k], lpf_coef[k]);
+				sigout[i] = round(L_sum);
+			}
+		}
 
-		*sigout++ = round(L_sum);
+		v_equ(mem, &buf[n - 1], PE_LPF_ORD);
+		sigin  += n;
+		sigout += n;
+		len    -= n;
 	}
 }
@@ -67,6 +67,7 @@ void imbe_vocoder_impl::pitch_est_init(void)
 {
 	prev_pitch = prev_prev_pitch = 158; // 100
 	prev_e_p = prev_prev_e_p = 0;
+	e_p_ahead_cnt = 0;
 }
 
 
@@ -90,39 +91,68 @@ void imbe_vocoder_impl::e_p(Word16 *sigin, Word16 *res_buf)
 	Word16 i, j, den_part_acc, tmp;
 	Word32 L_sum, L_num, L_den, L_e0, L_tmp;
 	Word16 sig_wndwed[PITCH_EST_FRAME];
-	Word32 corr[259];
+	Word32 corr[259], corr_int[150 - 21 + 1];
 	Word16 index_beg, index_step;
 	Word16 scale_shift;
+	long long energy;
+	Word16 min_sample;
 
 
 	// Windowing input signal s * wi^2
 	for(i = 0 ; i < PITCH_EST_FRAME; i++)
 		sig_wndwed[i] = mult_r(sigin[i], wi[i]);                                
 
-	L_sum = 0;
+	// The terms of sum(s^2 * wi^2) are never negative, so the saturating sum
+	// is just the exact sum clipped to MAX_32
+	energy = 0;
 	for(i = 0 ; i < PITCH_EST_FRAME; i++)
-		L_sum = L_add(L_sum, L_mpy_ls( L_mult(sigin[i], sigin[i]), wi[i]) );     // sum(s^2 * wi^2)
+		energy += L_mpy_ls( L_mult(sigin[i], sigin[i]), wi[i]);                 // sum(s^2 * wi^2)
+	L_sum = (energy > MAX_32) ? MAX_32 : (Word32)energy;
 
 	// Check for the overflow
 	if(L_sum == MAX_32)
 	{
 		// Recalculate with scaling
-		L_sum = 0;
+		energy = 0;
 		for(i = 0 ; i < PITCH_EST_FRAME; i++)
-			L_sum = L_add(L_sum, L_mpy_ls( L_shr(L_mult(sigin[i], sigin[i]), 5), wi[i]));    
+			energy += L_mpy_ls( L_shr(L_mult(sigin[i], sigin[i]), 5), wi[i]);
+		L_sum = (energy > MAX_32) ? MAX_32 : (Word32)energy;
 		scale_shift = 5;
 	}
 	else
 		scale_shift = 0;
-	
-	L_e0 = 0;
+
+	// Every correlation term satisfies |2ab| <= a^2 + b^2, so no correlation
+	// adds up more than 2 * sum(s^2 * wi^4) >> scale_shift in magnitude, plus
+	// one per term for the rounding of negative terms. If that fits in
+	// 32 bits the saturating sums below never clip and the vector kernel
+	// gives the same result.
+	energy = 0;
+	min_sample = 0;
 	for(i = 0 ; i < PITCH_EST_FRAME; i++)
-		L_e0 = L_add(L_e0, L_shr( L_mult(sig_wndwed[i], sig_wndwed[i]), scale_shift));              // sum(s^2 * wi^4) 
+	{
+		energy += (Word32)sig_wndwed[i] * sig_wndwed[i];
+		if(sig_wndwed[i] < min_sample)
+			min_sample = sig_wndwed[i];
+	}
 
     // Calculate correlation for time shift in range 21...150 with step 0.5
 	// For integer shifts
-	for(tmp = 21, i = 0; tmp <= 150; tmp++, i += 2)
-		corr[i] = autocorr(sig_wndwed, tmp, scale_shift);
+	if(min_sample != MIN_16 && ((2 * energy) >> scale_shift) + PITCH_EST_FRAME < MAX_32)
+	{
+		L_e0 = L_v_dot_shr(sig_wndwed, sig_wndwed, scale_shift, PITCH_EST_FRAME);      // sum(s^2 * wi^4)
+		L_v_xcorr_shr(corr_int, sig_wndwed, 21, 150, scale_shift, PITCH_EST_FRAME);
+		for(tmp = 0, i = 0; tmp <= 150 - 21; tmp++, i += 2)
+			corr[i] = corr_int[tmp];
+	}
+	else
+	{
+		L_e0 = 0;
+		for(i = 0 ; i < PITCH_EST_FRAME; i++)
+			L_e0 = L_add(L_e0, L_shr( L_mult(sig_wndwed[i], sig_wndwed[i]), scale_shift));  // sum(s^2 * wi^4)
+		for(tmp = 21, i = 0; tmp <= 150; tmp++, i += 2)
+			corr[i] = autocorr(sig_wndwed, tmp, scale_shift);
+	}
 	// For intermediate shifts
 	for(i = 1; i < 258; i += 2)
 		corr[i] = L_shr( L_add(corr[i - 1], corr[i + 1]), 1);
@@ -193,10 +223,15 @@ void imbe_vocoder_impl::pitch_est(IMBE_PARAM *imbe_param, Word16 *frames_buf)
 	UWord32 UL_tmp;
 	Word16 e_p_cur, pb, pf, ceb, s_tmp;
     Word16 cef_est, cef, p0_est, p0, p1, p2, p1_max_index, p2_max_index, e1p1_e2p2_est;
-        Word16 e_p_arr2_min[203];
+        Word16 e_p_arr2_min[203], e1p1_e2p2_arr[203];
 
-	// Calculate E(p) function for current and two future frames
-	e_p(&frames_buf[0], e_p_arr0);
+	// Calculate E(p) function for current and two future frames. The buffer
+	// moves on by FRAME samples per call, so the look-ahead E(p) of the
+	// previous frames already covers the current and the next frame.
+	if(e_p_ahead_cnt > 0)
+		v_equ(e_p_arr0, e_p_ahead[0], 203);
+	else
+		e_p(&frames_buf[0], e_p_arr0);
 
 	// Look-Back Pitch Tracking
 	min_index = HI_BYTE(min_max_tbl[prev_pitch]);
@@ -222,30 +257,41 @@ void imbe_vocoder_impl::pitch_est(IMBE_PARAM *imbe_param, Word16 *frames_buf)
 
 		imbe_param->pitch = pb + 42;  // Result in Q15.1 format
 		imbe_param->e_p = prev_e_p;
+
+		if(e_p_ahead_cnt == 2)
+		{
+			v_equ(e_p_ahead[0], e_p_ahead[1], 203);
+			e_p_ahead_cnt = 1;
+		}
+		else
+			e_p_ahead_cnt = 0;
 		return;
 	}
 
 
 	// Look-Ahead Pitch Tracking
-	e_p(&frames_buf[FRAME],     e_p_arr1);
+	if(e_p_ahead_cnt == 2)
+		v_equ(e_p_arr1, e_p_ahead[1], 203);
+	else
+		e_p(&frames_buf[FRAME], e_p_arr1);
 	e_p(&frames_buf[2 * FRAME], e_p_arr2);
 
+	v_equ(e_p_ahead[0], e_p_arr1, 203);
+	v_equ(e_p_ahead[1], e_p_arr2, 203);
+	e_p_ahead_cnt = 2;
+
 	p0_est = p0 = 0;
 	cef_est = e_p_arr0[p0] + e_p_arr1[p0] + e_p_arr2[p0];
 
+            // E(p) is in 0...1.0 Q4.12, the sums never saturate
             p1 = 0;
             while(p1 < 203)
             {
                         p2 = HI_BYTE(min_max_tbl[p1]);
                         p2_max_index = LO_BYTE(min_max_tbl[p1]);
-                        s_tmp = e_p_arr2[p1];
-                        while(p2 <= p2_max_index)
-                        {
-                                   if(e_p_arr2[p2] < s_tmp)
-                                               s_tmp = e_p_arr2[p2];                                                          
-                                   p2++;
-                        }
-                        e_p_arr2_min[p1] = s_tmp;
+                        s_tmp = v_min(&e_p_arr2[p2], p2_max_index - p2 + 1);
+                        e_p_arr2_min[p1] = (e_p_arr2[p1] < s_tmp) ? e_p_arr2[p1] : s_tmp;
+                        e1p1_e2p2_arr[p1] = add(e_p_arr1[p1], e_p_arr2_min[p1]);
                         p1++;
             }
             while(p0 < 203)
@@ -253,12 +299,9 @@ void imbe_vocoder_impl::pitch_est(IMBE_PARAM *imbe_param, Word16 *frames_buf)
                         e1p1_e2p2_est = e_p_arr1[p0] + e_p_arr2_min[p0];
                         p1 = HI_BYTE(min_max_tbl[p0]);
                         p1_max_index = LO_BYTE(min_max_tbl[p0]);
-                        while(p1 <= p1_max_index)
-                        {                     
-                                   if(add(e_p_arr1[p1], e_p_arr2_min[p1]) < e1p1_e2p2_est)                          
-                                               e1p1_e2p2_est = add(e_p_arr1[p1], e_p_arr2_min[p1]);                                                                 
-                                   p1++;
-                        }
+                        s_tmp = v_min(&e1p1_e2p2_arr[p1], p1_max_index - p1 + 1);
+                        if(s_tmp < e1p1_e2p2_est)
+                                   e1p1_e2p2_est = s_tmp;
                         e1p1_e2p2_est_save[p0] = e1p1_e2p2_est;
                         cef = add(e_p_arr0[p0], e1p1_e2p2_est);
                         if(cef < cef_est)
@@ -46,7 +46,8 @@ void pitch_ref(IMBE_PARAM *imbe_param, Cmplx16 *fft_buf)
 	Word16 i, j, index_a_save, pitch_est, tmp, shift, index_wr, up_lim;
 	Cmplx16 sp_rec[FFTLENGTH/2];
 	Word32 fund_freq, fund_freq_2, fund_freq_acc_a, fund_freq_acc_b, fund_freq_acc, L_tmp, amp_re_acc, amp_im_acc, L_sum, L_diff_min;
-	Word16 ha, hb, index_a, index_b, index_tbl[20], it_ind, re_tmp, im_tmp, pitch_cand=0;
+	Word16 ha, hb, index_a, index_b, index_tbl[20], it_ind, k, pitch_cand=0;
+	Word16 err_buf[FFTLENGTH];
 	Word32 fund_freq_cand=0;
 
 	
@@ -133,14 +134,14 @@ void pitch_ref(IMBE_PARAM *imbe_param, Cmplx16 *fft_buf)
 			fund_freq_acc   = L_add(fund_freq_acc,   fund_freq);
 		}
 
-		L_sum = 0;
-		for(j = MIN_INDEX; j <= up_lim; j++)
+		// Squared error of the reconstruction, L_v_magsq() gives the same
+		// saturated sum since all the terms are positive
+		for(j = MIN_INDEX, k = 0; j <= up_lim; j++)
 		{
-			re_tmp = sub(fft_buf[j].re, sp_rec[j].re);
-			im_tmp = sub(fft_buf[j].im, sp_rec[j].im);
-			L_sum = L_mac(L_sum, re_tmp, re_tmp);
-			L_sum = L_mac(L_sum, im_tmp, im_tmp);
+			err_buf[k++] = sub(fft_buf[j].re, sp_rec[j].re);
+			err_buf[k++] = sub(fft_buf[j].im, sp_rec[j].im);
 		}
+		L_sum = L_v_magsq(err_buf, k);
 
 		if(L_sum < L_diff_min)
 		{
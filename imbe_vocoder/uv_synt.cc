@@ -26,7 +26,6 @@
 #include "dsp_sub.h"
 #include "math_sub.h"
 #include "uv_synt.h"
-#include "rand_gen.h"
 #include "tbls.h"
 #include "encode.h"
 #include "imbe_vocoder_impl.h"
@@ -36,7 +35,6 @@
 
 void imbe_vocoder_impl::uv_synt_init(void)
 {
-	fft_init();
 	v_zap(uv_mem, 105);
 }
 
@@ -27,7 +27,6 @@
 #include "dsp_sub.h"
 #include "math_sub.h"
 #include "v_synt.h"
-#include "rand_gen.h"
 #include "tbls.h"
 #include "encode.h"
 #include "imbe_vocoder_impl.h"
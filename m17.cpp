@@ -579,21 +579,21 @@ void M17::process_modem_data(QByteArray d)
 		::memcpy(netframe + M17_LSF_LENGTH_BYTES - M17_CRC_LENGTH_BYTES, frame, M17_FN_LENGTH_BYTES + M17_PAYLOAD_LENGTH_BYTES);
 		netframe[M17_LSF_LENGTH_BYTES - M17_CRC_LENGTH_BYTES + 0U] &= 0x7FU;
 
-		uint32_t lich1, lich2, lich3, lich4;
-		bool valid1 = CGolay24128::decode24128(p + M17_SYNC_LENGTH_BYTES + 0U, lich1);
-		bool valid2 = CGolay24128::decode24128(p + M17_SYNC_LENGTH_BYTES + 3U, lich2);
-		bool valid3 = CGolay24128::decode24128(p + M17_SYNC_LENGTH_BYTES + 6U, lich3);
-		bool valid4 = CGolay24128::decode24128(p + M17_SYNC_LENGTH_BYTES + 9U, lich4);
+		const uint8_t* f = p + M17_SYNC_LENGTH_BYTES;
+		uint32_t fec[4U], frags[4U];
+		uint8_t errs[4U];
+		for (uint32_t i = 0U; i < 4U; i++)
+			fec[i] = (f[i * 3U] << 16) | (f[(i * 3U) + 1U] << 8) | (f[(i * 3U) + 2U] << 0);
 
-		if (valid1 && valid2 && valid3 && valid4) {
+		if (CGolay24128::decode24128(fec, frags, 4U, errs) == 0U) {
 			uint8_t lich[M17_LICH_FRAGMENT_LENGTH_BYTES];
-			combineFragmentLICH(lich1, lich2, lich3, lich4, lich);
+			combineFragmentLICH(frags[0U], frags[1U], frags[2U], frags[3U], lich);
 
-			uint32_t n = (lich4 >> 5) & 0x07U;
+			uint32_t n = (frags[3U] >> 5) & 0x07U;
 			::memcpy(lsfchunks + (n * M17_LSF_FRAGMENT_LENGTH_BYTES), lich, M17_LSF_FRAGMENT_LENGTH_BYTES);
 
 			bool valid = checkCRC16(lsfchunks, M17_LSF_LENGTH_BYTES);
-			qDebug() << "lich valid == " << valid << " lich n == " << n;
+			qDebug() << "lich valid == " << valid << " lich n == " << n << " lich errs == " << (errs[0U] + errs[1U] + errs[2U] + errs[3U]);
 			if (valid) {
 				::memcpy(lsf, lsfchunks, M17_LSF_LENGTH_BYTES);
 				::memset(lsfchunks, 0, M17_LSF_LENGTH_BYTES);
@@ -0,0 +1,323 @@
+/*
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+ * OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <cstring>
+
+#include "ambe_framing.h"
+#include "vocoder_tables.h"
+
+namespace {
+
+// D-Star 2400x1200 frame bit (LSB first per byte) -> ambe_fr[dW][dX]
+constexpr int dW[72] = {0,0,3,2,1,1,0,0,1,1,0,0,3,2,1,1,3,2,1,1,0,0,3,2,0,0,3,2,1,1,0,0,1,1,0,0,
+                                3,2,1,1,3,2,1,1,0,0,3,2,0,0,3,2,1,1,0,0,1,1,0,0,3,2,1,1,3,3,2,1,0,0,3,3,};
+
+constexpr int dX[72] = {10,22,11,9,10,22,11,23,8,20,9,21,10,8,9,21,8,6,7,19,8,20,9,7,6,18,7,5,6,18,7,19,4,16,5,17,6,
+                                4,5,17,4,2,3,15,4,16,5,3,2,14,3,1,2,14,3,15,0,12,1,13,2,0,1,13,0,12,10,11,0,12,1,13,};
+
+// DMR 2450x1150 frame bit pairs (MSB first per byte) -> ambe_fr[rW][rX], ambe_fr[rY][rZ]
+constexpr int rW[36] = {
+  0, 1, 0, 1, 0, 1,
+  0, 1, 0, 1, 0, 1,
+  0, 1, 0, 1, 0, 1,
+  0, 1, 0, 1, 0, 2,
+  0, 2, 0, 2, 0, 2,
+  0, 2, 0, 2, 0, 2
+};
+
+constexpr int rX[36] = {
+  23, 10, 22, 9, 21, 8,
+  20, 7, 19, 6, 18, 5,
+  17, 4, 16, 3, 15, 2,
+  14, 1, 13, 0, 12, 10,
+  11, 9, 10, 8, 9, 7,
+  8, 6, 7, 5, 6, 4
+};
+
+// bit 0
+constexpr int rY[36] = {
+  0, 2, 0, 2, 0, 2,
+  0, 2, 0, 3, 0, 3,
+  1, 3, 1, 3, 1, 3,
+  1, 3, 1, 3, 1, 3,
+  1, 3, 1, 3, 1, 3,
+  1, 3, 1, 3, 1, 3
+};
+
+constexpr int rZ[36] = {
+  5, 3, 4, 2, 3, 1,
+  2, 0, 1, 13, 0, 12,
+  22, 11, 21, 10, 20, 9,
+  19, 8, 18, 7, 17, 6,
+  16, 5, 15, 4, 14, 3,
+  13, 2, 12, 1, 11, 0
+};
+
+// D-Star: quantizer bits -> Golay input order, and Golay output -> frame order
+constexpr int m_list[] = {0, 1, 2, 3, 4, 5, 11, 12, 13, 14, 17, 18, 19, 20, 21, 22, 23, 26, 27, 28, 29, 30, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 7, 8, 9, 10, 15, 16, 24, 25, 31, 32, 6};
+constexpr int d_list[] = {7, 1, 11, 21, 31, 25, 35, 45, 55, 49, 59, 69, 6, 0, 10, 20, 30, 24, 34, 44, 54, 48, 58, 68, 5, 15, 9, 19, 29, 39, 33, 43, 53, 63, 57, 67, 4, 14, 8, 18, 28, 38, 32, 42, 52, 62, 56, 66, 3, 13, 23, 17, 27, 37, 47, 41, 51, 61, 71, 65, 2, 12, 22, 16, 26, 36, 46, 40, 50, 60, 70, 64};
+constexpr int dstar_b_lengths[] = {7,4,6,9,7,4,4,4,3};
+
+// YSF 2450: field and bit of b[] carried by each of the 49 frame bits
+constexpr int b_lengths[] = {7,5,5,9,7,5,4,4,3};
+constexpr int y_field[49] = {0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3,3,3,3,3, 4,4,4,4, 5,5,5,5, 6,6,6, 7,7,7, 8,
+                             1, 2, 0,0,0, 3, 4,4,4, 5, 6, 7, 8,8};
+constexpr int y_bit[49]   = {6,5,4,3, 4,3,2,1, 4,3,2,1, 8,7,6,5,4,3,2,1, 6,5,4,3, 4,3,2,1, 3,2,1, 3,2,1, 2,
+                             0, 0, 2,1,0, 0, 2,1,0, 0, 0, 0, 1,0};
+
+struct Bits128
+{
+	uint64_t w[2];
+};
+
+struct BitPair
+{
+	int s;	// source bit: byte (s >> 3), value bit (s & 7)
+	int d;	// destination bit in a Bits128
+};
+
+// For every source nibble and nibble value, the destination bits it sets.
+template <int NBYTES>
+struct BitMap
+{
+	Bits128 t[NBYTES * 2][16];
+};
+
+template <int NBYTES, typename F>
+constexpr BitMap<NBYTES> make_map(int npairs, F pair)
+{
+	BitMap<NBYTES> m = {};
+	for (int k = 0; k < npairs; k++) {
+		const BitPair p = pair(k);
+		const int nib = p.s >> 2;
+		for (int v = 0; v < 16; v++) {
+			if (v & (1 << (p.s & 3)))
+				m.t[nib][v].w[p.d >> 6] |= uint64_t(1) << (p.d & 63);
+		}
+	}
+	return m;
+}
+
+template <int NBYTES>
+inline Bits128 apply(const BitMap<NBYTES> &m, const uint8_t *src)
+{
+	Bits128 r = {{0, 0}};
+	for (int i = 0; i < NBYTES; i++) {
+		const Bits128 &lo = m.t[2 * i][src[i] & 0x0F];
+		const Bits128 &hi = m.t[2 * i + 1][src[i] >> 4];
+		r.w[0] |= lo.w[0] | hi.w[0];
+		r.w[1] |= lo.w[1] | hi.w[1];
+	}
+	return r;
+}
+
+// frame bit n counted MSB first -> Bits128 bit whose little endian byte image is the frame
+constexpr int msb_first(int n)
+{
+	return (n & ~7) + 7 - (n & 7);
+}
+
+constexpr int lsb_offset(const int *lengths, int nfields, int f)
+{
+	int off = 0;
+	for (int i = f + 1; i < nfields; i++)
+		off += lengths[i];
+	return off;
+}
+
+constexpr BitMap<9> dstar_rx = make_map<9>(72, [](int k) {
+	return BitPair{k, (dW[k] * 24) + dX[k]};
+});
+
+constexpr BitMap<9> dmr_rx = make_map<9>(72, [](int q) {
+	const int k = q >> 1;
+	const int i = k >> 2;
+	const int j = 2 * (k & 3);
+	return (q & 1) ? BitPair{(8 * i) + 7 - j, (rW[k] * 24) + rX[k]}
+	               : BitPair{(8 * i) + 6 - j, (rY[k] * 24) + rZ[k]};
+});
+
+// 48 quantizer bits (MSB first) -> Golay input order, bit 47 first
+constexpr BitMap<6> dstar_tx_pre = make_map<6>(48, [](int i) {
+	return BitPair{47 - m_list[i], 47 - i};
+});
+
+// c0 | c1 | 24 uncoded bits, MSB first from bit 71 -> frame bits, LSB first per byte
+constexpr BitMap<9> dstar_tx = make_map<9>(72, [](int i) {
+	return BitPair{71 - i, d_list[i]};
+});
+
+// 49 quantizer bits packed MSB first -> YSF frame order
+constexpr BitMap<7> ysf_tx = make_map<7>(49, [](int k) {
+	return BitPair{lsb_offset(b_lengths, 9, y_field[k]) + y_bit[k], msb_first(k)};
+});
+
+// a (24 bits), b (23 bits), c (25 bits) MSB first from bit 71 -> A/B/C_TABLE positions
+constexpr BitMap<9> dmr_tx = make_map<9>(72, [](int k) {
+	const int n = (k < 24) ? A_TABLE[k] : (k < 47) ? B_TABLE[k - 24] : C_TABLE[k - 47];
+	return BitPair{71 - k, msb_first(n)};
+});
+
+constexpr uint32_t golay_encoding[12] = {
+	040006165,
+	020003073,
+	010007550,
+	04003664,
+	02001732,
+	01006631,
+	0403315,
+	0201547,
+	0106706,
+	045227,
+	024476,
+	014353
+};
+
+// Golay(24,12) parity is linear, so the 12 data bits split into two 6 bit lookups
+struct GolayTable
+{
+	uint32_t t[2][64];
+};
+
+constexpr GolayTable make_golay()
+{
+	GolayTable g = {};
+	for (int h = 0; h < 2; h++) {
+		for (int v = 0; v < 64; v++) {
+			for (int i = 0; i < 6; i++) {
+				if (v & (1 << (5 - i)))
+					g.t[h][v] ^= golay_encoding[(6 * h) + i];
+			}
+		}
+	}
+	return g;
+}
+
+constexpr GolayTable golay = make_golay();
+
+// one char per bit, LSB first
+struct SpreadTable
+{
+	char t[256][8];
+};
+
+constexpr SpreadTable make_spread()
+{
+	SpreadTable s = {};
+	for (int v = 0; v < 256; v++) {
+		for (int i = 0; i < 8; i++)
+			s.t[v][i] = (v >> i) & 1;
+	}
+	return s;
+}
+
+constexpr SpreadTable spread = make_spread();
+
+inline uint32_t golay_24_encode(uint32_t code_word_in)
+{
+	return golay.t[0][(code_word_in >> 6) & 0x3F] ^ golay.t[1][code_word_in & 0x3F];
+}
+
+inline uint32_t golay_23_encode(uint32_t code_word_in)
+{
+	return golay_24_encode(code_word_in) >> 1;
+}
+
+inline void load_bytes(uint8_t *dst, uint64_t v, int n)
+{
+	for (int i = 0; i < n; i++)
+		dst[i] = (v >> (8 * i)) & 0xFF;
+}
+
+inline void store_frame(uint8_t *frame, const Bits128 &r, int n)
+{
+	for (int i = 0; i < n; i++)
+		frame[i] = (r.w[i >> 3] >> (8 * (i & 7))) & 0xFF;
+}
+
+inline uint64_t pack_params(const int *b, const int *lengths)
+{
+	uint64_t acc = 0;
+	for (int i = 0; i < 9; i++)
+		acc = (acc << lengths[i]) | (uint64_t)(b[i] & ((1 << lengths[i]) - 1));
+	return acc;
+}
+
+inline void expand_fr(const Bits128 &r, char ambe_fr[4][24])
+{
+	char *fr = &ambe_fr[0][0];
+	for (int i = 0; i < 12; i++)
+		memcpy(fr + (8 * i), spread.t[(r.w[i >> 3] >> (8 * (i & 7))) & 0xFF], 8);
+}
+
+}
+
+void ambe_unpack_2400x1200(const uint8_t *frame, char ambe_fr[4][24])
+{
+	expand_fr(apply(dstar_rx, frame), ambe_fr);
+}
+
+void ambe_unpack_2450x1150(const uint8_t *frame, char ambe_fr[4][24])
+{
+	expand_fr(apply(dmr_rx, frame), ambe_fr);
+}
+
+void ambe_unpack_2450(const uint8_t *frame, char ambe_d[49])
+{
+	for (int k = 0; k < 49; k++)
+		ambe_d[k] = (frame[k >> 3] >> (7 - (k & 7))) & 1;
+}
+
+void ambe_pack_2400x1200(const int *b, uint8_t *frame)
+{
+	uint8_t src[9];
+
+	load_bytes(src, pack_params(b, dstar_b_lengths), 6);
+	const uint64_t p = apply(dstar_tx_pre, src).w[0];
+	const uint32_t u0 = (p >> 36) & 0xFFF;
+	const uint32_t u1 = (p >> 24) & 0xFFF;
+	const uint32_t c0 = golay_24_encode(u0);
+	const uint32_t c1 = golay_24_encode(u1) ^ PRNG_TABLE[u0];
+
+	load_bytes(src, (p & 0xFFFFFF) | ((uint64_t)c1 << 24) | ((uint64_t)c0 << 48), 8);
+	src[8] = c0 >> 16;
+	store_frame(frame, apply(dstar_tx, src), 9);
+}
+
+void ambe_pack_2450(const int *b, uint8_t *frame)
+{
+	uint8_t src[7];
+
+	load_bytes(src, pack_params(b, b_lengths), 7);
+	store_frame(frame, apply(ysf_tx, src), 7);
+}
+
+void ambe_pack_2450x1150(const int *b, uint8_t *frame)
+{
+	uint8_t tmp[7];
+	uint8_t src[9];
+
+	ambe_pack_2450(b, tmp);
+	const uint32_t aOrig = (tmp[0] << 4) | (tmp[1] >> 4);
+	const uint32_t bOrig = ((tmp[1] & 0x0F) << 8) | tmp[2];
+	const uint32_t cOrig = (tmp[3] << 17) | (tmp[4] << 9) | (tmp[5] << 1) | (tmp[6] >> 7);
+
+	const uint32_t a = golay_24_encode(aOrig);
+	const uint32_t p = PRNG_TABLE[aOrig] >> 1;
+	const uint32_t bb = golay_23_encode(bOrig) ^ p;
+
+	load_bytes(src, cOrig | ((uint64_t)bb << 25) | ((uint64_t)a << 48), 8);
+	src[8] = a >> 16;
+	store_frame(frame, apply(dmr_tx, src), 9);
+}
@@ -0,0 +1,37 @@
+/*
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+ * OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef AMBE_FRAMING_H
+#define AMBE_FRAMING_H
+
+#include <cstdint>
+
+// Packing and unpacking of the AMBE frames carried by D-Star (2400x1200,
+// 9 bytes), DMR (2450x1150, 9 bytes) and YSF (2450, 49 bits in 7 bytes).
+//
+// unpack: network frame -> mbelib one-char-per-bit layout
+// pack:   quantizer parameters b[0..8] -> network frame (FEC included)
+//
+// All bit permutations go through nibble lookup tables that are generated
+// at compile time, so no per-bit walk is done at runtime.
+
+void ambe_unpack_2400x1200(const uint8_t *frame, char ambe_fr[4][24]);
+void ambe_unpack_2450x1150(const uint8_t *frame, char ambe_fr[4][24]);
+void ambe_unpack_2450(const uint8_t *frame, char ambe_d[49]);
+
+void ambe_pack_2400x1200(const int *b, uint8_t *frame);
+void ambe_pack_2450x1150(const int *b, uint8_t *frame);
+void ambe_pack_2450(const int *b, uint8_t *frame);
+
+#endif // AMBE_FRAMING_H
@@ -0,0 +1,307 @@
+/*
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+ * OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "ambe_quant.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define AMBE_QUANT_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+typedef int (*search_fn)(const float *soa, int n, const float *t, int dim);
+
+int search_mode = AMBE_SEARCH_EXACT;
+
+// The error of every entry is summed in dimension order starting from the
+// first squared difference, exactly as the scalar loops in encode_ambe() do,
+// and an entry only wins on a strictly smaller error, so the lowest index
+// wins ties. Partial sums never decrease, so an entry can be abandoned as
+// soon as its partial sum reaches the best error.
+int search_generic(const float *soa, int n, const float *t, int dim)
+{
+	int best_i = 0;
+	float best = 0.0f;
+
+	for (int d = 0; d < dim; d++) {
+		const float diff = t[d] - soa[d * n];
+		best += diff * diff;
+	}
+	for (int i = 1; i < n; i++) {
+		float diff = t[0] - soa[i];
+		float err = diff * diff;
+		for (int d = 1; d < dim && !(err >= best); d++) {
+			diff = t[d] - soa[(d * n) + i];
+			err += diff * diff;
+		}
+		if (err < best) {
+			best = err;
+			best_i = i;
+		}
+	}
+	return best_i;
+}
+
+// lane minima -> overall minimum, ties to the lowest index, then the tail
+int reduce_lanes(const float *best, const int *idx, int lanes, const float *soa, int n, const float *t, int dim)
+{
+	int r = 0;
+	for (int j = 1; j < lanes; j++) {
+		if ((best[j] < best[r]) || ((best[j] == best[r]) && (idx[j] < idx[r])))
+			r = j;
+	}
+
+	int best_i = idx[r];
+	float best_err = best[r];
+	for (int i = n - (n % lanes); i < n; i++) {
+		float err = 0.0f;
+		for (int d = 0; d < dim; d++) {
+			const float diff = t[d] - soa[(d * n) + i];
+			err += diff * diff;
+		}
+		if (err < best_err) {
+			best_err = err;
+			best_i = i;
+		}
+	}
+	return best_i;
+}
+
+// The vector kernels score 4 or 8 entries at once and always sum every
+// dimension. With at most 4 dimensions a partial-distance test costs as
+// much as the dimensions it saves: abandoning a block once no lane can
+// still win made the search 1.3 to 2 times slower on the 512x3, 128x4 and
+// 32x4 codebooks, checked after every dimension or only after the second.
+#ifdef AMBE_QUANT_X86
+__attribute__((target("sse2")))
+inline __m128 dist_sse2(const float *soa, int n, int i, const float *t, int dim)
+{
+	__m128 diff = _mm_sub_ps(_mm_set1_ps(t[0]), _mm_loadu_ps(soa + i));
+	__m128 err = _mm_mul_ps(diff, diff);
+	for (int d = 1; d < dim; d++) {
+		diff = _mm_sub_ps(_mm_set1_ps(t[d]), _mm_loadu_ps(soa + (d * n) + i));
+		err = _mm_add_ps(err, _mm_mul_ps(diff, diff));
+	}
+	return err;
+}
+
+__attribute__((target("sse2")))
+int search_sse2(const float *soa, int n, const float *t, int dim)
+{
+	if (n < 4)
+		return search_generic(soa, n, t, dim);
+
+	__m128 best = dist_sse2(soa, n, 0, t, dim);
+	__m128i idx = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i cur = idx;
+	const __m128i step = _mm_set1_epi32(4);
+
+	for (int i = 4; (i + 4) <= n; i += 4) {
+		cur = _mm_add_epi32(cur, step);
+		const __m128 err = dist_sse2(soa, n, i, t, dim);
+		const __m128 lt = _mm_cmplt_ps(err, best);
+		best = _mm_or_ps(_mm_and_ps(lt, err), _mm_andnot_ps(lt, best));
+		const __m128i m = _mm_castps_si128(lt);
+		idx = _mm_or_si128(_mm_and_si128(m, cur), _mm_andnot_si128(m, idx));
+	}
+
+	float b[4];
+	int x[4];
+	_mm_storeu_ps(b, best);
+	_mm_storeu_si128((__m128i *)x, idx);
+	return reduce_lanes(b, x, 4, soa, n, t, dim);
+}
+
+__attribute__((target("avx2")))
+inline __m256 dist_avx2(const float *soa, int n, int i, const float *t, int dim)
+{
+	__m256 diff = _mm256_sub_ps(_mm256_set1_ps(t[0]), _mm256_loadu_ps(soa + i));
+	__m256 err = _mm256_mul_ps(diff, diff);
+	for (int d = 1; d < dim; d++) {
+		diff = _mm256_sub_ps(_mm256_set1_ps(t[d]), _mm256_loadu_ps(soa + (d * n) + i));
+		err = _mm256_add_ps(err, _mm256_mul_ps(diff, diff));
+	}
+	return err;
+}
+
+__attribute__((target("avx2")))
+int search_avx2(const float *soa, int n, const float *t, int dim)
+{
+	if (n < 8)
+		return search_sse2(soa, n, t, dim);
+
+	__m256 best = dist_avx2(soa, n, 0, t, dim);
+	__m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i cur = idx;
+	const __m256i step = _mm256_set1_epi32(8);
+
+	for (int i = 8; (i + 8) <= n; i += 8) {
+		cur = _mm256_add_epi32(cur, step);
+		const __m256 err = dist_avx2(soa, n, i, t, dim);
+		const __m256 lt = _mm256_cmp_ps(err, best, _CMP_LT_OQ);
+		best = _mm256_blendv_ps(best, err, lt);
+		idx = _mm256_blendv_epi8(idx, cur, _mm256_castps_si256(lt));
+	}
+
+	float b[8];
+	int x[8];
+	_mm256_storeu_ps(b, best);
+	_mm256_storeu_si256((__m256i *)x, idx);
+	_mm256_zeroupper();	// reduce_lanes() is SSE code, avoid the transition penalty
+	return reduce_lanes(b, x, 8, soa, n, t, dim);
+}
+#endif
+
+search_fn best_search()
+{
+#ifdef AMBE_QUANT_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return search_avx2;
+	if (__builtin_cpu_supports("sse2"))
+		return search_sse2;
+#endif
+	return search_generic;
+}
+
+}
+
+int ambe_set_search_mode(int mode)
+{
+	search_mode = (mode == AMBE_SEARCH_COARSE) ? AMBE_SEARCH_COARSE : AMBE_SEARCH_EXACT;
+	return search_mode;
+}
+
+int ambe_get_search_mode()
+{
+	return search_mode;
+}
+
+AmbeCodebook::AmbeCodebook(const float *rows, int n, int dim) :
+	m_n(n),
+	m_dim(dim),
+	m_soa(n * dim),
+	m_clusters((n >= 128) ? (n / 32) : 0)
+{
+	for (int d = 0; d < dim; d++) {
+		for (int i = 0; i < n; i++)
+			m_soa[(d * n) + i] = rows[(i * dim) + d];
+	}
+	if (m_clusters == 0)
+		return;
+
+	// a few rounds of k-means, seeded with evenly spaced entries
+	std::vector<int> owner(n);
+	std::vector<float> sum(m_clusters * dim);
+	std::vector<int> count(m_clusters);
+	m_centroid.resize(m_clusters * dim);
+	for (int c = 0; c < m_clusters; c++) {
+		for (int d = 0; d < dim; d++)
+			m_centroid[(c * dim) + d] = rows[(c * (n / m_clusters) * dim) + d];
+	}
+	for (int round = 0; round < 16; round++) {
+		std::fill(sum.begin(), sum.end(), 0.0f);
+		std::fill(count.begin(), count.end(), 0);
+		for (int i = 0; i < n; i++) {
+			float best = 0.0f;
+			for (int c = 0; c < m_clusters; c++) {
+				float err = 0.0f;
+				for (int d = 0; d < dim; d++) {
+					const float diff = rows[(i * dim) + d] - m_centroid[(c * dim) + d];
+					err += diff * diff;
+				}
+				if ((c == 0) || (err < best)) {
+					best = err;
+					owner[i] = c;
+				}
+			}
+			count[owner[i]]++;
+			for (int d = 0; d < dim; d++)
+				sum[(owner[i] * dim) + d] += rows[(i * dim) + d];
+		}
+		for (int c = 0; c < m_clusters; c++) {
+			for (int d = 0; d < dim && count[c]; d++)
+				m_centroid[(c * dim) + d] = sum[(c * dim) + d] / count[c];
+		}
+	}
+
+	m_start.assign(m_clusters + 1, 0);
+	for (int c = 0; c < m_clusters; c++)
+		m_start[c + 1] = m_start[c] + count[c];
+	m_member.resize(n);
+	m_rows.resize(n * dim);
+	std::vector<uint16_t> fill(m_start.begin(), m_start.end() - 1);
+	for (int i = 0; i < n; i++) {
+		const int k = fill[owner[i]]++;
+		m_member[k] = i;
+		std::copy(rows + (i * dim), rows + ((i + 1) * dim), m_rows.begin() + (k * dim));
+	}
+}
+
+int AmbeCodebook::search(const float *target, int dim) const
+{
+	static const search_fn fn = best_search();
+
+	dim = std::min(dim, m_dim);
+	if ((search_mode == AMBE_SEARCH_COARSE) && m_clusters && (dim == m_dim))
+		return searchCoarse(target, dim);
+	return fn(m_soa.data(), m_n, target, dim);
+}
+
+// Score the centroids, then only the members of the two nearest clusters.
+// Not bit-exact with the full search.
+int AmbeCodebook::searchCoarse(const float *target, int dim) const
+{
+	int near[2] = {0, 0};
+	float near_err[2] = {0.0f, 0.0f};
+	for (int c = 0; c < m_clusters; c++) {
+		float err = 0.0f;
+		for (int d = 0; d < dim; d++) {
+			const float diff = target[d] - m_centroid[(c * m_dim) + d];
+			err += diff * diff;
+		}
+		if ((c == 0) || (err < near_err[0])) {
+			near[1] = near[0];
+			near_err[1] = near_err[0];
+			near[0] = c;
+			near_err[0] = err;
+		}
+		else if ((c == 1) || (err < near_err[1])) {
+			near[1] = c;
+			near_err[1] = err;
+		}
+	}
+
+	int best_i = -1;
+	float best = 0.0f;
+	for (int p = 0; p < 2; p++) {
+		for (int k = m_start[near[p]]; k < m_start[near[p] + 1]; k++) {
+			const float *row = &m_rows[k * m_dim];
+			const int i = m_member[k];
+			float err = 0.0f;
+			for (int d = 0; d < dim; d++) {
+				const float diff = target[d] - row[d];
+				err += diff * diff;
+			}
+			if ((best_i < 0) || (err < best) || ((err == best) && (i < best_i))) {
+				best = err;
+				best_i = i;
+			}
+		}
+	}
+	return best_i;
+}
@@ -0,0 +1,58 @@
+/*
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+ * OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef AMBE_QUANT_H
+#define AMBE_QUANT_H
+
+#include <cstdint>
+#include <vector>
+
+// Nearest-neighbour search over the AMBE vector quantizer codebooks
+// (PRBA24, PRBA58, HOC b5..b8) used by encode_ambe().
+//
+// AMBE_SEARCH_EXACT returns the same index as the scalar search it replaces:
+// squared errors are summed in the same order and ties go to the lowest
+// index. AMBE_SEARCH_COARSE first picks the nearest clusters of the larger
+// codebooks and only scores their members, trading a little quantization
+// error for a fraction of the work on hosts without SIMD.
+
+#define AMBE_SEARCH_EXACT	0
+#define AMBE_SEARCH_COARSE	1
+
+int ambe_set_search_mode(int mode);
+int ambe_get_search_mode();
+
+class AmbeCodebook
+{
+public:
+	// rows[n][dim], row major as in the mbelib tables
+	AmbeCodebook(const float *rows, int n, int dim);
+
+	// index of the entry closest to target[0..dim-1], dim <= the codebook's
+	int search(const float *target, int dim) const;
+
+private:
+	int m_n;
+	int m_dim;
+	std::vector<float> m_soa;	//!< m_soa[d * m_n + i] = rows[i][d]
+	int m_clusters;					//!< 0 when the codebook is too small to split
+	std::vector<float> m_centroid;	//!< m_centroid[c * m_dim + d]
+	std::vector<uint16_t> m_start;	//!< members of cluster c are m_member[m_start[c] .. m_start[c + 1]]
+	std::vector<uint16_t> m_member;	//!< codebook index of each member
+	std::vector<float> m_rows;		//!< member rows in cluster order, row major
+
+	int searchCoarse(const float *target, int dim) const;
+};
+
+#endif // AMBE_QUANT_H
@@ -0,0 +1,230 @@
+/*
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+ * OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Windowed oscillator kernels for mbe_synthesizeSpeechf.
+ *
+ * Every term of the MBE synthesis equations has the form
+ *   out[n] += amp * win[n] * cos(w * (n + n0) + phase)
+ * so instead of one cosf() per sample the kernels below seed a small
+ * vector of complex phasors (one per lane) and advance all lanes by a
+ * single rotation per step. With 160 samples the rotation is applied at
+ * most 40 times. The phase tracks are wrapped every frame, so both this
+ * and the reference cosf() path get small arguments and stay within
+ * MBE_SYNTH_TOLERANCE of each other however long the stream; the vocoder
+ * bench --check mode verifies this over 2000 frames.
+ */
+
+#include <math.h>
+
+#include "mbelib.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MBE_SYNTH_X86
+#include <immintrin.h>
+#endif
+
+typedef void (*mbe_osc_fn) (float *out, const float *win, float amp, float w, float phase, int n0, int N);
+
+/* seed lanes with cos/sin(w * (n0 + j) + phase), j = 0..lanes-1 */
+static void
+mbe_seedLanes (float *re, float *im, int lanes, float w, float phase, int n0)
+{
+
+  int j;
+  float a, c, s, r;
+
+  a = (w * (float) n0) + phase;
+  re[0] = cosf (a);
+  im[0] = sinf (a);
+  c = cosf (w);
+  s = sinf (w);
+  for (j = 1; j < lanes; j++)
+    {
+      r = (re[j - 1] * c) - (im[j - 1] * s);
+      im[j] = (re[j - 1] * s) + (im[j - 1] * c);
+      re[j] = r;
+    }
+}
+
+static void
+mbe_oscTail (float *out, const float *win, float amp, float w, float phase, int n0, int n, int N)
+{
+  for (; n < N; n++)
+    {
+      out[n] += amp * win[n] * cosf ((w * (float) (n + n0)) + phase);
+    }
+}
+
+/* plain C, laid out so that the compiler can vectorize it on any target */
+static void
+mbe_oscGeneric (float *out, const float *win, float amp, float w, float phase, int n0, int N)
+{
+
+  int n, j;
+  float re[8], im[8], r, c8, s8;
+
+  mbe_seedLanes (re, im, 8, w, phase, n0);
+  c8 = cosf (w * (float) 8);
+  s8 = sinf (w * (float) 8);
+  for (n = 0; (n + 8) <= N; n += 8)
+    {
+      for (j = 0; j < 8; j++)
+        {
+          out[n + j] += amp * win[n + j] * re[j];
+          r = (re[j] * c8) - (im[j] * s8);
+          im[j] = (re[j] * s8) + (im[j] * c8);
+          re[j] = r;
+        }
+    }
+  mbe_oscTail (out, win, amp, w, phase, n0, n, N);
+}
+
+#ifdef MBE_SYNTH_X86
+__attribute__ ((target ("sse2")))
+static void
+mbe_oscSse2 (float *out, const float *win, float amp, float w, float phase, int n0, int N)
+{
+
+  int n;
+  float re[4], im[4];
+  __m128 vre, vim, vr, vc, vs, va;
+
+  mbe_seedLanes (re, im, 4, w, phase, n0);
+  vre = _mm_loadu_ps (re);
+  vim = _mm_loadu_ps (im);
+  vc = _mm_set1_ps (cosf (w * (float) 4));
+  vs = _mm_set1_ps (sinf (w * (float) 4));
+  va = _mm_set1_ps (amp);
+  for (n = 0; (n + 4) <= N; n += 4)
+    {
+      __m128 acc = _mm_loadu_ps (out + n);
+      acc = _mm_add_ps (acc, _mm_mul_ps (_mm_mul_ps (va, _mm_loadu_ps (win + n)), vre));
+      _mm_storeu_ps (out + n, acc);
+      vr = _mm_sub_ps (_mm_mul_ps (vre, vc), _mm_mul_ps (vim, vs));
+      vim = _mm_add_ps (_mm_mul_ps (vre, vs), _mm_mul_ps (vim, vc));
+      vre = vr;
+    }
+  mbe_oscTail (out, win, amp, w, phase, n0, n, N);
+}
+
+__attribute__ ((target ("avx2")))
+static void
+mbe_oscAvx2 (float *out, const float *win, float amp, float w, float phase, int n0, int N)
+{
+
+  int n;
+  float re[8], im[8];
+  __m256 vre, vim, vr, vc, vs, va;
+
+  mbe_seedLanes (re, im, 8, w, phase, n0);
+  vre = _mm256_loadu_ps (re);
+  vim = _mm256_loadu_ps (im);
+  vc = _mm256_set1_ps (cosf (w * (float) 8));
+  vs = _mm256_set1_ps (sinf (w * (float) 8));
+  va = _mm256_set1_ps (amp);
+  for (n = 0; (n + 8) <= N; n += 8)
+    {
+      __m256 acc = _mm256_loadu_ps (out + n);
+      acc = _mm256_add_ps (acc, _mm256_mul_ps (_mm256_mul_ps (va, _mm256_loadu_ps (win + n)), vre));
+      _mm256_storeu_ps (out + n, acc);
+      vr = _mm256_sub_ps (_mm256_mul_ps (vre, vc), _mm256_mul_ps (vim, vs));
+      vim = _mm256_add_ps (_mm256_mul_ps (vre, vs), _mm256_mul_ps (vim, vc));
+      vre = vr;
+    }
+  mbe_oscTail (out, win, amp, w, phase, n0, n, N);
+}
+#endif
+
+/*
+ * Set before main() and only changed by mbe_setSynthesisEngine(), which
+ * must not be called while a decoder is running. The generic kernel runs
+ * on every target; x86 builds pick a faster one in mbe_initSynthesis().
+ */
+static mbe_osc_fn mbe_osc = mbe_oscGeneric;
+static int mbe_engine = MBE_SYNTH_GENERIC;
+
+static int
+mbe_bestSynthesisEngine ()
+{
+#ifdef MBE_SYNTH_X86
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2"))
+    {
+      return MBE_SYNTH_AVX2;
+    }
+  if (__builtin_cpu_supports ("sse2"))
+    {
+      return MBE_SYNTH_SSE2;
+    }
+#endif
+  return MBE_SYNTH_GENERIC;
+}
+
+int
+mbe_setSynthesisEngine (int engine)
+{
+
+  int best;
+
+  best = mbe_bestSynthesisEngine ();
+  if ((engine == MBE_SYNTH_AUTO) || (engine > best))
+    {
+      engine = best;
+    }
+
+  switch (engine)
+    {
+#ifdef MBE_SYNTH_X86
+    case MBE_SYNTH_AVX2:
+      mbe_osc = mbe_oscAvx2;
+      break;
+    case MBE_SYNTH_SSE2:
+      mbe_osc = mbe_oscSse2;
+      break;
+#endif
+    case MBE_SYNTH_REFERENCE:
+      // mbe_synthesizeSpeechf bypasses the oscillators entirely
+      mbe_osc = mbe_oscGeneric;
+      break;
+    default:
+      engine = MBE_SYNTH_GENERIC;
+      mbe_osc = mbe_oscGeneric;
+      break;
+    }
+  mbe_engine = engine;
+  return engine;
+}
+
+#ifdef MBE_SYNTH_X86
+/* runs once at load time, before any thread can synthesize */
+__attribute__ ((constructor))
+static void
+mbe_initSynthesis ()
+{
+  mbe_setSynthesisEngine (MBE_SYNTH_AUTO);
+}
+#endif
+
+int
+mbe_getSynthesisEngine ()
+{
+  return mbe_engine;
+}
+
+void
+mbe_synthesizeOscillator (float *aout_buf, const float *win, float amp, float w, float phase, int n0, int N)
+{
+  mbe_osc (aout_buf, win, amp, w, phase, n0, N);
+}
@@ -22,23 +22,134 @@
 #include "mbelib.h"
 #include "mbelib_const.h"
 
+/*
+ * Used by mbe_parms without a noise state of their own. It is shared and
+ * unlocked, so such parms may only be synthesized from one thread at a
+ * time; decoders running in parallel must each set mbe_parms.noise.
+ */
+static mbe_noise mbe_defaultNoise;
+
+/**
+ * \return A pseudo-random 32 bit word, counter based so that every
+ * decoder owning an mbe_noise state gets its own reproducible stream.
+ */
+static unsigned int
+mbe_noiseHash (unsigned int key, unsigned int ctr)
+{
+  unsigned int x;
+
+  x = key + (ctr * 0x9E3779B9U);
+  x ^= x >> 16;
+  x *= 0x7FEB352DU;
+  x ^= x >> 15;
+  x *= 0x846CA68BU;
+  x ^= x >> 16;
+  return x;
+}
+
+/**
+ * \return A pseudo-random float between [0.0, 1.0).
+ */
+static float
+mbe_rand (mbe_noise * ns)
+{
+  return (float) (mbe_noiseHash (ns->key, ns->ctr++) >> 8) * ((float) 1 / (float) 16777216);
+}
+
 /**
- * \return A pseudo-random float between [0.0, 1.0].
- * See http://www.azillionmonkeys.com/qed/random.html for further improvements
+ * \return The phase x wrapped into [0, 2pi). PSIl grows by up to a few
+ * thousand radians a frame, unwrapped it loses all of its fraction bits
+ * in float within seconds.
  */
 static float
-mbe_rand()
+mbe_wrapPhase (float x)
 {
-  return ((float) rand () / (float) RAND_MAX);
+  return (float) (x - ((M_PI * 2.0) * floor (x / (M_PI * 2.0))));
 }
 
 /**
  * \return A pseudo-random float between [-pi, +pi].
  */
 static float
-mbe_rand_phase()
+mbe_rand_phase (mbe_noise * ns)
+{
+  return mbe_rand (ns) * (((float)M_PI) * 2.0F) - ((float)M_PI);
+}
+
+/**
+ * Rebuild the multisine offsets and the noise table for uvquality.
+ * Each table entry holds the sum of uvquality uniform values, i.e. the
+ * per-sample noise of one unvoiced band before scaling.
+ */
+static void
+mbe_buildNoise (mbe_noise * ns, int uvquality)
+{
+
+  int i, k;
+  float uvstep, uvoffset, sum;
+  unsigned int key;
+
+  uvstep = (float) 1.0 / (float) uvquality;
+  uvoffset = (uvstep * (float) (uvquality - 1)) / (float) 2;
+  if (uvquality == 1)
+    {
+      ns->qfactor = (float) 1 / M_E;
+    }
+  else
+    {
+      ns->qfactor = log ((float) uvquality) / (float) uvquality;
+    }
+  for (i = 0; i < uvquality; i++)
+    {
+      ns->multisine[i] = ((float) i * uvstep) - uvoffset;
+    }
+
+  key = ns->key ^ 0x5BD1E995U;
+  for (k = 0; k < MBE_NOISE_TABLE; k++)
+    {
+      sum = 0;
+      for (i = 0; i < uvquality; i++)
+        {
+          sum += (float) (mbe_noiseHash (key, (k * uvquality) + i) >> 8) * ((float) 1 / (float) 16777216);
+        }
+      ns->table[k] = sum;
+    }
+  for (k = 0; k < MBE_NOISE_RUN; k++)
+    {
+      ns->table[MBE_NOISE_TABLE + k] = ns->table[k];
+    }
+  ns->uvquality = uvquality;
+}
+
+static mbe_noise *
+mbe_noiseState (mbe_parms * cur_mp, int uvquality)
+{
+
+  mbe_noise *ns;
+
+  ns = (cur_mp->noise != NULL) ? cur_mp->noise : &mbe_defaultNoise;
+  if (ns->uvquality != uvquality)
+    {
+      mbe_buildNoise (ns, uvquality);
+    }
+  return ns;
+}
+
+/**
+ * \return MBE_NOISE_RUN consecutive noise table entries at a random offset.
+ */
+static const float *
+mbe_noiseRun (mbe_noise * ns)
+{
+  return ns->table + (mbe_noiseHash (ns->key, ns->ctr++) & (MBE_NOISE_TABLE - 1));
+}
+
+void
+mbe_initNoise (mbe_noise * ns, unsigned int seed)
 {
-  return mbe_rand() * (((float)M_PI) * 2.0F) - ((float)M_PI);
+  ns->key = seed;
+  ns->ctr = 0;
+  ns->uvquality = 0;
 }
 
 void
@@ -215,7 +326,7 @@ mbe_synthesizeSilence (short *aout_buf)
 }
 
 void
-mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp, int uvquality)
+mbe_synthesizeSpeechfReference (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp, int uvquality)
 {
 
   int i, l, n, maxl;
@@ -228,6 +339,8 @@ mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp,
   float uvstep, uvoffset;
   float qfactor;
   float rphase[64], rphase2[64];
+  mbe_noise *ns;
+  const float *noise, *noise2;
 
   const int N = 160;
 
@@ -244,6 +357,8 @@ mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp,
       uvquality = 3;
     }
 
+  ns = mbe_noiseState (cur_mp, uvquality);
+
   // calculate loguvquality
   if (uvquality == 1)
     {
@@ -303,14 +418,14 @@ mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp,
   // update phil from eq 139,140
   for (l = 1; l <= 56; l++)
     {
-      cur_mp->PSIl[l] = prev_mp->PSIl[l] + ((pw0 + cw0) * ((float) (l * N) / (float) 2));
+      cur_mp->PSIl[l] = mbe_wrapPhase (prev_mp->PSIl[l] + ((pw0 + cw0) * ((float) (l * N) / (float) 2)));
       if (l <= (int) (cur_mp->L / 4))
         {
           cur_mp->PHIl[l] = cur_mp->PSIl[l];
         }
       else
         {
-          cur_mp->PHIl[l] = cur_mp->PSIl[l] + ((numUv * mbe_rand_phase()) / cur_mp->L);
+          cur_mp->PHIl[l] = cur_mp->PSIl[l] + ((numUv * mbe_rand_phase (ns)) / cur_mp->L);
         }
     }
 
@@ -324,8 +439,9 @@ mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp,
           // init random phase
           for (i = 0; i < uvquality; i++)
             {
-              rphase[i] = mbe_rand_phase();
+              rphase[i] = mbe_rand_phase (ns);
             }
+          noise = (cw0l > uvthreshold) ? mbe_noiseRun (ns) : NULL;
           for (n = 0; n < N; n++)
             {
               C1 = 0;
@@ -336,10 +452,10 @@ mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp,
               for (i = 0; i < uvquality; i++)
                 {
                   C3 = C3 + cosf ((cw0 * (float) n * ((float) l + ((float) i * uvstep) - uvoffset)) + rphase[i]);
-                  if (cw0l > uvthreshold)
-                    {
-                      C3 = C3 + ((cw0l - uvthreshold) * uvrand * mbe_rand());
-                    }
+                }
+              if (cw0l > uvthreshold)
+                {
+                  C3 = C3 + ((cw0l - uvthreshold) * uvrand * noise[n]);
                 }
               C3 = C3 * uvsine * Ws[n] * cur_mp->Ml[l] * qfactor;
               *Ss = *Ss + C1 + C3;
@@ -352,8 +468,9 @@ mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp,
           // init random phase
           for (i = 0; i < uvquality; i++)
             {
-              rphase[i] = mbe_rand_phase();
+              rphase[i] = mbe_rand_phase (ns);
             }
+          noise = (pw0l > uvthreshold) ? mbe_noiseRun (ns) : NULL;
           for (n = 0; n < N; n++)
             {
               C1 = 0;
@@ -364,10 +481,10 @@ mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp,
               for (i = 0; i < uvquality; i++)
                 {
                   C3 = C3 + cosf ((pw0 * (float) n * ((float) l + ((float) i * uvstep) - uvoffset)) + rphase[i]);
-                  if (pw0l > uvthreshold)
-                    {
-                      C3 = C3 + ((pw0l - uvthreshold) * uvrand * mbe_rand());
-                    }
+                }
+              if (pw0l > uvthreshold)
+                {
+                  C3 = C3 + ((pw0l - uvthreshold) * uvrand * noise[n]);
                 }
               C3 = C3 * uvsine * Ws[n + N] * prev_mp->Ml[l] * qfactor;
               *Ss = *Ss + C1 + C3;
@@ -417,13 +534,15 @@ mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp,
           // init random phase
           for (i = 0; i < uvquality; i++)
             {
-              rphase[i] = mbe_rand_phase();
+              rphase[i] = mbe_rand_phase (ns);
             }
           // init random phase
           for (i = 0; i < uvquality; i++)
             {
-              rphase2[i] = mbe_rand_phase();
+              rphase2[i] = mbe_rand_phase (ns);
             }
+          noise = (pw0l > uvthreshold) ? mbe_noiseRun (ns) : NULL;
+          noise2 = (cw0l > uvthreshold) ? mbe_noiseRun (ns) : NULL;
           for (n = 0; n < N; n++)
             {
               C3 = 0;
@@ -431,10 +550,10 @@ mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp,
               for (i = 0; i < uvquality; i++)
                 {
                   C3 = C3 + cosf ((pw0 * (float) n * ((float) l + ((float) i * uvstep) - uvoffset)) + rphase[i]);
-                  if (pw0l > uvthreshold)
-                    {
-                      C3 = C3 + ((pw0l - uvthreshold) * uvrand * mbe_rand());
-                    }
+                }
+              if (pw0l > uvthreshold)
+                {
+                  C3 = C3 + ((pw0l - uvthreshold) * uvrand * noise[n]);
                 }
               C3 = C3 * uvsine * Ws[n + N] * prev_mp->Ml[l] * qfactor;
               C4 = 0;
@@ -442,10 +561,10 @@ mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp,
               for (i = 0; i < uvquality; i++)
                 {
                   C4 = C4 + cosf ((cw0 * (float) n * ((float) l + ((float) i * uvstep) - uvoffset)) + rphase2[i]);
-                  if (cw0l > uvthreshold)
-                    {
-                      C4 = C4 + ((cw0l - uvthreshold) * uvrand * mbe_rand());
-                    }
+                }
+              if (cw0l > uvthreshold)
+                {
+                  C4 = C4 + ((cw0l - uvthreshold) * uvrand * noise2[n]);
                 }
               C4 = C4 * uvsine * Ws[n] * cur_mp->Ml[l] * qfactor;
               *Ss = *Ss + C3 + C4;
@@ -455,6 +574,198 @@ mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp,
     }
 }
 
+void
+mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp, int uvquality)
+{
+
+  int i, l, n, maxl;
+  int numUv;
+  float cw0, pw0, cw0l, pw0l;
+  float uvsine, uvrand, uvthreshold, uvthresholdf;
+  float qfactor, cuvamp, puvamp, cnoise, pnoise;
+  float rphase[64], rphase2[64];
+  mbe_noise *ns;
+  const float *noise, *noise2;
+
+  const int N = 160;
+
+  if (mbe_getSynthesisEngine () == MBE_SYNTH_REFERENCE)
+    {
+      mbe_synthesizeSpeechfReference (aout_buf, cur_mp, prev_mp, uvquality);
+      return;
+    }
+
+  uvthresholdf = (float) 2700;
+  uvthreshold = ((uvthresholdf * M_PI) / (float) 4000);
+
+  // voiced/unvoiced/gain settings
+  uvsine = (float) 1.3591409 *M_E;
+  uvrand = (float) 2.0;
+
+  if ((uvquality < 1) || (uvquality > 64))
+    {
+      printf ("\nmbelib: Error - uvquality must be within the range 1 - 64, setting to default value of 3\n");
+      uvquality = 3;
+    }
+
+  // multisine offsets and qfactor are cached with the noise table
+  ns = mbe_noiseState (cur_mp, uvquality);
+  qfactor = ns->qfactor;
+
+  // count number of unvoiced bands
+  numUv = 0;
+  for (l = 1; l <= cur_mp->L; l++)
+    {
+      if (cur_mp->Vl[l] == 0)
+        {
+          numUv++;
+        }
+    }
+
+  cw0 = cur_mp->w0;
+  pw0 = prev_mp->w0;
+
+  // init aout_buf
+  for (n = 0; n < N; n++)
+    {
+      aout_buf[n] = (float) 0;
+    }
+
+  // eq 128 and 129
+  if (cur_mp->L > prev_mp->L)
+    {
+      maxl = cur_mp->L;
+      for (l = prev_mp->L + 1; l <= maxl; l++)
+        {
+          prev_mp->Ml[l] = (float) 0;
+          prev_mp->Vl[l] = 1;
+        }
+    }
+  else
+    {
+      maxl = prev_mp->L;
+      for (l = cur_mp->L + 1; l <= maxl; l++)
+        {
+          cur_mp->Ml[l] = (float) 0;
+          cur_mp->Vl[l] = 1;
+        }
+    }
+
+  // update phil from eq 139,140
+  for (l = 1; l <= 56; l++)
+    {
+      cur_mp->PSIl[l] = mbe_wrapPhase (prev_mp->PSIl[l] + ((pw0 + cw0) * ((float) (l * N) / (float) 2)));
+      if (l <= (int) (cur_mp->L / 4))
+        {
+          cur_mp->PHIl[l] = cur_mp->PSIl[l];
+        }
+      else
+        {
+          cur_mp->PHIl[l] = cur_mp->PSIl[l] + ((numUv * mbe_rand_phase (ns)) / cur_mp->L);
+        }
+    }
+
+  // same terms as mbe_synthesizeSpeechfReference, one oscillator per cosine;
+  // the noise state is advanced in the reference order
+  for (l = 1; l <= maxl; l++)
+    {
+      cw0l = (cw0 * (float) l);
+      pw0l = (pw0 * (float) l);
+      cuvamp = uvsine * cur_mp->Ml[l] * qfactor;
+      puvamp = uvsine * prev_mp->Ml[l] * qfactor;
+      cnoise = (cw0l > uvthreshold) ? ((cw0l - uvthreshold) * uvrand) : (float) 0;
+      pnoise = (pw0l > uvthreshold) ? ((pw0l - uvthreshold) * uvrand) : (float) 0;
+      if ((cur_mp->Vl[l] == 0) && (prev_mp->Vl[l] == 1))
+        {
+          // init random phase
+          for (i = 0; i < uvquality; i++)
+            {
+              rphase[i] = mbe_rand_phase (ns);
+            }
+          // eq 131
+          mbe_synthesizeOscillator (aout_buf, Ws + N, prev_mp->Ml[l], pw0l, prev_mp->PHIl[l], 0, N);
+          // unvoiced multisine mix
+          for (i = 0; i < uvquality; i++)
+            {
+              mbe_synthesizeOscillator (aout_buf, Ws, cuvamp, cw0 * ((float) l + ns->multisine[i]), rphase[i], 0, N);
+            }
+          if (cnoise != 0)
+            {
+              noise = mbe_noiseRun (ns);
+              for (n = 0; n < N; n++)
+                {
+                  aout_buf[n] += cnoise * noise[n] * Ws[n] * cuvamp;
+                }
+            }
+        }
+      else if ((cur_mp->Vl[l] == 1) && (prev_mp->Vl[l] == 0))
+        {
+          // init random phase
+          for (i = 0; i < uvquality; i++)
+            {
+              rphase[i] = mbe_rand_phase (ns);
+            }
+          // eq 132
+          mbe_synthesizeOscillator (aout_buf, Ws, cur_mp->Ml[l], cw0l, cur_mp->PHIl[l], -N, N);
+          // unvoiced multisine mix
+          for (i = 0; i < uvquality; i++)
+            {
+              mbe_synthesizeOscillator (aout_buf, Ws + N, puvamp, pw0 * ((float) l + ns->multisine[i]), rphase[i], 0, N);
+            }
+          if (pnoise != 0)
+            {
+              noise = mbe_noiseRun (ns);
+              for (n = 0; n < N; n++)
+                {
+                  aout_buf[n] += pnoise * noise[n] * Ws[n + N] * puvamp;
+                }
+            }
+        }
+      else if ((cur_mp->Vl[l] == 1) || (prev_mp->Vl[l] == 1))
+        {
+          // eq 133-1
+          mbe_synthesizeOscillator (aout_buf, Ws + N, prev_mp->Ml[l], pw0l, prev_mp->PHIl[l], 0, N);
+          // eq 133-2
+          mbe_synthesizeOscillator (aout_buf, Ws, cur_mp->Ml[l], cw0l, cur_mp->PHIl[l], -N, N);
+        }
+      else
+        {
+          // init random phase
+          for (i = 0; i < uvquality; i++)
+            {
+              rphase[i] = mbe_rand_phase (ns);
+            }
+          // init random phase
+          for (i = 0; i < uvquality; i++)
+            {
+              rphase2[i] = mbe_rand_phase (ns);
+            }
+          // unvoiced multisine mix
+          for (i = 0; i < uvquality; i++)
+            {
+              mbe_synthesizeOscillator (aout_buf, Ws + N, puvamp, pw0 * ((float) l + ns->multisine[i]), rphase[i], 0, N);
+              mbe_synthesizeOscillator (aout_buf, Ws, cuvamp, cw0 * ((float) l + ns->multisine[i]), rphase2[i], 0, N);
+            }
+          if (pnoise != 0)
+            {
+              noise = mbe_noiseRun (ns);
+              for (n = 0; n < N; n++)
+                {
+                  aout_buf[n] += pnoise * noise[n] * Ws[n + N] * puvamp;
+                }
+            }
+          if (cnoise != 0)
+            {
+              noise2 = mbe_noiseRun (ns);
+              for (n = 0; n < N; n++)
+                {
+                  aout_buf[n] += cnoise * noise2[n] * Ws[n] * cuvamp;
+                }
+            }
+        }
+    }
+}
+
 void
 mbe_synthesizeSpeech (short *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp, int uvquality)
 {
@@ -20,6 +20,38 @@
 
 #define MBELIB_VERSION "1.3.0"
 
+/*
+ * Synthesis engines for mbe_synthesizeSpeechf, see mbe_synth.c.
+ * MBE_SYNTH_REFERENCE evaluates cosf() per sample as upstream mbelib does;
+ * the other engines use phasor oscillators and stay within
+ * MBE_SYNTH_TOLERANCE (relative to the signal peak) of the reference.
+ */
+#define MBE_SYNTH_AUTO -1
+#define MBE_SYNTH_REFERENCE 0
+#define MBE_SYNTH_GENERIC 1
+#define MBE_SYNTH_SSE2 2
+#define MBE_SYNTH_AVX2 3
+#define MBE_SYNTH_TOLERANCE 1e-3f
+
+#define MBE_NOISE_TABLE 1024
+#define MBE_NOISE_RUN 160
+
+/*
+ * Per-decoder unvoiced noise state: counter based PRNG plus the
+ * multisine offsets and noise table for the current uvquality.
+ */
+struct mbe_noise_state
+{
+  unsigned int key;
+  unsigned int ctr;
+  int uvquality;
+  float qfactor;
+  float multisine[64];
+  float table[MBE_NOISE_TABLE + MBE_NOISE_RUN];
+};
+
+typedef struct mbe_noise_state mbe_noise;
+
 struct mbe_parameters
 {
   float w0;
@@ -33,6 +65,7 @@ struct mbe_parameters
   float gamma;
   int un;
   int repeat;
+  mbe_noise *noise;             // NULL uses a shared state, single thread only
 };
 
 typedef struct mbe_parameters mbe_parms;
@@ -102,12 +135,22 @@ void mbe_processImbe7100x4400Frame (short *aout_buf, int *errs, int *errs2, char
 void mbe_printVersion (char *str);
 void mbe_moveMbeParms (mbe_parms * cur_mp, mbe_parms * prev_mp);
 void mbe_useLastMbeParms (mbe_parms * cur_mp, mbe_parms * prev_mp);
+void mbe_initNoise (mbe_noise * ns, unsigned int seed);
 void mbe_initMbeParms (mbe_parms * cur_mp, mbe_parms * prev_mp, mbe_parms * prev_mp_enhanced);
 void mbe_spectralAmpEnhance (mbe_parms * cur_mp);
 void mbe_synthesizeSilencef (float *aout_buf);
 void mbe_synthesizeSilence (short *aout_buf);
+void mbe_synthesizeSpeechfReference (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp, int uvquality);
 void mbe_synthesizeSpeechf (float *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp, int uvquality);
 void mbe_synthesizeSpeech (short *aout_buf, mbe_parms * cur_mp, mbe_parms * prev_mp, int uvquality);
 void mbe_floattoshort (float *float_buf, short *aout_buf);
 
+/*
+ * Prototypes from mbe_synth.c, the engine is chosen at load time and may
+ * only be changed while no decoder is running
+ */
+int mbe_setSynthesisEngine (int engine);
+int mbe_getSynthesisEngine ();
+void mbe_synthesizeOscillator (float *aout_buf, const float *win, float amp, float w, float phase, int n0, int N);
+
 #endif
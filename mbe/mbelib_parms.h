@@ -28,9 +28,9 @@ struct mbelibParms
 
     mbelibParms()
     {
-        m_cur_mp = (mbe_parms *) malloc(sizeof(mbe_parms));
-        m_prev_mp = (mbe_parms *) malloc(sizeof(mbe_parms));
-        m_prev_mp_enhanced = (mbe_parms *) malloc(sizeof(mbe_parms));
+        m_cur_mp = (mbe_parms *) calloc(1, sizeof(mbe_parms));
+        m_prev_mp = (mbe_parms *) calloc(1, sizeof(mbe_parms));
+        m_prev_mp_enhanced = (mbe_parms *) calloc(1, sizeof(mbe_parms));
     }
 
     ~mbelibParms()
@@ -15,9 +15,11 @@
 #include <stdio.h>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
 
 #include "vocoder_plugin.h"
-#include "vocoder_tables.h"
+#include "ambe_framing.h"
+#include "ambe_quant.h"
 #include "ambe3600x2400_const.h"
 #include "ambe3600x2450_const.h"
 
@@ -128,102 +130,6 @@ static const short b0_lookup[] = {
 	119, 119, 119
 };
 
-static const int m_list[] = {0, 1, 2, 3, 4, 5, 11, 12, 13, 14, 17, 18, 19, 20, 21, 22, 23, 26, 27, 28, 29, 30, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 7, 8, 9, 10, 15, 16, 24, 25, 31, 32, 6};
-static const int d_list[] = {7, 1, 11, 21, 31, 25, 35, 45, 55, 49, 59, 69, 6, 0, 10, 20, 30, 24, 34, 44, 54, 48, 58, 68, 5, 15, 9, 19, 29, 39, 33, 43, 53, 63, 57, 67, 4, 14, 8, 18, 28, 38, 32, 42, 52, 62, 56, 66, 3, 13, 23, 17, 27, 37, 47, 41, 51, 61, 71, 65, 2, 12, 22, 16, 26, 36, 46, 40, 50, 60, 70, 64};
-//static const int alt_d_list[] = {0, 12, 24, 36, 48, 60, 1, 13, 25, 37, 49, 61, 2, 14, 26, 38, 50, 62, 3, 15, 27, 39, 51, 63, 4, 16, 28, 40, 52, 64, 5, 17, 29, 41, 53, 65, 6, 18, 30, 42, 54, 66, 7, 19, 31, 43, 55, 67, 8, 20, 32, 44, 56, 68, 9, 21, 33, 45, 57, 69, 10, 22, 34, 46, 58, 70, 11, 23, 35, 47, 59, 71};
-static const int b_lengths[] = {7,4,6,9,7,4,4,4,3};
-
-const int dW[72] = {0,0,3,2,1,1,0,0,1,1,0,0,3,2,1,1,3,2,1,1,0,0,3,2,0,0,3,2,1,1,0,0,1,1,0,0,
-                                3,2,1,1,3,2,1,1,0,0,3,2,0,0,3,2,1,1,0,0,1,1,0,0,3,2,1,1,3,3,2,1,0,0,3,3,};
-
-const int dX[72] = {10,22,11,9,10,22,11,23,8,20,9,21,10,8,9,21,8,6,7,19,8,20,9,7,6,18,7,5,6,18,7,19,4,16,5,17,6,
-                                4,5,17,4,2,3,15,4,16,5,3,2,14,3,1,2,14,3,15,0,12,1,13,2,0,1,13,0,12,10,11,0,12,1,13,};
-const int rW[36] = {
-  0, 1, 0, 1, 0, 1,
-  0, 1, 0, 1, 0, 1,
-  0, 1, 0, 1, 0, 1,
-  0, 1, 0, 1, 0, 2,
-  0, 2, 0, 2, 0, 2,
-  0, 2, 0, 2, 0, 2
-};
-
-const int rX[36] = {
-  23, 10, 22, 9, 21, 8,
-  20, 7, 19, 6, 18, 5,
-  17, 4, 16, 3, 15, 2,
-  14, 1, 13, 0, 12, 10,
-  11, 9, 10, 8, 9, 7,
-  8, 6, 7, 5, 6, 4
-};
-
-// bit 0
-const int rY[36] = {
-  0, 2, 0, 2, 0, 2,
-  0, 2, 0, 3, 0, 3,
-  1, 3, 1, 3, 1, 3,
-  1, 3, 1, 3, 1, 3,
-  1, 3, 1, 3, 1, 3,
-  1, 3, 1, 3, 1, 3
-};
-
-const int rZ[36] = {
-  5, 3, 4, 2, 3, 1,
-  2, 0, 1, 13, 0, 12,
-  22, 11, 21, 10, 20, 9,
-  19, 8, 18, 7, 17, 6,
-  16, 5, 15, 4, 14, 3,
-  13, 2, 12, 1, 11, 0
-};
-
-
-static inline uint32_t golay_24_encode(uint32_t code_word_in)
-{
-   static const uint32_t encoding[12] = {
-      040006165,
-      020003073,
-      010007550,
-      04003664,
-      02001732,
-      01006631,
-      0403315,
-      0201547,
-      0106706,
-      045227,
-      024476,
-      014353
-   };
-
-	uint32_t code_word_out = 0;
-	for(uint16_t i = 0; i < 12; i++) {
-		uint32_t temp_word = code_word_in & (1 << (11 - i));
-		if(temp_word >= 1) {
-			code_word_out = code_word_out ^ encoding[i];
-		}
-	}
-	return(code_word_out);
-}
-
-static inline uint32_t golay_23_encode(uint32_t code_word_in)
-{
-	return golay_24_encode(code_word_in) >> 1;
-}
-
-static inline void store_reg(int reg, uint8_t val[], int len)
-{
-	for (int i=0; i<len; i++){
-		val[i] = (reg >> (len-1-i)) & 1;
-	}
-}
-
-static inline int load_reg(const uint8_t val[], int len)
-{
-	int acc = 0;
-	for (int i=0; i<len; i++){
-		acc = (acc << 1) + (val[i] & 1);
-	}
-	return acc;
-}
-
 inline float make_f0(int b0) {
 	return (powf(2, (-4.311767578125 - (2.1336e-2 * ((float)b0+0.5)))));
 }
@@ -633,6 +539,55 @@ mbe_dequantizeAmbe2250Parms (mbe_parms * cur_mp, mbe_parms * prev_mp, const int
 }
 
 
+// cosine terms of the block DCTs in encode_ambe(), computed with the same
+// expressions the loops used to evaluate for every frame
+struct AmbeDctTables {
+	float c[18][17][17];	// [J][k-1][j-1]
+	float g[8][8];			// [m-1][i-1]
+};
+
+static const AmbeDctTables &ambe_dct_tables()
+{
+	static const AmbeDctTables *tables = [] {
+		AmbeDctTables *t = new AmbeDctTables();
+		for (int J=1; J<=17; J++) {
+			for (int k=1; k<=J; k++) {
+				for (int j=1; j<=J; j++) {
+					t->c[J][k-1][j-1] = cosf((M_PI * (((float)k) - 1.0) * (((float)j) - 0.5)) / (float)J);
+				}
+			}
+		}
+		for (int m=1; m<=8; m++) {
+			for (int i=1; i<=8; i++) {
+				t->g[m-1][i-1] = cosf((M_PI * (((float)m) - 1.0) * (((float)i) - 0.5)) / 8.0);
+			}
+		}
+		return t;
+	}();
+	return *tables;
+}
+
+struct AmbeCodebooks {
+	AmbeCodebook prba24;
+	AmbeCodebook prba58;
+	AmbeCodebook hoc[4];
+};
+
+static const AmbeCodebooks &ambe_codebooks(bool dstar)
+{
+	static const AmbeCodebooks ambe = {
+		{AmbePRBA24[0], 512, 3},
+		{AmbePRBA58[0], 128, 4},
+		{{AmbeHOCb5[0], 32, 4}, {AmbeHOCb6[0], 16, 4}, {AmbeHOCb7[0], 16, 4}, {AmbeHOCb8[0], 8, 4}}
+	};
+	static const AmbeCodebooks ambe_plus = {
+		{AmbePlusPRBA24[0], 512, 3},
+		{AmbePlusPRBA58[0], 128, 4},
+		{{AmbePlusHOCb5[0], 16, 4}, {AmbePlusHOCb6[0], 16, 4}, {AmbePlusHOCb7[0], 16, 4}, {AmbePlusHOCb8[0], 16, 4}}
+	};
+	return (dstar) ? ambe_plus : ambe;
+}
+
 void encode_ambe(const IMBE_PARAM *imbe_param, int b[], mbe_parms*cur_mp, mbe_parms*prev_mp, bool dstar, float gain_adjust) {
 	static const float SQRT_2 = sqrtf(2.0);
 	static const int b0_lmax = sizeof(b0_lookup) / sizeof(b0_lookup[0]);
@@ -677,24 +632,23 @@ void encode_ambe(const IMBE_PARAM *imbe_param, int b[], mbe_parms*cur_mp, mbe_pa
 	float en_min = 0;
 	b[1] = 0;
 	int vuv_max = (dstar) ? 16 : 17;
+	// jl and the band decision only depend on l, so work them out once
+	float f0 = (dstar) ? make_f0(b[0]) : AmbeW0table[b[0]];
+	int jl[NUM_HARMS_MAX];
+	int vuv_l[NUM_HARMS_MAX];
+	for (int l=1; l <= L; l++) {
+		jl[l-1] = (int) ((float) l * (float) 16.0 * f0);
+		int kl = 12;
+		if (l <= 36)
+			kl = (l + 2) / 3;
+		vuv_l[l-1] = imbe_param->v_uv_dsn[(kl-1)*3];
+	}
 	for (int n=0; n < vuv_max; n++) {
 		float En = 0;
+		const int *vuv = (dstar) ? AmbePlusVuv[n] : AmbeVuv[n];
 		for (int l=1; l <= L; l++) {
-			int jl;
-			if (dstar)
-				jl = (int) ((float) l * (float) 16.0 * make_f0(b[0]));
-			else
-				jl = (int) ((float) l * (float) 16.0 * AmbeW0table[b[0]]);
-			int kl = 12;
-			if (l <= 36)
-				kl = (l + 2) / 3;
-			if (dstar) {
-				if (imbe_param->v_uv_dsn[(kl-1)*3] != AmbePlusVuv[n][jl])
-					En += m_float2[l-1];
-			} else {
-				if (imbe_param->v_uv_dsn[(kl-1)*3] != AmbeVuv[n][jl])
-					En += m_float2[l-1];
-			}
+			if (vuv_l[l-1] != vuv[jl[l-1]])
+				En += m_float2[l-1];
 		}
 		if (n == 0)
 			en_min = En;
@@ -708,10 +662,7 @@ void encode_ambe(const IMBE_PARAM *imbe_param, int b[], mbe_parms*cur_mp, mbe_pa
 	float num_harms_f = (float) imbe_param->num_harms;
 	float log_l_2 =  0.5 * log2f(num_harms_f);	// fixme: table lookup
 	float log_l_w0;
-	if (dstar)
-		log_l_w0 = 0.5 * log2f(num_harms_f * make_f0(b[0]) * 2.0 * M_PI) + 2.289;
-	else
-		log_l_w0 = 0.5 * log2f(num_harms_f * AmbeW0table[b[0]] * 2.0 * M_PI) + 2.289;
+	log_l_w0 = 0.5 * log2f(num_harms_f * f0 * 2.0 * M_PI) + 2.289;
 	float lsa[NUM_HARMS_MAX];
 	float lsa_sum=0.0;
 
@@ -734,6 +685,8 @@ void encode_ambe(const IMBE_PARAM *imbe_param, int b[], mbe_parms*cur_mp, mbe_pa
 
 	diff_gain -= gain_adjust;
 
+	// A scalar scan of at most 64 entries, about 100 ns of a 36 us frame,
+	// too little to pay for an AmbeCodebook and its setup
 	float error;
 	int error_index;
 	int max_dg = (dstar) ? 64 : 32;
@@ -783,13 +736,14 @@ void encode_ambe(const IMBE_PARAM *imbe_param, int b[], mbe_parms*cur_mp, mbe_pa
 		c[i] = &T[acc];
 		acc += J[i];
 	}
+	const AmbeDctTables &dct = ambe_dct_tables();
 	float C[4][17];
 	for (int i=1; i<=4; i++) {
 		for (int k=1; k<=J[i-1]; k++) {
+			const float *ck = dct.c[J[i-1]][k-1];
 			float s = 0.0;
 			for (int j=1; j<=J[i-1]; j++) {
-				//fixme: lut?
-				s += (c[i-1][j-1] * cosf((M_PI * (((float)k) - 1.0) * (((float)j) - 0.5)) / (float)J[i-1]));
+				s += (c[i-1][j-1] * ck[j-1]);
 			}
 			C[i-1][k-1] = s / (float)J[i-1];
 		}
@@ -809,158 +763,20 @@ void encode_ambe(const IMBE_PARAM *imbe_param, int b[], mbe_parms*cur_mp, mbe_pa
 	for (int m=1; m<=8; m++) {
 		G[m-1] = 0.0;
 		for (int i=1; i<=8; i++) {
-			//fixme: lut?
-			G[m-1] += (R[i-1] * cosf((M_PI * (((float)m) - 1.0) * (((float)i) - 0.5)) / 8.0));
+			G[m-1] += (R[i-1] * dct.g[m-1][i-1]);
 		}
 		G[m-1] /= 8.0;
 	}
-	for (int i=0; i<512; i++) {
-		float err=0.0;
-		float diff;
-		if (dstar) {
-			diff = G[1] - AmbePlusPRBA24[i][0];
-			err += (diff * diff);
-			diff = G[2] - AmbePlusPRBA24[i][1];
-			err += (diff * diff);
-			diff = G[3] - AmbePlusPRBA24[i][2];
-			err += (diff * diff);
-		} else {
-			diff = G[1] - AmbePRBA24[i][0];
-			err += (diff * diff);
-			diff = G[2] - AmbePRBA24[i][1];
-			err += (diff * diff);
-			diff = G[3] - AmbePRBA24[i][2];
-			err += (diff * diff);
-		}
-		if (i == 0 || err < error) {
-			error = err;
-			error_index = i;
-		}
-	}
-	b[3] = error_index;
-
-	// PRBA58
-	for (int i=0; i<128; i++) {
-		float err=0.0;
-		float diff;
-		if (dstar) {
-			diff = G[4] - AmbePlusPRBA58[i][0];
-			err += (diff * diff);
-			diff = G[5] - AmbePlusPRBA58[i][1];
-			err += (diff * diff);
-			diff = G[6] - AmbePlusPRBA58[i][2];
-			err += (diff * diff);
-			diff = G[7] - AmbePlusPRBA58[i][3];
-			err += (diff * diff);
-		} else {
-			diff = G[4] - AmbePRBA58[i][0];
-			err += (diff * diff);
-			diff = G[5] - AmbePRBA58[i][1];
-			err += (diff * diff);
-			diff = G[6] - AmbePRBA58[i][2];
-			err += (diff * diff);
-			diff = G[7] - AmbePRBA58[i][3];
-			err += (diff * diff);
-		}
-		if (i == 0 || err < error) {
-			error = err;
-			error_index = i;
-		}
-	}
-	b[4] = error_index;
-
-	// higher order coeffs b5
-	int ii = 1;
-	if (J[ii-1] <= 2) {
-		b[4+ii] = 0.0;
-	} else {
-		int max_5 = (dstar) ? 16 : 32;
-		for (int n=0; n < max_5; n++) {
-			float err=0.0;
-			float diff;
-			for (int j=1; j <= J[ii-1]-2 && j <= 4; j++) {
-				if (dstar)
-					diff = AmbePlusHOCb5[n][j-1] - C[ii-1][j+2-1];
-				else
-					diff = AmbeHOCb5[n][j-1] - C[ii-1][j+2-1];
-				err += (diff * diff);
-			}
-			if (n == 0 || err < error) {
-				error = err;
-				error_index = n;
-			}
-		}
-		b[4+ii] = error_index;
-	}
-
-	// higher order coeffs b6
-	ii = 2;
-	if (J[ii-1] <= 2) {
-		b[4+ii] = 0.0;
-	} else {
-		for (int n=0; n < 16; n++) {
-			float err=0.0;
-			float diff;
-			for (int j=1; j <= J[ii-1]-2 && j <= 4; j++) {
-				if (dstar)
-					diff = AmbePlusHOCb6[n][j-1] - C[ii-1][j+2-1];
-				else
-					diff = AmbeHOCb6[n][j-1] - C[ii-1][j+2-1];
-				err += (diff * diff);
-			}
-			if (n == 0 || err < error) {
-				error = err;
-				error_index = n;
-			}
-		}
-		b[4+ii] = error_index;
-	}
+	const AmbeCodebooks &cb = ambe_codebooks(dstar);
+	b[3] = cb.prba24.search(&G[1], 3);
+	b[4] = cb.prba58.search(&G[4], 4);
 
-	// higher order coeffs b7
-	ii = 3;
-	if (J[ii-1] <= 2) {
-		b[4+ii] = 0.0;
-	} else {
-		for (int n=0; n < 16; n++) {
-			float err=0.0;
-			float diff;
-			for (int j=1; j <= J[ii-1]-2 && j <= 4; j++) {
-				if (dstar)
-					diff = AmbePlusHOCb7[n][j-1] - C[ii-1][j+2-1];
-				else
-					diff = AmbeHOCb7[n][j-1] - C[ii-1][j+2-1];
-				err += (diff * diff);
-			}
-			if (n == 0 || err < error) {
-				error = err;
-				error_index = n;
-			}
-		}
-		b[4+ii] = error_index;
-	}
-
-	// higher order coeffs b8
-	ii = 4;
-	if (J[ii-1] <= 2) {
-		b[4+ii] = 0.0;
-	} else {
-		int max_8 = (dstar) ? 16 : 8;
-		for (int n=0; n < max_8; n++) {
-			float err=0.0;
-			float diff;
-			for (int j=1; j <= J[ii-1]-2 && j <= 4; j++) {
-				if (dstar)
-					diff = AmbePlusHOCb8[n][j-1] - C[ii-1][j+2-1];
-				else
-					diff = AmbeHOCb8[n][j-1] - C[ii-1][j+2-1];
-				err += (diff * diff);
-			}
-			if (n == 0 || err < error) {
-				error = err;
-				error_index = n;
-			}
-		}
-		b[4+ii] = error_index;
+	// higher order coeffs b5 - b8
+	for (int ii=1; ii <= 4; ii++) {
+		if (J[ii-1] <= 2)
+			b[4+ii] = 0.0;
+		else
+			b[4+ii] = cb.hoc[ii-1].search(&C[ii-1][2], std::min(J[ii-1]-2, 4));
 	}
 	//fprintf (stderr, "B\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\n", b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7], b[8]);
 	//int rc;
@@ -971,15 +787,13 @@ void encode_ambe(const IMBE_PARAM *imbe_param, int b[], mbe_parms*cur_mp, mbe_pa
 	mbe_moveMbeParms (cur_mp, prev_mp);
 }
 
-	VocoderPlugin::VocoderPlugin()
+	VocoderPlugin::VocoderPlugin(unsigned int seed)
 	{
 		m_mbelibParms = new mbelibParms();
-		m_audio_out_temp_buf_p = m_audio_out_temp_buf;
+		memset(m_audio_out_temp_buf, 0, sizeof(m_audio_out_temp_buf));
 
-		memset(m_audio_out_buf, 0, sizeof(short) * 2 * 48000);
-		m_audio_out_buf_p = m_audio_out_buf;
-		m_audio_out_nb_samples = 0;
-		m_audio_out_buf_size = 48000; // given in number of unique samples
+		mbe_initNoise(&m_noise, seed);
+		m_mbelibParms->m_cur_mp->noise = &m_noise;
 
 		initMbeParms();
 		memset(ambe_d, 0, 49);
@@ -991,193 +805,92 @@ void encode_ambe(const IMBE_PARAM *imbe_param, int b[], mbe_parms*cur_mp, mbe_pa
 	
 	void VocoderPlugin::decode_2400x1200(int16_t *pcm, uint8_t *ambe)
 	{
-		int samples = 0;
 		process_2400x1200(ambe);
-		int16_t *p = getAudio(samples);
-		memcpy(pcm, p, samples * sizeof(int16_t));
-		resetAudio();
+		storeAudio(pcm);
 	}
 
 	void VocoderPlugin::decode_2450x1150(int16_t *pcm, uint8_t *ambe)
 	{
-		int samples = 0;
 		process_2450x1150(ambe);
-		int16_t *p = getAudio(samples);
-		memcpy(pcm, p, samples * sizeof(int16_t));
-		resetAudio();
+		storeAudio(pcm);
 	}
 
 	void VocoderPlugin::decode_2450(int16_t *pcm, uint8_t *ambe)
 	{
-		int samples = 0;
 		process_2450(ambe);
-		int16_t *p = getAudio(samples);
-		memcpy(pcm, p, samples * sizeof(int16_t));
-		resetAudio();
+		storeAudio(pcm);
 	}
 	
-	void VocoderPlugin::encode_2400x1200(int16_t *pcm, uint8_t *ambe)
+	void VocoderPlugin::decode_2400x1200_batch(int16_t *pcm, const uint8_t *frames, size_t n)
 	{
-		int b[9];
-		int16_t frame_vector[8];	// result ignored
-		uint8_t ambe_frame[72];
-		
-		uint8_t pbuf[48];
-		uint8_t tbuf[48];
-		int tbufp = 0;
-		
-		vocoder.imbe_encode(frame_vector, pcm);
-		encode_ambe(vocoder.param(), b, m_mbelibParms->m_cur_mp, m_mbelibParms->m_prev_mp, true, 1.0);
-		
-		for (int i=0; i < 9; i++) {
-			store_reg(b[i], &tbuf[tbufp], b_lengths[i]);
-			tbufp += b_lengths[i];
-		}
-		
-		for (int i=0; i < 48; i++)
-			pbuf[i] = tbuf[m_list[i]];
-			
-		int u0 = load_reg(pbuf+0, 12);
-		int u1 = load_reg(pbuf+12, 12);
-
-		int m1 = PRNG_TABLE[u0];
-		int c0 = golay_24_encode(u0);
-		int c1 = golay_24_encode(u1) ^ m1;
-
-		uint8_t pre_buf[72];
-		store_reg(c0, pre_buf, 24);
-		store_reg(c1, pre_buf+24, 24);
-		memcpy(pre_buf+48, pbuf+24, 24);
-
-		for (int i=0; i < 72; i++)
-			ambe_frame[d_list[i]] = pre_buf[i];
-
-		for(int i = 0; i < 9; ++i){
-			for(int j = 0; j < 8; ++j){
-				ambe[i] |= (ambe_frame[(i*8)+j] << j);
-			}
+		for (size_t i = 0; i < n; ++i) {
+			process_2400x1200(frames + (9 * i));
+			storeAudio(pcm + (160 * i));
 		}
 	}
-	
-	void VocoderPlugin::encode_2450x1150(int16_t *pcm, uint8_t *ambe)
+
+	void VocoderPlugin::decode_2450x1150_batch(int16_t *pcm, const uint8_t *frames, size_t n)
 	{
-		unsigned int aOrig = 0U;
-		unsigned int bOrig = 0U;
-		unsigned int cOrig = 0U;
-		unsigned int MASK = 0x000800U;
-		uint8_t tmp[9];
-		
-		memset(tmp, 0, 9);
-		memset(ambe, 0, 9);
-		encode_2450(pcm, tmp);
-		
-		for (unsigned int i = 0U; i < 12U; i++, MASK >>= 1) {
-			unsigned int n1 = i;
-			unsigned int n2 = i + 12U;
-			if (READ_BIT(tmp, n1))
-				aOrig |= MASK;
-			if (READ_BIT(tmp, n2))
-				bOrig |= MASK;
+		for (size_t i = 0; i < n; ++i) {
+			process_2450x1150(frames + (9 * i));
+			storeAudio(pcm + (160 * i));
 		}
+	}
 
-		MASK = 0x1000000U;
-		for (unsigned int i = 0U; i < 25U; i++, MASK >>= 1) {
-			unsigned int n = i + 24U;
-			if (READ_BIT(tmp, n))
-				cOrig |= MASK;
+	void VocoderPlugin::decode_2450_batch(int16_t *pcm, const uint8_t *frames, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i) {
+			process_2450(frames + (7 * i));
+			storeAudio(pcm + (160 * i));
 		}
+	}
 
-		unsigned int a = golay_24_encode(aOrig);
-
-		// The PRNG
-		unsigned int p = PRNG_TABLE[aOrig] >> 1;
-
-		unsigned int b = golay_23_encode(bOrig);
-		b ^= p;
+	void VocoderPlugin::encode_2400x1200_batch(int16_t *pcm, uint8_t *frames, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+			encode_2400x1200(pcm + (160 * i), frames + (9 * i));
+	}
 
-		MASK = 0x800000U;
-		for (unsigned int i = 0U; i < 24U; i++, MASK >>= 1) {
-			unsigned int aPos = A_TABLE[i];
-			WRITE_BIT(ambe, aPos, a & MASK);
-		}
+	void VocoderPlugin::encode_2450x1150_batch(int16_t *pcm, uint8_t *frames, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+			encode_2450x1150(pcm + (160 * i), frames + (9 * i));
+	}
 
-		MASK = 0x400000U;
-		for (unsigned int i = 0U; i < 23U; i++, MASK >>= 1) {
-			unsigned int bPos = B_TABLE[i];
-			WRITE_BIT(ambe, bPos, b & MASK);
-		}
+	void VocoderPlugin::encode_2450_batch(int16_t *pcm, uint8_t *frames, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+			encode_2450(pcm + (160 * i), frames + (7 * i));
+	}
 
-		MASK = 0x1000000U;
-		for (unsigned int i = 0U; i < 25U; i++, MASK >>= 1) {
-			unsigned int cPos = C_TABLE[i];
-			WRITE_BIT(ambe, cPos, cOrig & MASK);
-		}
+	void VocoderPlugin::encode_2400x1200(int16_t *pcm, uint8_t *ambe)
+	{
+		int b[9];
+		int16_t frame_vector[8];	// result ignored
+		
+		vocoder.imbe_encode(frame_vector, pcm);
+		encode_ambe(vocoder.param(), b, m_mbelibParms->m_cur_mp, m_mbelibParms->m_prev_mp, true, 1.0);
+		ambe_pack_2400x1200(b, ambe);
 	}
 	
-	void VocoderPlugin::encode_2450(int16_t *pcm, uint8_t *ambe)
+	void VocoderPlugin::encode_2450x1150(int16_t *pcm, uint8_t *ambe)
 	{
 		int b[9];
 		int16_t frame_vector[8];	// result ignored
-		uint8_t ambe_frame[49];
 		
 		vocoder.imbe_encode(frame_vector, pcm);
 		encode_ambe(vocoder.param(), b, m_mbelibParms->m_cur_mp, m_mbelibParms->m_prev_mp, false, 1.0);
+		ambe_pack_2450x1150(b, ambe);
+	}
+
+	void VocoderPlugin::encode_2450(int16_t *pcm, uint8_t *ambe)
+	{
+		int b[9];
+		int16_t frame_vector[8];	// result ignored
 		
-		ambe_frame[0] = (b[0] >> 6) & 1;
-		ambe_frame[1] = (b[0] >> 5) & 1;
-		ambe_frame[2] = (b[0] >> 4) & 1;
-		ambe_frame[3] = (b[0] >> 3) & 1;
-		ambe_frame[4] = (b[1] >> 4) & 1;
-		ambe_frame[5] = (b[1] >> 3) & 1;
-		ambe_frame[6] = (b[1] >> 2) & 1;
-		ambe_frame[7] = (b[1] >> 1) & 1;
-		ambe_frame[8] = (b[2] >> 4) & 1;
-		ambe_frame[9] = (b[2] >> 3) & 1;
-		ambe_frame[10] = (b[2] >> 2) & 1;
-		ambe_frame[11] = (b[2] >> 1) & 1;
-		ambe_frame[12] = (b[3] >> 8) & 1;
-		ambe_frame[13] = (b[3] >> 7) & 1;
-		ambe_frame[14] = (b[3] >> 6) & 1;
-		ambe_frame[15] = (b[3] >> 5) & 1;
-		ambe_frame[16] = (b[3] >> 4) & 1;
-		ambe_frame[17] = (b[3] >> 3) & 1;
-		ambe_frame[18] = (b[3] >> 2) & 1;
-		ambe_frame[19] = (b[3] >> 1) & 1;
-		ambe_frame[20] = (b[4] >> 6) & 1;
-		ambe_frame[21] = (b[4] >> 5) & 1;
-		ambe_frame[22] = (b[4] >> 4) & 1;
-		ambe_frame[23] = (b[4] >> 3) & 1;
-		ambe_frame[24] = (b[5] >> 4) & 1;
-		ambe_frame[25] = (b[5] >> 3) & 1;
-		ambe_frame[26] = (b[5] >> 2) & 1;
-		ambe_frame[27] = (b[5] >> 1) & 1;
-		ambe_frame[28] = (b[6] >> 3) & 1;
-		ambe_frame[29] = (b[6] >> 2) & 1;
-		ambe_frame[30] = (b[6] >> 1) & 1;
-		ambe_frame[31] = (b[7] >> 3) & 1;
-		ambe_frame[32] = (b[7] >> 2) & 1;
-		ambe_frame[33] = (b[7] >> 1) & 1;
-		ambe_frame[34] = (b[8] >> 2) & 1;
-		ambe_frame[35] = b[1] & 1;
-		ambe_frame[36] = b[2] & 1;
-		ambe_frame[37] = (b[0] >> 2) & 1;
-		ambe_frame[38] = (b[0] >> 1) & 1;
-		ambe_frame[39] = b[0] & 1;
-		ambe_frame[40] = b[3] & 1;
-		ambe_frame[41] = (b[4] >> 2) & 1;
-		ambe_frame[42] = (b[4] >> 1) & 1;
-		ambe_frame[43] = b[4] & 1;
-		ambe_frame[44] = b[5] & 1;
-		ambe_frame[45] = b[6] & 1;
-		ambe_frame[46] = b[7] & 1;
-		ambe_frame[47] = (b[8] >> 1) & 1;
-		ambe_frame[48] = b[8] & 1;
-		
-		for(int i = 0; i < 7; ++i){
-			for(int j = 0; j < 8; ++j){
-				ambe[i] |= (ambe_frame[(i*8)+j] << (7-j));
-			}
-		}
+		vocoder.imbe_encode(frame_vector, pcm);
+		encode_ambe(vocoder.param(), b, m_mbelibParms->m_cur_mp, m_mbelibParms->m_prev_mp, false, 1.0);
+		ambe_pack_2450(b, ambe);
 	}
 
 	void VocoderPlugin::initMbeParms()
@@ -1188,104 +901,40 @@ void encode_ambe(const IMBE_PARAM *imbe_param, int b[], mbe_parms*cur_mp, mbe_pa
 		m_err_str[0] = 0;
 	}
 	
-	void VocoderPlugin::process_2400x1200(unsigned char *d)
+	void VocoderPlugin::process_2400x1200(const unsigned char *d)
 	{
 		char ambe_fr[4][24];
-    
-		memset(ambe_fr, 0, 96);
-		w = dW;
-		x = dX;
-	
-		for(int i = 0; i < 9; ++i){
-			for(int j = 0; j < 8; ++j){
-				ambe_fr[*w][*x] = (1 & (d[i] >> j));
-				w++;
-				x++;
-			}
-		}
 
+		ambe_unpack_2400x1200(d, ambe_fr);
 		mbe_processAmbe3600x2400Framef(m_audio_out_temp_buf, &m_errs2, m_err_str, ambe_fr, ambe_d,m_mbelibParms-> m_cur_mp, m_mbelibParms->m_prev_mp, m_mbelibParms->m_prev_mp_enhanced, 3);
-		processAudio();
 	}
 
-	void VocoderPlugin::process_2450x1150(unsigned char *d)
+	void VocoderPlugin::process_2450x1150(const unsigned char *d)
 	{
 		char ambe_fr[4][24];
 
-		memset(ambe_fr, 0, 96);
-		w = rW;
-		x = rX;
-		y = rY;
-		z = rZ;
-
-		for(int i = 0; i < 9; ++i){
-			for(int j = 0; j < 8; j+=2){
-				ambe_fr[*y][*z] = (1 & (d[i] >> (7 - (j+1))));
-				ambe_fr[*w][*x] = (1 & (d[i] >> (7 - j)));
-				w++;
-				x++;
-				y++;
-				z++;
-			}
-		}
-
+		ambe_unpack_2450x1150(d, ambe_fr);
 		mbe_processAmbe3600x2450Framef(m_audio_out_temp_buf, &m_errs2, m_err_str, ambe_fr, ambe_d,m_mbelibParms-> m_cur_mp, m_mbelibParms->m_prev_mp, m_mbelibParms->m_prev_mp_enhanced, 3);
-		processAudio();
 	}
 
-	void VocoderPlugin::process_2450(unsigned char *d)
+	void VocoderPlugin::process_2450(const unsigned char *d)
 	{
 		char ambe_data[49];
-		char dvsi_data[7];
-		memset(dvsi_data, 0, 7);
 
-		for(int i = 0; i < 6; ++i){
-			for(int j = 0; j < 8; j++){
-				ambe_data[j+(8*i)] = (1 & (d[i] >> (7 - j)));
-			}
-		}
-		ambe_data[48] = (1 & (d[6] >> 7));
+		ambe_unpack_2450(d, ambe_data);
 		processData(ambe_data);
 	}
 	
 	void VocoderPlugin::processData(char ambe_data[49])
 	{
 		mbe_processAmbe2450Dataf(m_audio_out_temp_buf, &m_errs2, m_err_str, ambe_data, m_mbelibParms->m_cur_mp,m_mbelibParms->m_prev_mp, m_mbelibParms->m_prev_mp_enhanced, 3);
-		processAudio();
 	}
 	
-	short * VocoderPlugin::getAudio(int& nbSamples)
+	void VocoderPlugin::storeAudio(int16_t *pcm)
 	{
-		nbSamples = m_audio_out_nb_samples;
-		return m_audio_out_buf;
-	}
-
-	void VocoderPlugin::resetAudio()
-	{
-		m_audio_out_nb_samples = 0;
-		m_audio_out_buf_p = m_audio_out_buf;
-	}
-	
-	void VocoderPlugin::processAudio()
-	{
-		m_audio_out_temp_buf_p = m_audio_out_temp_buf;
-
-		if (m_audio_out_nb_samples + 160 >= m_audio_out_buf_size){
-            resetAudio();
-		}
-
+		// branch-free clip so the loop vectorizes, same result as the old processAudio()
 		for (int i = 0; i < 160; i++){
-			if (*m_audio_out_temp_buf_p > static_cast<float>(32760)){
-				*m_audio_out_temp_buf_p = static_cast<float>(32760);
-			}
-			else if (*m_audio_out_temp_buf_p < static_cast<float>(-32760)){
-				*m_audio_out_temp_buf_p = static_cast<float>(-32760);
-			}
-
-			*m_audio_out_buf_p = static_cast<short>(*m_audio_out_temp_buf_p);
-			m_audio_out_buf_p++;
-
-			m_audio_out_nb_samples++;
-			m_audio_out_temp_buf_p++;
+			float s = std::min(std::max(m_audio_out_temp_buf[i], -32760.0f), 32760.0f);
+			pcm[i] = static_cast<short>(s);
 		}
 	}
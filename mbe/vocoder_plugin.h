@@ -16,13 +16,16 @@
 #define VOCODER_PLUGIN_H
 
 #include <cinttypes>
+#include <cstddef>
 #include "imbe_vocoder/imbe_vocoder_api.h"
 #include "mbelib_parms.h"
 
 class VocoderPlugin
 {
 public:
-	VocoderPlugin();
+	// seed picks the unvoiced noise stream, output only depends on it and
+	// the frames decoded. Decoders run side by side each pass their own.
+	VocoderPlugin(unsigned int seed = 0);
 	~VocoderPlugin();
 	void decode_2400x1200(int16_t *pcm, uint8_t *codec);
 	void decode_2450x1150(int16_t *pcm, uint8_t *codec);
@@ -30,33 +33,32 @@ public:
 	void encode_2400x1200(int16_t *pcm, uint8_t *codec);
 	void encode_2450x1150(int16_t *pcm, uint8_t *codec);
 	void encode_2450(int16_t *pcm, uint8_t *codec);
+
+	// Batched variants: n consecutive frames, 160 samples of pcm per frame.
+	// Codec frames are 9 bytes (2400x1200, 2450x1150) or 7 bytes (2450).
+	void decode_2400x1200_batch(int16_t *pcm, const uint8_t *frames, size_t n);
+	void decode_2450x1150_batch(int16_t *pcm, const uint8_t *frames, size_t n);
+	void decode_2450_batch(int16_t *pcm, const uint8_t *frames, size_t n);
+	void encode_2400x1200_batch(int16_t *pcm, uint8_t *frames, size_t n);
+	void encode_2450x1150_batch(int16_t *pcm, uint8_t *frames, size_t n);
+	void encode_2450_batch(int16_t *pcm, uint8_t *frames, size_t n);
 	
 private:
 	imbe_vocoder vocoder;
 	mbelibParms *m_mbelibParms;
+	mbe_noise m_noise;
     int m_errs2;
     char m_err_str[64];
 
-    float m_audio_out_temp_buf[160];   //!< output of decoder
-    float *m_audio_out_temp_buf_p;
-    //float m_aout_max_buf[200];
-    //float *m_aout_max_buf_p;
-    //int m_aout_max_buf_idx;
-    short m_audio_out_buf[2*48000];    //!< final result - 1s of L+R S16LE samples
-    short *m_audio_out_buf_p;
-    int   m_audio_out_nb_samples;
-    int   m_audio_out_buf_size;
-	const int *w, *x, *y, *z;
+    float m_audio_out_temp_buf[160];   //!< output of decoder, clipped into the caller's pcm by storeAudio()
 	char ambe_d[49];
 	
 	void initMbeParms();
-	void process_2400x1200(unsigned char *d);
-	void process_2450x1150(unsigned char *d);
-	void process_2450(unsigned char *d);
+	void process_2400x1200(const unsigned char *d);
+	void process_2450x1150(const unsigned char *d);
+	void process_2450(const unsigned char *d);
 	void processData(char ambe_data[49]);
-	short *getAudio(int& nbSamples);
-	void resetAudio();
-	void processAudio();
+	void storeAudio(int16_t *pcm);
 };
 
 #endif // VOCODER_PLUGIN_H
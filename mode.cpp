@@ -97,6 +97,7 @@ void Mode::init(QString callsign, uint32_t dmrid, uint16_t nxdnid, char module,
 
     m_modem = nullptr;
     m_ambedev = nullptr;
+    m_ambech = 0;
     m_mbevocoder = nullptr;
     m_hwrx = false;
     m_hwtx = false;
@@ -132,8 +133,12 @@ void Mode::init(QString callsign, uint32_t dmrid, uint16_t nxdnid, char module,
     m_debug = false;
 }
 
-void Mode::ambe_connect_status(bool s)
+void Mode::ambe_connect_status(bool s, int ch)
 {
+    // A shared device answers the rate packets of every holder
+    if(ch != m_ambech){
+        return;
+    }
     if(s){
 #if !defined(Q_OS_IOS)
         m_modeinfo.ambedesc = m_ambedev->get_ambe_description();
@@ -148,6 +153,13 @@ void Mode::ambe_connect_status(bool s)
     emit update(m_modeinfo);
 }
 
+void Mode::ambe_channel_ready(int ch)
+{
+    if(ch == m_ambech){
+        host_lookup();
+    }
+}
+
 void Mode::mmdvm_connect_status(bool s)
 {
     if(s){
@@ -182,15 +194,23 @@ void Mode::begin_connect()
     m_modeinfo.status = CONNECTING;
 
     if((m_vocoder != "") && (m_mode != "M17")){
+#if !defined(Q_OS_IOS)
+        m_ambedev = VocoderPool::GetInstance().acquire(m_vocoder, m_mode, &m_ambech);
+#endif
+        if(!m_ambedev){
+            qDebug() << "No free hardware vocoder channel, using software vocoder";
+        }
+    }
+
+    if(m_ambedev){
         m_hwrx = true;
         m_hwtx = true;
         m_modeinfo.hw_vocoder_loaded = true;
 #if !defined(Q_OS_IOS)
-        m_ambedev = new SerialAMBE(m_mode);
-        connect(m_ambedev, SIGNAL(connected(bool)), this, SLOT(ambe_connect_status(bool)));
+        connect(m_ambedev, SIGNAL(connected(bool,int)), this, SLOT(ambe_connect_status(bool,int)));
         connect(m_ambedev, SIGNAL(data_ready()), this, SLOT(get_ambe()));
-        connect(m_ambedev, SIGNAL(ambedev_ready()), this, SLOT(host_lookup()));
-        m_ambedev->connect_to_serial(m_vocoder);
+        connect(m_ambedev, SIGNAL(channel_ready(int)), this, SLOT(ambe_channel_ready(int)));
+        VocoderPool::GetInstance().start(m_ambedev, m_ambech);
 #endif
     }
     else{
@@ -241,7 +261,7 @@ void Mode::start_tx()
 {
 #if !defined(Q_OS_IOS)
     if(m_hwtx){
-        m_ambedev->clear_queue();
+        m_ambedev->clear_queue(m_ambech);
     }
 #endif
     m_txcodecq.clear();
@@ -348,14 +368,18 @@ void Mode::deleteLater()
         delete m_audio;
         //if(m_mbevocoder != nullptr) delete m_mbevocoder;
 #if !defined(Q_OS_IOS)
-        if(m_hwtx){
-            delete m_ambedev;
-        }
         if(m_modem){
             delete m_modem;
         }
 #endif
     }
+#if !defined(Q_OS_IOS)
+    // The channel is held from begin_connect() on, connected or not
+    if(m_ambedev){
+        VocoderPool::GetInstance().release(m_ambedev, m_ambech);
+        m_ambedev = nullptr;
+    }
+#endif
     m_modeinfo.count = 0;
     QObject::deleteLater();
 }
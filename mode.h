@@ -33,6 +33,7 @@
 #if !defined(Q_OS_IOS)
 #include "serialambe.h"
 #include "serialmodem.h"
+#include "vocoderpool.h"
 #endif
 
 class Mode : public QObject
@@ -139,7 +140,8 @@ protected slots:
     virtual void hostname_lookup(QHostInfo){}
     virtual void mmdvm_direct_connect(){}
 
-    void ambe_connect_status(bool);
+    void ambe_connect_status(bool, int);
+    void ambe_channel_ready(int);
     void mmdvm_connect_status(bool);
     void begin_connect();
     void input_src_changed(int id, QString t) { m_ttsid = id; m_ttstext = t; }
@@ -215,6 +217,7 @@ protected:
     SerialModem *m_modem;
     SerialAMBE *m_ambedev;
 #endif
+    int m_ambech;
     bool m_hwrx;
     bool m_hwtx;
     bool m_ipv6;
@@ -265,7 +265,7 @@ void NXDN::transmit()
 
 	if(m_hwtx){
 #if !defined(Q_OS_IOS)
-		m_ambedev->encode(pcm);
+		m_ambedev->encode(pcm, m_ambech);
 #endif
 	}
 	else{
@@ -621,7 +621,7 @@ void NXDN::get_ambe()
 #if !defined(Q_OS_IOS)
 	uint8_t ambe[7];
 
-	if(m_ambedev->get_ambe(ambe)){
+	if(m_ambedev->get_ambe(ambe, m_ambech)){
 		for(int i = 0; i < 7; ++i){
 			m_txcodecq.append(ambe[i]);
 		}
@@ -649,9 +649,9 @@ void NXDN::process_rx_data()
 		}
 		if(m_hwrx){
 #if !defined(Q_OS_IOS)
-			m_ambedev->decode(ambe);
+			m_ambedev->decode(ambe, m_ambech);
 
-			if(m_ambedev->get_audio(pcm)){
+			if(m_ambedev->get_audio(pcm, m_ambech)){
 				m_audio->write(pcm, 160);
 				emit update_output_level(m_audio->level());
 			}
@@ -41,6 +41,13 @@
 #define AMBE3000_PKT_READY		0x39
 #define AMBE3000_PKT_RESET		0x33
 #define AMBE3000_PKT_PARITYMODE	0x3f
+#define AMBE3000_PKT_CHANNEL0	0x40
+#define AMBE3000_PKT_SPCHD		0x00
+#define AMBE3000_PKT_CHAND		0x01
+
+#define AMBE3000_MAX_INFLIGHT		2		// default credits, one frame being processed and one buffered
+#define AMBE3000_RESPONSE_TIMEOUT	100		// ms, 5 frames
+#define AMBE3000_LATE_TIMEOUT		1000	// ms, a lost request still unanswered is taken as dropped by the chip
 
 const uint8_t AMBEP251_4400_2800[17] = {AMBE3000_START_BYTE, 0x00, 0x0d, AMBE3000_TYPE_CONFIG, AMBE3000_PKT_RATEP, 0x05U, 0x58U, 0x08U, 0x6BU, 0x10U, 0x30U, 0x00U, 0x00U, 0x00U, 0x00U, 0x01U, 0x90U};		//DVSI P25 USB Dongle FEC
 const uint8_t AMBE2000_2400_1200[17] = {AMBE3000_START_BYTE, 0x00, 0x0d, AMBE3000_TYPE_CONFIG, AMBE3000_PKT_RATEP, 0x01U, 0x30U, 0x07U, 0x63U, 0x40U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x48U};
@@ -53,15 +60,53 @@ const uint8_t AMBE3000_VERSION[5] = {AMBE3000_START_BYTE, 0x00, 0x01, AMBE3000_T
 //const uint8_t AMBE2020[48] = {0x13, 0xec, 0x00, 0x00, 0x10, 0x30, 0x00, 0x01, 0x00, 0x00, 0x42, 0x30, 0x00, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
 //const uint8_t AMBE2020[4] = {0x04, 0x20, 0x01, 0x00};
 const uint8_t AMBE2020[5] = {0x05, 0x00, 0x18, 0x00, 0x01};
+
+// Rate control packet and AMBE frame size of a protocol
+static const uint8_t *rate_3000(QString protocol, uint8_t *size)
+{
+	if(protocol == "DMR"){
+		*size = 9;
+		return AMBE3000_2450_1150;
+	}
+	else if( (protocol == "YSF") || (protocol == "NXDN") ){
+		*size = 7;
+		return AMBE3000_2450_0000;
+	}
+	else if(protocol == "P25"){
+		*size = 11;
+		return AMBEP251_4400_2800;
+	}
+	*size = 9; //D-Star
+	return AMBE2000_2400_1200;
+}
+
 SerialAMBE::SerialAMBE(QString protocol) :
+	m_serial(nullptr),
 	m_protocol(protocol),
-	m_decode_gain(1.0)
+	m_decode_gain(1.0),
+	m_channels(1),
+	m_max_inflight(AMBE3000_MAX_INFLIGHT),
+	m_stats(),
+	m_rxhead(0),
+	m_rxtail(0)
 {
+	for(int i = 0; i < AMBE3000_MAX_CHANNELS; ++i){
+		m_ch[i].packet_size = 9;
+		m_ch[i].late = 0;
+		m_ch[i].late_sent = 0;
+		m_ch[i].audio_head = 0;
+		m_ch[i].audio_count = 0;
+		m_ch[i].ambe_head = 0;
+		m_ch[i].ambe_count = 0;
+	}
+	m_clock.start();
 }
 
 SerialAMBE::~SerialAMBE()
 {
-	m_serial->close();
+	if(m_serial){
+		m_serial->close();
+	}
 }
 
 QMap<QString, QString> SerialAMBE::discover_devices()
@@ -101,7 +146,7 @@ void SerialAMBE::connect_to_serial(QString p)
 
 	if((m_protocol != "P25") && (m_protocol != "M17") && (p != "")){
 #ifndef Q_OS_ANDROID
-		m_serial = new QSerialPort;
+		m_serial = new QSerialPort(this);
 		QSerialPortInfo info(*m_serial);
 		QString out = "Port: " + info.portName() + ENDLINE
 			+ "Location: " + info.systemLocation() + ENDLINE
@@ -138,6 +183,7 @@ void SerialAMBE::connect_to_serial(QString p)
 		}
 		else{
 			qDebug() << "Error: Failed to open device.";
+			emit probed(1);
 		}
 	}
 }
@@ -163,28 +209,22 @@ void SerialAMBE::config_ambe()
         a.clear();
     }
 
-    if(m_protocol == "DMR"){
-        a.append(reinterpret_cast<const char*>(AMBE3000_2450_1150), sizeof(AMBE3000_2450_1150));
-        packet_size = 9;
-    }
-    else if( (m_protocol == "YSF") || (m_protocol == "NXDN") ){
-        a.append(reinterpret_cast<const char*>(AMBE3000_2450_0000), sizeof(AMBE3000_2450_0000));
-        packet_size = 7;
-    }
-    else if(m_protocol == "P25"){
-        a.append(reinterpret_cast<const char*>(AMBEP251_4400_2800), sizeof(AMBEP251_4400_2800));
-    }
-    else if(m_description != "DV Dongle"){ //D-Star with AMBE3000
-        a.append(reinterpret_cast<const char*>(AMBE2000_2400_1200), sizeof(AMBE2000_2400_1200));
-        packet_size = 9;
+    if(m_description != "DV Dongle"){
+        uint8_t size;
+        a.append(reinterpret_cast<const char*>(rate_3000(m_protocol, &size)), sizeof(AMBE3000_2450_1150));
+        QMutexLocker l(&m_lock);
+        m_ch[0].packet_size = size;
     }
     else{
         a.append(reinterpret_cast<const char*>(AMBE2020), sizeof(AMBE2020));
-        packet_size = 9;
+        QMutexLocker l(&m_lock);
+        m_ch[0].packet_size = 9;
+        l.unlock();
+        emit probed(1);
     }
     m_serial->write(a);
 #ifdef DEBUG
-    fprintf(stderr, "SENDHW %d:%d:", a.size(), m_serialdata.size());
+    fprintf(stderr, "SENDHW %d:%d:", a.size(), m_rxtail - m_rxhead);
     for(int i = 0; i < a.size(); ++i){
         //if((d.data()[i] == 0x61) && (data.data()[i+1] == 0x01) && (data.data()[i+2] == 0x42) && (data.data()[i+3] == 0x02)){
         //	i+= 6;
@@ -195,30 +235,41 @@ void SerialAMBE::config_ambe()
     fflush(stderr);
 #endif
     emit ambedev_ready();
+    emit channel_ready(0);
 }
 
-void SerialAMBE::receive_serial(QByteArray d)
+// Sets the rate of one channel of an open AMBE-3003, the channel field
+// goes in front of the rate control field of the channel 0 packet. Used
+// for channels 1 and 2, and for channel 0 when it changes holder.
+void SerialAMBE::config_channel(int ch, QString protocol)
 {
-	for(int i = 0; i < d.size(); i++){
-		m_serialdata.append(d[i]);
-	}
+	uint8_t size;
+	const uint8_t *rate = rate_3000(protocol, &size);
+	QByteArray a;
+
+	a.append((char)AMBE3000_START_BYTE);
+	a.append((char)0x00);
+	a.append((char)(rate[2] + 1));
+	a.append((char)AMBE3000_TYPE_CONFIG);
+	a.append((char)(AMBE3000_PKT_CHANNEL0 + ch));
+	a.append(reinterpret_cast<const char*>(rate + 4), rate[2]);
+	m_serial->write(a);
+	m_lock.lock();
+	m_ch[ch].packet_size = size;
+	m_lock.unlock();
+	emit channel_ready(ch);
+}
 
-	if(m_description == "DV Dongle"){
-		process_serial_2020();
-	}
-	else{
-		process_serial_3000();
-	}
+void SerialAMBE::receive_serial(QByteArray d)
+{
+	buffer_serial(d.constData(), d.size());
 }
 
 void SerialAMBE::process_serial()
 {
 	QByteArray d = m_serial->readAll();
-	for(int i = 0; i < d.size(); i++){
-		m_serialdata.append(d[i]);
-	}
 #ifdef DEBUG
-	fprintf(stderr, "AMBEHW %d:%d:", d.size(), m_serialdata.size());
+	fprintf(stderr, "AMBEHW %d:%d:", d.size(), m_rxtail - m_rxhead);
 	for(int i = 0; i < d.size(); ++i){
 		//if((d.data()[i] == 0x61) && (data.data()[i+1] == 0x01) && (data.data()[i+2] == 0x42) && (data.data()[i+3] == 0x02)){
 		//	i+= 6;
@@ -228,33 +279,80 @@ void SerialAMBE::process_serial()
 	fprintf(stderr, "\n");
 	fflush(stderr);
 #endif
+	buffer_serial(d.constData(), d.size());
+}
 
-	if(m_description == "DV Dongle"){
-		process_serial_2020();
-	}
-	else{
-		process_serial_3000();
+// Copies received bytes into the ring, at most two memcpy per pass, and
+// parses after every pass. The AMBE3000 parser consumes all complete
+// packets, so the ring only ever holds one partial packet and nothing is
+// dropped. The DV Dongle data is not consumed, once the ring is full the
+// rest is discarded.
+void SerialAMBE::buffer_serial(const char *d, int len)
+{
+	while(len){
+		uint32_t t = m_rxtail & (AMBE3000_RX_RING - 1);
+		uint32_t n = qMin((uint32_t)len, AMBE3000_RX_RING - (m_rxtail - m_rxhead));
+		uint32_t n1 = qMin(n, AMBE3000_RX_RING - t);
+
+		if(!n){
+			break;
+		}
+		memcpy(m_rxring + t, d, n1);
+		memcpy(m_rxring, d + n1, n - n1);
+		m_rxtail += n;
+		d += n;
+		len -= n;
+
+		if(m_description == "DV Dongle"){
+			process_serial_2020();
+		}
+		else{
+			process_serial_3000();
+		}
 	}
 }
 
-void SerialAMBE::decode(uint8_t *ambe)
+// decode() and encode() may be called from the thread of any mode, the
+// frame is copied and handed to the thread that owns the serial port.
+// Called from that thread, as by the bench, the frame is sent right away.
+void SerialAMBE::decode(uint8_t *ambe, int ch)
+{
+	m_lock.lock();
+	QByteArray a((const char *)ambe, m_ch[ch].packet_size);
+	m_lock.unlock();
+	QMetaObject::invokeMethod(this, "decode_frame", Q_ARG(QByteArray, a), Q_ARG(int, ch));
+}
+
+void SerialAMBE::encode(int16_t *audio, int ch)
+{
+	QByteArray a((const char *)audio, 160 * sizeof(int16_t));
+	QMetaObject::invokeMethod(this, "encode_frame", Q_ARG(QByteArray, a), Q_ARG(int, ch));
+}
+
+void SerialAMBE::decode_frame(QByteArray a, int ch)
 {
 	if(m_description == "DV Dongle"){
-		decode_2020(ambe);
+		decode_2020((uint8_t *)a.data());
 	}
 	else{
-		decode_3000(ambe);
+		decode_3000((uint8_t *)a.data(), ch);
 	}
 }
 
-void SerialAMBE::encode(int16_t *audio)
+void SerialAMBE::encode_frame(QByteArray a, int ch)
 {
-	uint8_t packet[327] = {AMBE3000_START_BYTE, 0x01, 0x43, AMBE3000_TYPE_SPEECH, 0x40, 0x00, 0xa0};
+	const int16_t *audio = (const int16_t *)a.constData();
+	uint8_t packet[327] = {AMBE3000_START_BYTE, 0x01, 0x43, AMBE3000_TYPE_SPEECH, (uint8_t)(AMBE3000_PKT_CHANNEL0 + ch), AMBE3000_PKT_SPCHD, 0xa0};
 	for(int i = 0; i < 160; ++i){
 		packet [(i*2)+7] = (audio[i] >> 8) & 0xff;
 		packet [(i*2)+8] = audio[i] & 0xff;
 	}
-	m_serial->write((char *)packet, 327);
+	if(m_description == "DV Dongle"){
+		m_serial->write((char *)packet, 327);
+	}
+	else{
+		submit_3000(ch, packet, 327, AMBE3000_TYPE_CHANNEL);
+	}
 #ifdef DEBUG
 			fprintf(stderr, "SENDHW: ");
 			for(int i = 0; i < 326; ++i){
@@ -275,58 +373,179 @@ void SerialAMBE::decode_2020(uint8_t *ambe)
 	memset(pcm, 0, 322);
 	pcm[0] = 0x42;
 	pcm[1] = 0x81;
-	memcpy(packet+24, ambe, packet_size);
+	memcpy(packet+24, ambe, m_ch[0].packet_size);
 	m_serial->write((char *)packet, 50);
 	m_serial->write((char *)pcm, 322);
 }
 
-void SerialAMBE::decode_3000(uint8_t *ambe)
+void SerialAMBE::decode_3000(uint8_t *ambe, int ch)
 {
-	uint8_t packet[15] = {AMBE3000_START_BYTE, 0x00, 0x0b, AMBE3000_TYPE_CHANNEL, 0x01, 0x48};
-	if( packet_size == 7 ){
-		packet[2] = 0x09;
-		packet[5] = 0x31;
+	uint8_t packet[AMBE3000_MAX_FRAME + 7] = {AMBE3000_START_BYTE, 0x00, 0x0b, AMBE3000_TYPE_CHANNEL};	// header, channel, CHAND, bit count
+	uint8_t size = m_ch[ch].packet_size;
+	int n = 4;
+
+	// The channel field is only needed to address more than one channel
+	if(get_channels() > 1){
+		packet[n++] = AMBE3000_PKT_CHANNEL0 + ch;
+	}
+	packet[n++] = AMBE3000_PKT_CHAND;
+	packet[n++] = size * 8;
+	if( size == 7 ){
+		packet[n-1] = 0x31;
+	}
+	memcpy(packet+n, ambe, size);
+	n += size;
+	packet[2] = n - 4;
+
+	submit_3000(ch, packet, n, AMBE3000_TYPE_SPEECH);
+}
+
+// Speech and channel packets are pipelined: up to m_max_inflight requests
+// per channel are outstanding on the chip, each answered in order by one
+// packet of the opposite type. Further requests wait in the channel's
+// pending queue for a credit, which is returned when process_serial_3000()
+// sees the answer arrive.
+void SerialAMBE::submit_3000(int ch, const uint8_t *packet, int len, uint8_t response)
+{
+	QMutexLocker l(&m_lock);
+	AMBEChannel &c = m_ch[ch];
+	qint64 now = m_clock.nsecsElapsed();
+
+	while(c.inflight.size() && ((now - c.inflight.head().sent) > (AMBE3000_RESPONSE_TIMEOUT * 1000000LL))){
+		c.late_sent = c.inflight.dequeue().sent;
+		c.late++;
+		m_stats.lost++;
+	}
+
+	if(c.pending.size() >= AMBE3000_MAX_QUEUED){
+		c.pending.dequeue();
+		m_stats.dropped++;
+	}
+
+	AMBERequest r;
+	r.packet = QByteArray((const char *)packet, len);
+	r.response = response;
+	r.sent = 0;
+	c.pending.enqueue(r);
+	m_stats.max_queued = qMax(m_stats.max_queued, (int)c.pending.size());
+	send_pending_3000(ch);
+}
+
+void SerialAMBE::send_pending_3000(int ch)
+{
+	AMBEChannel &c = m_ch[ch];
+
+	while(c.pending.size() && ((int)c.inflight.size() < m_max_inflight)){
+		AMBERequest r = c.pending.dequeue();
+		m_serial->write(r.packet);
+		r.sent = m_clock.nsecsElapsed();
+		c.inflight.enqueue(r);
 	}
-	memcpy(packet+6, ambe, packet_size);
+}
 
-	m_serial->write((char *)packet, (6 + packet_size));
+AMBEPipelineStats SerialAMBE::get_pipeline_stats()
+{
+	QMutexLocker l(&m_lock);
+	m_stats.inflight = 0;
+	m_stats.queued = 0;
+	for(int i = 0; i < AMBE3000_MAX_CHANNELS; ++i){
+		m_stats.inflight += m_ch[i].inflight.size();
+		m_stats.queued += m_ch[i].pending.size();
+	}
+	return m_stats;
 }
 
 void SerialAMBE::process_serial_2020()
 {
-	if( (m_serialdata.size() > 321) &&
-		((uint8_t)m_serialdata[0] == 0x42) &&
-		((uint8_t)m_serialdata[1] == 0x81)
+	if( ((m_rxtail - m_rxhead) > 321) &&
+		(rx_peek(0) == 0x42) &&
+		(rx_peek(1) == 0x81)
 		)
 	{
 		emit data_ready();
 	}
-	if( (m_serialdata.size() > 49) &&
-		((uint8_t)m_serialdata[0] == 0x32) &&
-		((uint8_t)m_serialdata[1] == 0xa0) &&
-		((uint8_t)m_serialdata[0] == 0xec) &&
-		((uint8_t)m_serialdata[1] == 0x13)
+	if( ((m_rxtail - m_rxhead) > 49) &&
+		(rx_peek(0) == 0x32) &&
+		(rx_peek(1) == 0xa0) &&
+		(rx_peek(0) == 0xec) &&
+		(rx_peek(1) == 0x13)
 		)
 	{
 		emit data_ready();
 	}
 }
 
+// Scans the ring for whole packets and hands each one to dispatch_3000().
+// A header is a start byte, a length no longer than the largest packet
+// and a known type. Anything else is skipped a byte at a time until the
+// next start byte.
 void SerialAMBE::process_serial_3000()
 {
-	if(m_serialdata.size() < 3){
-		return;
+	for(;;){
+		uint32_t n = m_rxtail - m_rxhead;
+
+		uint32_t skip = 0;
+		while(n && (rx_peek(0) != AMBE3000_START_BYTE)){
+			m_rxhead++;
+			skip++;
+			n--;
+		}
+		if(skip){
+			QMutexLocker l(&m_lock);
+			m_stats.resyncs += skip;
+		}
+		if(n < 4){
+			return;
+		}
+
+		uint32_t len = 4 + ((rx_peek(1) << 8) | rx_peek(2));
+		if((len > AMBE3000_MAX_PACKET) || (rx_peek(3) > AMBE3000_TYPE_SPEECH)){
+			m_rxhead++;
+			m_lock.lock();
+			m_stats.resyncs++;
+			m_lock.unlock();
+			continue;
+		}
+		if(n < len){
+			return;
+		}
+
+		uint32_t h = m_rxhead & (AMBE3000_RX_RING - 1);
+		const uint8_t *p = m_rxring + h;
+		if((h + len) > AMBE3000_RX_RING){
+			uint32_t n1 = AMBE3000_RX_RING - h;
+			memcpy(m_rxpkt, p, n1);
+			memcpy(m_rxpkt + n1, m_rxring, len - n1);
+			p = m_rxpkt;
+		}
+		dispatch_3000(p, len);
+		m_rxhead += len;
 	}
+}
 
-	while( (m_serialdata.size() > 3) &&
-		   (m_serialdata[0] == AMBE3000_START_BYTE) &&
-		   (m_serialdata[3] == 0x00) &&
-		   (m_serialdata.size() >= m_serialdata[2])
+void SerialAMBE::dispatch_3000(const uint8_t *p, int len)
+{
+	uint8_t type = p[3];
+	int off = 4;
+	int ch = 0;
+	int channels;
+
+	// Answers to packets with a channel field carry one as well
+	if( (len > off) &&
+		(p[off] >= AMBE3000_PKT_CHANNEL0) &&
+		(p[off] < (AMBE3000_PKT_CHANNEL0 + AMBE3000_MAX_CHANNELS))
 		)
 	{
-		switch(m_serialdata[4]){
+		ch = p[off++] - AMBE3000_PKT_CHANNEL0;
+	}
+
+	if(type == AMBE3000_TYPE_CONFIG){
+		if(len < (off + 2)){
+			return;
+		}
+		switch(p[off]){
 		case AMBE3000_PKT_PARITYMODE:
-			if(!m_serialdata[5]){
+			if(!p[off+1]){
 				qDebug() << "AMBE3000 Parity disabled";
 			}
 			else{
@@ -336,151 +555,156 @@ void SerialAMBE::process_serial_3000()
 		case AMBE3000_PKT_PRODID:
 			m_ambeprodid.clear();
 
-			for(int i = 0; i < (m_serialdata[2] - 2); ++i){
-				m_ambeprodid.append(m_serialdata[5+i]);
+			for(int i = off + 1; i < (len - 1); ++i){
+				m_ambeprodid.append((char)p[i]);
 			}
 
+			m_lock.lock();
+			if(m_ambeprodid.startsWith("AMBE3003")){
+				m_channels = AMBE3000_MAX_CHANNELS;
+			}
+			channels = m_channels;
+			m_lock.unlock();
 			qDebug() << "PRODID == " << m_ambeprodid;
+			emit probed(channels);
 			break;
 		case AMBE3000_PKT_VERSTRING:
 			m_ambeverstring.clear();
 
-			for(int i = 0; i < (m_serialdata[2] - 2); ++i){
-				m_ambeverstring.append(m_serialdata[5+i]);
+			for(int i = off + 1; i < (len - 1); ++i){
+				m_ambeverstring.append((char)p[i]);
 			}
 
 			qDebug() << "VERSTRING == " << m_ambeverstring;
 			break;
 		case AMBE3000_PKT_RATEP:
-			if(!m_serialdata[5]){
+			if(!p[off+1]){
 				qDebug() << "AMBE3000 Rate set";
-				emit connected(true);
+				emit connected(true, ch);
 			}
 			else{
 				qDebug() << "ERROR: AMBE3000 Rate not set";
-				emit connected(false);
+				emit connected(false, ch);
 			}
 			break;
 		default:
 			break;
 		}
+		return;
+	}
 
-		do {
-			m_serialdata.dequeue();
-		}
-		while(m_serialdata.size() && m_serialdata[0] != AMBE3000_START_BYTE);
+	if((type != AMBE3000_TYPE_SPEECH) && (type != AMBE3000_TYPE_CHANNEL)){
+		return;
 	}
 
-	if( (m_serialdata.size() >= (6 + packet_size)) &&
-		(m_serialdata[0] == AMBE3000_START_BYTE) &&
-		(m_serialdata[3] == AMBE3000_TYPE_CHANNEL)
-		)
-	{
-		emit data_ready();
+	QMutexLocker l(&m_lock);
+	AMBEChannel &c = m_ch[ch];
+
+	// The chip answers in order, so the answers to requests reclaimed by
+	// submit_3000() come first. They belong to no frame still waiting and
+	// are dropped, unless so long has passed that the chip lost them.
+	if(c.late && ((m_clock.nsecsElapsed() - c.late_sent) > (AMBE3000_LATE_TIMEOUT * 1000000LL))){
+		c.late = 0;
+	}
+	if(c.late){
+		c.late--;
+		m_stats.late++;
+		return;
 	}
-}
 
-bool SerialAMBE::get_ambe(uint8_t *ambe)
-{
-	bool r = false;
-	if(m_serialdata.isEmpty()){
-		return r;
+	while(c.inflight.size() && (c.inflight.head().response != type)){
+		c.inflight.dequeue();
+		m_stats.lost++;
+	}
+	if(c.inflight.size()){
+		qint64 lat = (m_clock.nsecsElapsed() - c.inflight.dequeue().sent) / 1000;
+		m_stats.latency_us = lat;
+		m_stats.max_latency_us = qMax(m_stats.max_latency_us, lat);
+		m_stats.completed++;
 	}
+	send_pending_3000(ch);
 
-	if( (m_serialdata.size() > 3) &&
-		(m_serialdata[0] == AMBE3000_START_BYTE) &&
-		(m_serialdata[3] != AMBE3000_TYPE_CHANNEL)
+	if( (type == AMBE3000_TYPE_SPEECH) &&
+		(len >= (off + 2 + 320)) &&
+		(p[off] == AMBE3000_PKT_SPCHD)
 		)
 	{
-		do {
-			m_serialdata.dequeue();
+		const uint8_t *d = p + off + 2;
+
+		if(c.audio_count == AMBE3000_MAX_QUEUED){
+			c.audio_head = (c.audio_head + 1) % AMBE3000_MAX_QUEUED;
+			c.audio_count--;
+		}
+		int16_t *audio = c.audio[(c.audio_head + c.audio_count++) % AMBE3000_MAX_QUEUED];
+		for(int i = 0; i < 160; i++){
+			//Byte swap BE to LE
+			audio[i] = (d[i*2] << 8) | d[(i*2)+1];
 		}
-		while(m_serialdata.size() && m_serialdata[0] != AMBE3000_START_BYTE);
 	}
-
-	if( (m_serialdata.size() >= (6 + packet_size)) &&
-		(m_serialdata[0] == AMBE3000_START_BYTE) &&
-		(m_serialdata[3] == AMBE3000_TYPE_CHANNEL)
+	else if( (type == AMBE3000_TYPE_CHANNEL) &&
+		(len >= (off + 2 + c.packet_size)) &&
+		(p[off] == AMBE3000_PKT_CHAND)
 		)
 	{
-		for(int i = 0; i < 6; ++i){
-			m_serialdata.dequeue();
-		}
-		for(int i = 0; i < packet_size; i++){
-			ambe[i] = m_serialdata.dequeue();
+		if(c.ambe_count == AMBE3000_MAX_QUEUED){
+			c.ambe_head = (c.ambe_head + 1) % AMBE3000_MAX_QUEUED;
+			c.ambe_count--;
 		}
-		r = true;
+		memcpy(c.ambe[(c.ambe_head + c.ambe_count++) % AMBE3000_MAX_QUEUED], p + off + 2, c.packet_size);
+		// Unlocked first, a direct connection may call get_ambe()
+		l.unlock();
+		emit data_ready();
 	}
-	return r;
 }
 
-bool SerialAMBE::get_audio(int16_t *audio)
+bool SerialAMBE::get_ambe(uint8_t *ambe, int ch)
 {
-	bool r = false;
-	if(m_serialdata.isEmpty()){
-		return r;
-	}
-	uint8_t header[] = {AMBE3000_START_BYTE, 0x01, 0x42, AMBE3000_TYPE_SPEECH, 0x00, 0xA0};
-/*
-	if( (m_serialdata.size() > 3) &&
-		(m_serialdata[0] == 0x61) &&
-		(m_serialdata[3] != 0x02)
-		)
-	{
-		do {
-			m_serialdata.dequeue();
-		}
-		while(m_serialdata.size() && m_serialdata[0] != 0x61);
+	QMutexLocker l(&m_lock);
+	AMBEChannel &c = m_ch[ch];
+
+	if(!c.ambe_count){
+		return false;
 	}
 
-	//qDebug() << "get_audio() m_serialdata.size() == " << m_serialdata.size();
+	memcpy(ambe, c.ambe[c.ambe_head], c.packet_size);
+	c.ambe_head = (c.ambe_head + 1) % AMBE3000_MAX_QUEUED;
+	c.ambe_count--;
+	return true;
+}
 
-	fprintf(stderr, "AMBEHW %d:%d:", m_serialdata.size(), m_serialdata.size());
-	for(int i = 0; i < m_serialdata.size(); ++i){
-		//if((d.data()[i] == 0x61) && (data.data()[i+1] == 0x01) && (data.data()[i+2] == 0x42) && (data.data()[i+3] == 0x02)){
-		//	i+= 6;
-		//}
-		fprintf(stderr, "%02x ", (unsigned char)m_serialdata[i]);
+bool SerialAMBE::get_audio(int16_t *audio, int ch)
+{
+	QMutexLocker l(&m_lock);
+	AMBEChannel &c = m_ch[ch];
+
+	if(!c.audio_count){
+		return false;
 	}
-	fprintf(stderr, "\n");
-	fflush(stderr);
-*/
-	if(m_serialdata.size() >= 326){
-		if ( ((uint8_t)m_serialdata[0] == header[0]) &&
-			 ((uint8_t)m_serialdata[1] == header[1]) &&
-			 ((uint8_t)m_serialdata[2] == header[2]) &&
-			 ((uint8_t)m_serialdata[3] == header[3]) &&
-			 ((uint8_t)m_serialdata[4] == header[4]) &&
-			 ((uint8_t)m_serialdata[5] == header[5])){
-			m_serialdata.dequeue();
-			m_serialdata.dequeue();
-			m_serialdata.dequeue();
-			m_serialdata.dequeue();
-			m_serialdata.dequeue();
-			m_serialdata.dequeue();
-			for(int i = 0; i < 160; i++){
-				//Byte swap BE to LE
-				audio[i] =  ((m_serialdata.dequeue() << 8) & 0xff00) | (m_serialdata.dequeue() & 0xff);
-				audio[i] = (qreal)audio[i] * m_decode_gain;
-			}
-			r = true;
-		}
-		else{
-			while( (m_serialdata.size() > 5) && (
-				((uint8_t)m_serialdata[0] != header[0]) ||
-				((uint8_t)m_serialdata[1] != header[1]) ||
-				((uint8_t)m_serialdata[2] != header[2]) ||
-				((uint8_t)m_serialdata[3] != header[3]) ||
-				((uint8_t)m_serialdata[4] != header[4]) ||
-				((uint8_t)m_serialdata[5] != header[5]))){
-					m_serialdata.dequeue();
-			}
-		}
+
+	for(int i = 0; i < 160; i++){
+		audio[i] = (qreal)c.audio[c.audio_head][i] * m_decode_gain;
 	}
-	return r;
+	c.audio_head = (c.audio_head + 1) % AMBE3000_MAX_QUEUED;
+	c.audio_count--;
+	return true;
 }
 
-void SerialAMBE::clear_queue()
+// The answers are dropped right away, the requests not yet sent and the
+// DV Dongle receive buffer by the thread that owns the serial port.
+void SerialAMBE::clear_queue(int ch)
 {
-	m_serialdata.clear();
+	m_lock.lock();
+	m_ch[ch].audio_count = 0;
+	m_ch[ch].ambe_count = 0;
+	m_lock.unlock();
+	QMetaObject::invokeMethod(this, "clear_pending", Q_ARG(int, ch));
+}
+
+void SerialAMBE::clear_pending(int ch)
+{
+	if(m_description == "DV Dongle"){
+		m_rxhead = m_rxtail;
+	}
+	QMutexLocker l(&m_lock);
+	m_ch[ch].pending.clear();
 }
@@ -24,6 +24,27 @@
 #include "androidserialport.h"
 #endif
 #include <QQueue>
+#include <QElapsedTimer>
+#include <QMutex>
+
+#define AMBE3000_MAX_CHANNELS	3
+#define AMBE3000_MAX_QUEUED		16
+#define AMBE3000_MAX_PACKET		400		// largest packet is speech with a channel field, 327 bytes
+#define AMBE3000_MAX_FRAME		11		// largest AMBE frame, P25 full rate
+#define AMBE3000_RX_RING		1024	// power of 2, more than two of the largest packets
+
+struct AMBEPipelineStats {
+	int inflight;			// requests sent and not yet answered
+	int queued;				// requests waiting for a credit
+	int max_queued;
+	quint32 completed;
+	quint32 lost;			// no response within AMBE3000_RESPONSE_TIMEOUT
+	quint32 late;			// responses to lost requests, discarded
+	quint32 dropped;		// discarded from a full request queue
+	qint64 latency_us;		// request to response time of the last frame
+	qint64 max_latency_us;
+	quint32 resyncs;		// bytes skipped looking for a packet header
+};
 
 class SerialAMBE : public QObject
 {
@@ -32,20 +53,28 @@ public:
 	SerialAMBE(QString);
 	~SerialAMBE();
 	static QMap<QString, QString>  discover_devices();
-	void connect_to_serial(QString);
 	QString get_ambe_description(){ return m_description; }
 	QString get_ambe_prodid(){ return m_ambeprodid; }
 	QString get_ambe_verstring(){ return m_ambeverstring; }
-	bool get_audio(int16_t *);
-	bool get_ambe(uint8_t *ambe);
-	void decode(uint8_t *);
-	void encode(int16_t *);
-	void clear_queue();//{ m_serialdata.clear(); }
-	void set_decode_gain(qreal g){ m_decode_gain = g; }
+	int get_channels(){ QMutexLocker l(&m_lock); return m_channels; }
+	bool get_audio(int16_t *, int ch = 0);
+	bool get_ambe(uint8_t *ambe, int ch = 0);
+	void decode(uint8_t *, int ch = 0);
+	void encode(int16_t *, int ch = 0);
+	void clear_queue(int ch = 0);
+	void set_decode_gain(qreal g){ QMutexLocker l(&m_lock); m_decode_gain = g; }
+	void set_max_inflight(int n){ QMutexLocker l(&m_lock); m_max_inflight = qMax(1, n); }
+	AMBEPipelineStats get_pipeline_stats();
+public slots:
+	void connect_to_serial(QString);
+	void config_channel(int, QString);
 private slots:
 	void process_serial();
 	void receive_serial(QByteArray);
     void config_ambe();
+	void decode_frame(QByteArray, int);
+	void encode_frame(QByteArray, int);
+	void clear_pending(int);
 private:
 #ifndef Q_OS_ANDROID
 	QSerialPort *m_serial;
@@ -58,19 +87,52 @@ private:
 	QString m_protocol;
 	QString m_ambeverstring;
 	QString m_ambeprodid;
-	uint8_t packet_size;
 	qreal m_decode_gain;
-	QQueue<char> m_serialdata;
+	struct AMBERequest {
+		QByteArray packet;
+		uint8_t response;	// packet type the chip answers with
+		qint64 sent;
+	};
+	struct AMBEChannel {
+		uint8_t packet_size;
+		QQueue<AMBERequest> inflight;
+		QQueue<AMBERequest> pending;
+		int late;		// lost requests whose answer may still arrive
+		qint64 late_sent;	// when the last of them was sent
+		int16_t audio[AMBE3000_MAX_QUEUED][160];	// answers waiting for get_audio()
+		uint8_t ambe[AMBE3000_MAX_QUEUED][AMBE3000_MAX_FRAME];	// answers waiting for get_ambe()
+		int audio_head;
+		int audio_count;
+		int ambe_head;
+		int ambe_count;
+	};
+	AMBEChannel m_ch[AMBE3000_MAX_CHANNELS];
+	QMutex m_lock;		// m_ch, m_stats and m_channels, shared with the threads of the modes
+	int m_channels;
+	int m_max_inflight;
+	QElapsedTimer m_clock;
+	AMBEPipelineStats m_stats;
+	uint8_t m_rxring[AMBE3000_RX_RING];
+	uint32_t m_rxhead;		// free running read and write counts
+	uint32_t m_rxtail;
+	uint8_t m_rxpkt[AMBE3000_MAX_PACKET];	// packets wrapping the end of the ring are copied here
+	uint8_t rx_peek(uint32_t i){ return m_rxring[(m_rxhead + i) & (AMBE3000_RX_RING - 1)]; }
+	void buffer_serial(const char *, int);
 	void decode_2020(uint8_t *);
 	void encode_2020(int16_t *);
-	void decode_3000(uint8_t *);
+	void decode_3000(uint8_t *, int);
 	void encode_3000(int16_t *);
 	void process_serial_2020();
 	void process_serial_3000();
+	void dispatch_3000(const uint8_t *, int);
+	void submit_3000(int, const uint8_t *, int, uint8_t);
+	void send_pending_3000(int);
 signals:
-	void connected(bool);
+	void connected(bool, int);	// rate answer of a channel
 	void data_ready();
     void ambedev_ready();
+	void channel_ready(int);
+	void probed(int);	// number of channels, once known or the port failed
 };
 
 #endif // SERIALAMBE_H
@@ -0,0 +1,164 @@
+/*
+	Copyright (C) 2019-2021 Doug McLain
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <QDebug>
+#include "vocoderpool.h"
+
+// ports is a comma separated list of vocoder ports. A port not yet in use
+// is opened and channel 0 of it returned. Otherwise the first free channel
+// of an already open device is returned, once the device has answered the
+// product id request that tells how many channels it has. Returns nullptr
+// when every channel of every listed port is taken.
+SerialAMBE * VocoderPool::acquire(QString ports, QString protocol, int *ch)
+{
+	QMutexLocker lock(&m_mutex);
+	QStringList l = ports.split(',');
+
+	for(int i = 0; i < l.size(); ++i){
+		QString port = l.at(i).trimmed();
+		int d;
+
+		if(port.isEmpty()){
+			continue;
+		}
+
+		d = find(port);
+
+		if(d < 0){
+			Device n;
+			n.port = port;
+			n.ambe = new SerialAMBE(protocol);
+			n.ambe->moveToThread(&m_thread);
+			n.protocol[0] = protocol;
+			n.used = 1;
+			n.open = false;
+			n.probed = false;
+			n.channels = 1;
+			m_devices.append(n);
+			// Runs in the thread of the device, which never holds m_mutex
+			// while waiting on anything of the modes
+			SerialAMBE *ambe = n.ambe;
+			connect(ambe, &SerialAMBE::probed, this, [this, ambe](int c){
+				QMutexLocker lock(&m_mutex);
+				int d = find(ambe);
+				if(d >= 0){
+					m_devices[d].channels = c;
+					m_devices[d].probed = true;
+					m_probed.wakeAll();
+				}
+			}, Qt::DirectConnection);
+			*ch = 0;
+			qDebug() << "VocoderPool: opening" << port;
+			return n.ambe;
+		}
+
+		// The port is only opened once the first holder calls start(),
+		// which takes m_mutex, so the channel count is waited for with it
+		// released. The device may be released meanwhile, it is looked up
+		// again after each wait.
+		QElapsedTimer t;
+		t.start();
+		while(!m_devices.at(d).probed){
+			qint64 left = VOCODERPOOL_PROBE_TIMEOUT - t.elapsed();
+			if(left <= 0){
+				break;
+			}
+			m_probed.wait(&m_mutex, left);
+			d = find(port);
+			if(d < 0){
+				break;
+			}
+		}
+		if(d < 0){
+			--i;	// closed while waiting, open it again
+			continue;
+		}
+
+		Device &dev = m_devices[d];
+		for(int c = 0; c < dev.channels; ++c){
+			if(!(dev.used & (1 << c))){
+				dev.used |= (1 << c);
+				dev.protocol[c] = protocol;
+				*ch = c;
+				qDebug() << "VocoderPool: sharing" << port << "channel" << c;
+				return dev.ambe;
+			}
+		}
+	}
+	return nullptr;
+}
+
+// Called once the caller has connected to the device signals, as
+// channel_ready() may be emitted from here. The port is opened by the
+// first holder only, every later holder of a channel, channel 0 of a
+// device whose first holder has gone included, sets its rate with a
+// rate packet of its own. Both run in the thread of the device.
+void VocoderPool::start(SerialAMBE *ambe, int ch)
+{
+	QMutexLocker lock(&m_mutex);
+	int d = find(ambe);
+
+	if(d < 0){
+		return;
+	}
+	Device &dev = m_devices[d];
+	if(!dev.open){
+		dev.open = true;
+		QMetaObject::invokeMethod(ambe, "connect_to_serial", Qt::QueuedConnection, Q_ARG(QString, dev.port));
+	}
+	else{
+		QMetaObject::invokeMethod(ambe, "config_channel", Qt::QueuedConnection, Q_ARG(int, ch), Q_ARG(QString, dev.protocol[ch]));
+	}
+}
+
+void VocoderPool::release(SerialAMBE *ambe, int ch)
+{
+	QMutexLocker lock(&m_mutex);
+	int d = find(ambe);
+
+	if(d < 0){
+		return;
+	}
+	m_devices[d].used &= ~(1 << ch);
+	ambe->clear_queue(ch);
+
+	if(!m_devices.at(d).used){
+		qDebug() << "VocoderPool: closing" << m_devices.at(d).port;
+		m_devices.removeAt(d);
+		ambe->deleteLater();
+	}
+}
+
+int VocoderPool::find(SerialAMBE *ambe)
+{
+	for(int i = 0; i < m_devices.size(); ++i){
+		if(m_devices.at(i).ambe == ambe){
+			return i;
+		}
+	}
+	return -1;
+}
+
+int VocoderPool::find(QString port)
+{
+	for(int i = 0; i < m_devices.size(); ++i){
+		if(m_devices.at(i).port == port){
+			return i;
+		}
+	}
+	return -1;
+}
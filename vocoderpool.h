@@ -0,0 +1,67 @@
+/*
+	Copyright (C) 2019-2021 Doug McLain
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef VOCODERPOOL_H
+#define VOCODERPOOL_H
+
+#include <QObject>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include "serialambe.h"
+
+#define VOCODERPOOL_PROBE_TIMEOUT	2000	// ms, for the product id answer of a newly opened device
+
+// Shares the hardware vocoders between modes. Each serial port is opened
+// once and its channels (three on an AMBE-3003, one otherwise) are handed
+// out to modes, each configured for the rate of the mode that holds it.
+// The modes run in threads of their own, so the pool is locked and every
+// device lives in one thread of the pool, which does all of the serial I/O.
+class VocoderPool : public QObject
+{
+	Q_OBJECT
+public:
+	static VocoderPool & GetInstance()
+	{
+		static VocoderPool instance;
+		return instance;
+	}
+	SerialAMBE * acquire(QString ports, QString protocol, int *ch);
+	void start(SerialAMBE *, int ch);
+	void release(SerialAMBE *, int ch);
+private:
+	VocoderPool(){ m_thread.start(); }
+	~VocoderPool(){ m_thread.quit(); m_thread.wait(); }
+	struct Device {
+		QString port;
+		SerialAMBE *ambe;
+		QString protocol[AMBE3000_MAX_CHANNELS];
+		uint8_t used;	// bit per channel
+		bool open;		// connect_to_serial() has been called
+		bool probed;	// channels is known
+		int channels;
+	};
+	QList<Device> m_devices;
+	QMutex m_mutex;
+	QWaitCondition m_probed;	// signalled with m_mutex when a device is probed
+	QThread m_thread;
+	int find(SerialAMBE *);
+	int find(QString port);
+};
+
+#endif // VOCODERPOOL_H
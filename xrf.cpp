@@ -385,7 +385,7 @@ void XRF::transmit()
 	}
 	if(m_hwtx){
 #if !defined(Q_OS_IOS)
-		m_ambedev->encode(pcm);
+		m_ambedev->encode(pcm, m_ambech);
 #endif
 		if(m_tx && (m_txcodecq.size() >= 9)){
 			for(int i = 0; i < 9; ++i){
@@ -564,7 +564,7 @@ void XRF::get_ambe()
 #if !defined(Q_OS_IOS)
 	uint8_t ambe[9];
 
-	if(m_ambedev->get_ambe(ambe)){
+	if(m_ambedev->get_ambe(ambe, m_ambech)){
 		for(int i = 0; i < 9; ++i){
 			m_txcodecq.append(ambe[i]);
 		}
@@ -605,9 +605,9 @@ void XRF::process_rx_data()
 		}
 		if(m_hwrx){
 #if !defined(Q_OS_IOS)
-			m_ambedev->decode(ambe);
+			m_ambedev->decode(ambe, m_ambech);
 
-			if(m_ambedev->get_audio(pcm)){
+			if(m_ambedev->get_audio(pcm, m_ambech)){
 				m_audio->write(pcm, 160);
 				emit update_output_level(m_audio->level());
 			}
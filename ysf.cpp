@@ -743,7 +743,7 @@ void YSF::transmit()
 	}
 	if(m_hwtx && !m_txfullrate){
 #if !defined(Q_OS_IOS)
-		m_ambedev->encode(pcm);
+		m_ambedev->encode(pcm, m_ambech);
 #endif
 	}
 	else{
@@ -999,23 +999,16 @@ void YSF::encode_imbe(uint8_t* data, const uint8_t* imbe)
 	}
 	bit += 23U;
 
-	// c4
-	for (uint32_t i = 0U; i < 11U; i++)
-		bit[i] = READ_BIT(imbe, i + 48U);
-	CHamming::encode15113_1(bit);
-	bit += 15U;
-
-	// c5
-	for (uint32_t i = 0U; i < 11U; i++)
-		bit[i] = READ_BIT(imbe, i + 59U);
-	CHamming::encode15113_1(bit);
-	bit += 15U;
-
-	// c6
-	for (uint32_t i = 0U; i < 11U; i++)
-		bit[i] = READ_BIT(imbe, i + 70U);
-	CHamming::encode15113_1(bit);
-	bit += 15U;
+	// c4, c5 and c6, Hamming (15,11,3) encoded together
+	uint16_t c4[3U] = {0U, 0U, 0U};
+	for (uint32_t i = 0U; i < 33U; i++) {
+		bool b = READ_BIT(imbe, i + 48U);
+		c4[i / 11U] = (c4[i / 11U] << 1) | (b ? 0x01U : 0x00U);
+	}
+	CHamming::encode15113_1(c4, c4, 3U);
+	for (uint32_t i = 0U; i < 45U; i++)
+		bit[i] = ((c4[i / 15U] >> (14U - (i % 15U))) & 0x01U) == 0x01U;
+	bit += 45U;
 
 	// c7
 	for (uint32_t i = 0U; i < 7U; i++)
@@ -1353,7 +1346,7 @@ void YSF::get_ambe()
 #if !defined(Q_OS_IOS)
 	uint8_t ambe[7];
 
-	if(m_ambedev->get_ambe(ambe)){
+	if(m_ambedev->get_ambe(ambe, m_ambech)){
 		for(int i = 0; i < 7; ++i){
 			m_txcodecq.append(ambe[i]);
 		}
@@ -1404,9 +1397,9 @@ void YSF::process_rx_data()
 		}
 		if(m_hwrx){
 #if !defined(Q_OS_IOS)
-			m_ambedev->decode(ambe);
+			m_ambedev->decode(ambe, m_ambech);
 
-			if(m_ambedev->get_audio(pcm)){
+			if(m_ambedev->get_audio(pcm, m_ambech)){
 				m_audio->write(pcm, 160);
 				emit update_output_level(m_audio->level());
 			}